@@ -0,0 +1,120 @@
+#include "arena.h"
+
+/**
+ * round size up to alignment
+*/
+static inline size_t arena_align(size_t sz)
+{
+    return (sz + ARENA_ALIGNMENT - 1) & ~((size_t)ARENA_ALIGNMENT - 1);
+}
+
+/**
+ * payload address of a block
+ *
+ * header size is aligned so payload keeps the alignment of malloc
+*/
+static inline byte* arena_block_payload(arena_block* b)
+{
+    return (byte*)b + arena_align(sizeof(arena_block));
+}
+
+static arena_block* new_arena_block(size_t capacity)
+{
+    arena_block* b = (arena_block*)malloc_assert(arena_align(sizeof(arena_block)) + capacity);
+
+    b->capacity = capacity;
+    b->used = 0;
+    b->next = NULL;
+
+    return b;
+}
+
+/**
+ * init arena
+ *
+ * no memory is allocated until first arena_alloc
+*/
+void init_arena(arena* a, size_t block_size)
+{
+    a->first = NULL;
+    a->current = NULL;
+    a->block_size = block_size > 0 ? arena_align(block_size) : ARENA_BLOCK_SIZE;
+}
+
+/**
+ * free all blocks
+*/
+void release_arena(arena* a)
+{
+    arena_block* b = a->first;
+    arena_block* next;
+
+    while (b)
+    {
+        next = b->next;
+        free(b);
+        b = next;
+    }
+
+    a->first = NULL;
+    a->current = NULL;
+}
+
+/**
+ * invalidate all allocations in O(1)
+ *
+ * blocks after first one are marked as used lazily when allocation
+ * moves onto them
+*/
+void arena_reset(arena* a)
+{
+    a->current = a->first;
+
+    if (a->current)
+    {
+        a->current->used = 0;
+    }
+}
+
+/**
+ * allocate sz bytes, memory is NOT zeroed
+*/
+void* arena_alloc(arena* a, size_t sz)
+{
+    arena_block* b = a->current;
+    arena_block* n;
+    void* p;
+
+    sz = arena_align(sz);
+
+    // walk onto next block, or chain a new one
+    if (!b || b->capacity - b->used < sz)
+    {
+        n = b ? b->next : a->first;
+
+        if (!n || n->capacity < sz)
+        {
+            n = new_arena_block(max(a->block_size, sz));
+
+            if (b)
+            {
+                n->next = b->next;
+                b->next = n;
+            }
+            else
+            {
+                n->next = a->first;
+                a->first = n;
+            }
+        }
+
+        n->used = 0;
+        a->current = n;
+        b = n;
+    }
+
+    p = arena_block_payload(b) + b->used;
+    b->used += sz;
+
+    return p;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#ifndef __COMPILER_ARENA_H__
+#define __COMPILER_ARENA_H__
+
+#include "types.h"
+
+/**
+ * default block size (in bytes)
+*/
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+/**
+ * alignment of every allocation (in bytes)
+*/
+#define ARENA_ALIGNMENT 16
+
+/**
+ * allocate one object of given type from arena
+*/
+#define ARENA_ALLOCATE(a, type, name) type* name = (type*)arena_alloc(a, sizeof(type))
+
+/**
+ * Arena Block
+ *
+ * header of a chunk of memory, payload follows the header directly
+*/
+typedef struct _arena_block
+{
+    /* payload capacity (in bytes) */
+    size_t capacity;
+    /* payload used (in bytes) */
+    size_t used;
+    /* next block in chain */
+    struct _arena_block* next;
+} arena_block;
+
+/**
+ * Bump Allocator
+ *
+ * memory is handed out by bumping an offset within current block,
+ * and individual allocations are never freed; instead, the whole
+ * arena is reset at once
+ *
+ * reset keeps all blocks in chain so next round reuses them without
+ * touching heap again; blocks are only freed by release_arena
+*/
+typedef struct
+{
+    /* first block in chain */
+    arena_block* first;
+    /* block allocation happens on */
+    arena_block* current;
+    /* minimum payload size of new block */
+    size_t block_size;
+} arena;
+
+void init_arena(arena* a, size_t block_size);
+void release_arena(arena* a);
+void arena_reset(arena* a);
+void* arena_alloc(arena* a, size_t sz);
+
+#endif
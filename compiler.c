@@ -1,4 +1,5 @@
 #include "compiler.h"
+#include "utils.h"
 
 // JEL_* translation
 static const char* error_level_map[] = {
@@ -22,39 +23,84 @@ static const char* error_scope_map[] = {
 };
 
 /**
- * Full initialization of compiler instance
+ * Initialize source-file-independent context
  *
  * initialization order matters here!
 */
-bool init_compiler(compiler* compiler)
+static void init_compiler_context(compiler* compiler)
 {
-    compiler->version = 1;
-
-    // static data: init only once
-    init_symbol_table(&compiler->rw_lookup_table);
-    init_expression(&compiler->expression);
-
     // high-priority instance
     init_error_logger(&compiler->logger);
+    init_arena(&compiler->ast_arena, 0);
+    init_flat_tree(&compiler->ast);
+    init_token_stream(&compiler->tokens);
+    init_intern_table(&compiler->names);
 
     // compiler framework
     init_file_buffer(&compiler->reader, &compiler->logger);
     init_lexer(
         &compiler->lexer,
         &compiler->reader,
-        &compiler->rw_lookup_table,
+        &compiler->names,
         &compiler->logger
     );
+    lexer_set_scan_mode(&compiler->lexer, compiler->scan_mode);
     init_parser(
         &compiler->context,
         &compiler->lexer,
-        &compiler->rw_lookup_table,
-        &compiler->expression,
+        compiler->rw_lookup_table,
+        compiler->expression,
+        &compiler->ast_arena,
         &compiler->logger
     );
-    init_ir(&compiler->ir, &compiler->expression, &compiler->logger);
-    init_optimization_context(&compiler->optimizers, &compiler->ir);
+    parser_trigger_memo_reset(&compiler->context, compiler->memo_triggers);
+    init_ir(&compiler->ir, compiler->expression, &compiler->names, &compiler->logger);
+    init_optimization_context(&compiler->optimizers, &compiler->ir, compiler->num_optimizer_threads);
+}
+
+/**
+ * Full initialization of compiler instance
+*/
+bool init_compiler(compiler* compiler)
+{
+    compiler->version = 1;
+    compiler->is_worker = false;
+    compiler->num_optimizer_threads = 1;
+    compiler->pretokenize = false;
+    compiler->memo_triggers = false;
+    compiler->scan_mode = LEXER_SCAN_AUTO;
+    compiler->source_file_name = NULL;
+
+    // static data: init only once
+    compiler->rw_lookup_table = (hash_table*)malloc_assert(sizeof(hash_table));
+    compiler->expression = (java_expression*)malloc_assert(sizeof(java_expression));
+    init_symbol_table(compiler->rw_lookup_table);
+    init_expression(compiler->expression);
 
+    init_compiler_context(compiler);
+    return true;
+}
+
+/**
+ * Initialization of worker instance
+ *
+ * worker borrows static data from master, which must outlive
+ * the worker; everything else is owned by worker itself
+*/
+bool init_compiler_worker(compiler* worker, const compiler* master)
+{
+    worker->version = master->version;
+    worker->is_worker = true;
+    worker->num_optimizer_threads = master->num_optimizer_threads;
+    worker->pretokenize = master->pretokenize;
+    worker->memo_triggers = master->memo_triggers;
+    worker->scan_mode = master->scan_mode;
+    worker->source_file_name = NULL;
+
+    worker->rw_lookup_table = master->rw_lookup_table;
+    worker->expression = master->expression;
+
+    init_compiler_context(worker);
     return true;
 }
 
@@ -64,12 +110,22 @@ bool init_compiler(compiler* compiler)
 void release_compiler(compiler* compiler)
 {
     release_file_buffer(&compiler->reader);
-    release_symbol_table(&compiler->rw_lookup_table);
-    release_expression(&compiler->expression);
+
+    if (!compiler->is_worker)
+    {
+        release_symbol_table(compiler->rw_lookup_table);
+        release_expression(compiler->expression);
+        free(compiler->rw_lookup_table);
+        free(compiler->expression);
+    }
+
     release_error_logger(&compiler->logger);
     release_parser(&compiler->context);
+    release_token_stream(&compiler->tokens);
+    release_arena(&compiler->ast_arena);
     release_ir(&compiler->ir);
     release_optimization_context(&compiler->optimizers);
+    release_intern_table(&compiler->names);
 }
 
 /**
@@ -83,6 +139,10 @@ void detask_compiler(compiler* compiler)
     release_parser(&compiler->context);
     release_ir(&compiler->ir);
     release_optimization_context(&compiler->optimizers);
+
+    // AST is gone with parser, so drop all nodes at once
+    init_flat_tree(&compiler->ast);
+    arena_reset(&compiler->ast_arena);
 }
 
 /**
@@ -98,18 +158,21 @@ bool retask_compiler(compiler* compiler, char* source_path)
     init_lexer(
         &compiler->lexer,
         &compiler->reader,
-        &compiler->rw_lookup_table,
+        &compiler->names,
         &compiler->logger
     );
+    lexer_set_scan_mode(&compiler->lexer, compiler->scan_mode);
     init_parser(
         &compiler->context,
         &compiler->lexer,
-        &compiler->rw_lookup_table,
-        &compiler->expression,
+        compiler->rw_lookup_table,
+        compiler->expression,
+        &compiler->ast_arena,
         &compiler->logger
     );
-    init_ir(&compiler->ir, &compiler->expression, &compiler->logger);
-    init_optimization_context(&compiler->optimizers, &compiler->ir);
+    parser_trigger_memo_reset(&compiler->context, compiler->memo_triggers);
+    init_ir(&compiler->ir, compiler->expression, &compiler->names, &compiler->logger);
+    init_optimization_context(&compiler->optimizers, &compiler->ir, compiler->num_optimizer_threads);
 
     /**
      * load file last
@@ -134,6 +197,12 @@ bool compile(compiler* compiler, architecture* arch, char* source_path, compiler
     // parse (mandatory for future steps)
     if (stages & COMPILER_STAGE_PARSE)
     {
+        // a buffer too large for token stream falls back to on-demand lexing
+        if (compiler->pretokenize && lexer_tokenize(&compiler->lexer, &compiler->tokens))
+        {
+            parser_attach_token_stream(&compiler->context, &compiler->tokens);
+        }
+
         parse(&compiler->context);
 
         // check error from parser
@@ -150,7 +219,8 @@ bool compile(compiler* compiler, architecture* arch, char* source_path, compiler
     // contextualize (mandatory for future steps)
     if (stages & COMPILER_STAGE_CONTEXT)
     {
-        contextualize(&compiler->ir, arch, compiler->context.ast_root);
+        flat_tree_build(&compiler->ast, &compiler->ast_arena, compiler->context.ast_root);
+        contextualize(&compiler->ir, arch, flat_tree_root(&compiler->ast));
 
         // check error from contextualizer
         if (!error_logger_if_main_stack_no_error(&compiler->logger))
@@ -190,14 +260,47 @@ bool compile(compiler* compiler, architecture* arch, char* source_path, compiler
 }
 
 /**
- * Print error stack
+ * append formatted text to a growing string buffer
+*/
+static void error_text_append(char** text, size_t* len, size_t* size, const char* format, ...)
+{
+    va_list args;
+    int n;
+
+    va_start(args, format);
+    n = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+
+    if (n <= 0)
+    {
+        return;
+    }
+
+    if (*len + n + 1 > *size)
+    {
+        *size = find_next_pow2_size(*len + n + 1);
+        *text = (char*)realloc_assert(*text, *size);
+    }
+
+    va_start(args, format);
+    vsnprintf(*text + *len, *size - *len, format, args);
+    va_end(args);
+
+    *len += n;
+}
+
+/**
+ * Format error stack
+ *
+ * returns a string that needs to be freed by caller, or NULL
+ * if there is no error
  *
  * TODO: format?
  * MSVC: <file path>(<ln>,<col>): <error level> <error code>: <error message>
  * GCC: <file name>:<ln>:<col>: <error level>: <error message> <snap shot>
  * JAVA: <file name>:<ln> <error level>: <error message> <snap shot>
 */
-void compiler_error_format_print(compiler* compiler)
+char* compiler_error_format(compiler* compiler)
 {
     // <error level> <error code>: 
     static char* msg_header_plain = "%s %s%04d: ";
@@ -210,6 +313,9 @@ void compiler_error_format_print(compiler* compiler)
     java_error_entry* cur = logger->main_stream.first;
     java_error_id id;
     error_type def, level, scope;
+    char* text = NULL;
+    size_t len = 0;
+    size_t size = 0;
 
     while (cur)
     {
@@ -225,7 +331,7 @@ void compiler_error_format_print(compiler* compiler)
             case JES_RUNTIME:
                 // internal or runtime errors are too premature so 
                 // file info will not be displayed by default
-                fprintf(stderr, msg_header_plain,
+                error_text_append(&text, &len, &size, msg_header_plain,
                     error_level_map[JEL_TO_INDEX(level)],
                     error_scope_map[scope],
                     id
@@ -235,7 +341,7 @@ void compiler_error_format_print(compiler* compiler)
             case JES_SYNTAX:
             case JES_CONTEXT:
                 // only parsing phase requires line info
-                fprintf(stderr, msg_header_full,
+                error_text_append(&text, &len, &size, msg_header_full,
                     compiler->source_file_name,
                     cur->begin.ln,
                     cur->begin.col,
@@ -246,7 +352,7 @@ void compiler_error_format_print(compiler* compiler)
                 break;
             default:
                 // otherwise we show everything except line info
-                fprintf(stderr, msg_header_no_line_info,
+                error_text_append(&text, &len, &size, msg_header_no_line_info,
                     compiler->source_file_name,
                     error_level_map[JEL_TO_INDEX(level)],
                     error_scope_map[scope],
@@ -255,14 +361,30 @@ void compiler_error_format_print(compiler* compiler)
                 break;
         }
 
-        // now print message
-        fprintf(stderr, cur->msg ? cur->msg : logger->def[id].message);
+        // now print message, which is already formatted by logger
+        error_text_append(&text, &len, &size, "%s", cur->msg ? cur->msg : logger->def[id].message);
 
         /**
          * TODO: print snapshot content for parsing errors
         */
-        fprintf(stderr, "\n");
+        error_text_append(&text, &len, &size, "\n");
 
         cur = cur->next;
     }
+
+    return text;
+}
+
+/**
+ * Print error stack
+*/
+void compiler_error_format_print(compiler* compiler)
+{
+    char* text = compiler_error_format(compiler);
+
+    if (text)
+    {
+        fputs(text, stderr);
+        free(text);
+    }
 }
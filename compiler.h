@@ -3,8 +3,10 @@
 #define __COMPILER_H__
 
 #include "architecture.h"
+#include "arena.h"
 #include "file.h"
 #include "hash-table.h"
+#include "intern.h"
 #include "parser.h"
 #include "expression.h"
 #include "ir.h"
@@ -13,17 +15,38 @@
 #include "optimizer.h"
 #include "optimization-context.h"
 
+/**
+ * Compiler Instance
+ *
+ * static data (reserved words, expression data) is read-only once
+ * initialized, so a worker instance can borrow it from a master
+ * instance and compile on its own thread
+*/
 typedef struct _compiler
 {
     unsigned int version;
+    /* worker flag: static data is owned by master instance */
+    bool is_worker;
+    /* number of threads used by optimizer, 1 for serial */
+    size_t num_optimizer_threads;
+    /* tokenize whole file before parsing */
+    bool pretokenize;
+    /* memoize parser trigger results */
+    bool memo_triggers;
+    /* lexer scanning kernels */
+    lexer_scan_mode scan_mode;
 
     char* source_file_name;
     file_buffer reader;
-    hash_table rw_lookup_table;
-    java_expression expression;
+    hash_table* rw_lookup_table;
+    java_expression* expression;
     java_error_definition err_def;
+    intern_table names;
     java_lexer lexer;
+    java_token_stream tokens;
+    arena ast_arena;
     java_parser context;
+    flat_tree ast;
     java_ir ir;
     optimization_context optimizers;
     java_error_logger logger;
@@ -42,12 +65,14 @@ typedef enum
 } compiler_stage;
 
 bool init_compiler(compiler* compiler);
+bool init_compiler_worker(compiler* worker, const compiler* master);
 void release_compiler(compiler* compiler);
 
 void detask_compiler(compiler* compiler);
 bool retask_compiler(compiler* compiler, char* source_path);
 
 bool compile(compiler* compiler, architecture* arch, char* source_path, compiler_stage stages);
+char* compiler_error_format(compiler* compiler);
 void compiler_error_format_print(compiler* compiler);
 
 #endif
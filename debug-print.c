@@ -1521,22 +1521,17 @@ void debug_print_definition_pool(definition_pool* pool, size_t depth)
 
 void debug_print_name_definition_table(hash_table* table, size_t depth)
 {
-    for (size_t i = 0; i < table->bucket_size; i++)
-    {
-        hash_pair* p = table->bucket[i];
-
-        while (p)
-        {
-            debug_print_indentation(depth);
+    hash_table_iterator it;
 
-            // key
-            printf("[%p] %s: ", p->value, (char*)(p->key));
+    for (hash_pair* p = hash_table_first(table, &it); p != NULL; p = hash_table_next(table, &it))
+    {
+        debug_print_indentation(depth);
 
-            // print all definitions of this name
-            debug_print_definition(p->value, depth);
+        // key
+        printf("[%p] %s: ", p->value, (char*)(p->key));
 
-            p = p->next;
-        }
+        // print all definitions of this name
+        debug_print_definition(p->value, depth);
     }
 }
 
@@ -1585,24 +1580,19 @@ void debug_print_error_stack(java_error_stack* stack, size_t depth)
 void debug_print_index_set(index_set* ixs)
 {
     size_t cnt = 0;
+    index_set_iterator it;
 
     printf("{");
 
-    for (size_t i = 0; i < ixs->n_cell; i++)
+    for (index_set_iterator_init(&it, ixs); !index_set_iterator_end(&it); index_set_iterator_next(&it))
     {
-        size_t s = 0;
-
-        for (INDEX_CELL_TYPE j = INDEX_CELL_MASK_IDX0; j != 0; j >>= 1, s++)
-        {
-            if (ixs->data[i] & j)
-            {
-                if (cnt > 0) { printf(", "); }
-                printf("%zd", i * INDEX_CELL_BITS + s);
-                cnt++;
-            }
-        }
+        if (cnt > 0) { printf(", "); }
+        printf("%zd", index_set_iterator_get(&it));
+        cnt++;
     }
 
+    index_set_iterator_release(&it);
+
     printf("}");
 }
 
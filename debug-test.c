@@ -1,3 +1,5 @@
+#include <time.h>
+
 #include "debug.h"
 
 typedef struct
@@ -14,6 +16,23 @@ typedef struct
     index_set* frontier;
 } dominance_data;
 
+/**
+ * character class macros before java_char_class, kept as reference
+*/
+#define legacy_isidfirstchar(c) (isalpha(c) || (c) == '_' || (c) == '$')
+#define legacy_isidchar(c) (isalnum(c) || (c) == '_' || (c) == '$')
+#define legacy_ishspacechar(c) ((c) == ' ' || (c) == '\t' || (c) == '\f')
+#define legacy_isvspacechar(c) ((c) == '\r' || (c) == '\n')
+
+static const char* test_char_class_sample =
+    "public class Main {\r\n"
+    "    private static final int MAX_COUNT = 0x7FFF;\n"
+    "\tpublic static void main(String[] args) throws Exception {\n"
+    "        for (int i = 0; i < MAX_COUNT; i++) { $tmp_1 += i * 31 >>> 2; }\n"
+    "        // done\n"
+    "    }\n"
+    "}\n";
+
 static const debug_number_data test_numbers[] = {
     { "0x123456789abcdef", JT_NUM_HEX },
     { "0X123456789ABCDEF", JT_NUM_HEX },
@@ -223,7 +242,7 @@ static debug_test_case_run_dominance(cfg_worker* worker, size_t case_number)
     release_cfg_worker(worker, &g, NULL);
 
     d.postorder = cfg_node_order(&g, DFS_POSTORDER);
-    d.idom = cfg_idom(&g, d.postorder);
+    d.idom = cfg_idom(&g);
     d.dom = cfg_dominators(&g, d.idom);
     d.frontier = cfg_dominance_frontiers(&g, d.idom);
 
@@ -366,3 +385,117 @@ void debug_test_dominance()
     // Test
     debug_test_case_run_dominance(&worker, 3);
 }
+
+static double debug_test_clock()
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * character class table vs legacy macros
+ *
+ * first checks every ASCII byte agrees with the legacy macros in C
+ * locale, then times top-level token classification as done in
+ * lexer_next_token and consume_spaces over a source-like buffer
+*/
+void debug_test_char_class()
+{
+    const size_t sample_len = strlen(test_char_class_sample);
+    const size_t len = 1 << 20;
+    const size_t rounds = 64;
+    byte* buf = (byte*)malloc_assert(len);
+    size_t mismatch = 0;
+    size_t cnt[4];
+    double t;
+    double t_legacy;
+    double t_table;
+
+    printf("\n===== CHARACTER CLASS TEST =====\n");
+
+    for (int c = 0; c < 128; c++)
+    {
+        if (!!legacy_isidfirstchar(c) != isidfirstchar(c) ||
+            !!legacy_isidchar(c) != isidchar(c) ||
+            !!isdigit(c) != isdecchar(c) ||
+            !!isxdigit(c) != ishexchar(c) ||
+            !!legacy_ishspacechar(c) != ishspacechar(c) ||
+            !!legacy_isvspacechar(c) != isvspacechar(c))
+        {
+            printf("mismatch: 0x%02X\n", c);
+            mismatch++;
+        }
+    }
+
+    printf("%zd mismatch(es)\n", mismatch);
+
+    for (size_t i = 0; i < len; i++)
+    {
+        buf[i] = (byte)test_char_class_sample[i % sample_len];
+    }
+
+    // category: 0 id, 1 digit, 2 space, 3 other
+    memset(cnt, 0, sizeof(cnt));
+    t = debug_test_clock();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            byte c = buf[i];
+
+            if (legacy_isidfirstchar(c))
+            {
+                cnt[0]++;
+            }
+            else if (isdigit(c))
+            {
+                cnt[1]++;
+            }
+            else if (legacy_ishspacechar(c) || legacy_isvspacechar(c))
+            {
+                cnt[2]++;
+            }
+            else
+            {
+                cnt[3]++;
+            }
+        }
+    }
+    t_legacy = debug_test_clock() - t;
+    printf("legacy: %zd %zd %zd %zd, %.3f s\n", cnt[0], cnt[1], cnt[2], cnt[3], t_legacy);
+
+    memset(cnt, 0, sizeof(cnt));
+    t = debug_test_clock();
+    for (size_t r = 0; r < rounds; r++)
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            byte cls = char_class(buf[i]);
+
+            if (cls & JCC_ID_START)
+            {
+                cnt[0]++;
+            }
+            else if (cls & JCC_DIGIT)
+            {
+                cnt[1]++;
+            }
+            else if (cls & (JCC_HSPACE | JCC_VSPACE))
+            {
+                cnt[2]++;
+            }
+            else
+            {
+                cnt[3]++;
+            }
+        }
+    }
+    t_table = debug_test_clock() - t;
+    printf("table: %zd %zd %zd %zd, %.3f s\n", cnt[0], cnt[1], cnt[2], cnt[3], t_table);
+
+    printf("speedup: %.2fx\n", t_table > 0 ? t_legacy / t_table : 0.0);
+
+    free(buf);
+}
@@ -36,9 +36,9 @@ void debug_report(compiler* compiler)
     printf("Language version: %d\n", compiler->version);
     printf("Reserved word:\n");
     printf("    count: %d\n", num_java_reserved_words);
-    printf("    memory: %zd bytes\n", hash_table_memory_size(&compiler->rw_lookup_table));
-    printf("    load factor: %.2f%%\n", hash_table_load_factor(&compiler->rw_lookup_table) * 100.0f);
-    printf("    longest chain: %zd\n", hash_table_longest_chain_length(&compiler->rw_lookup_table));
+    printf("    memory: %zd bytes\n", hash_table_memory_size(compiler->rw_lookup_table));
+    printf("    load factor: %.2f%%\n", hash_table_load_factor(compiler->rw_lookup_table) * 100.0f);
+    printf("    longest chain: %zd\n", hash_table_longest_chain_length(compiler->rw_lookup_table));
     printf("Expression static data size: %zd bytes\n",
         sizeof(java_expression) +
         sizeof(java_operator) * OPID_MAX +
@@ -58,6 +58,7 @@ void debug_report(compiler* compiler)
 void debug_file_buffer(file_buffer* reader)
 {
     printf("===== FILE BUFFER =====\n");
+    printf("mode: %s\n", reader->mode == FILE_BUFFER_MAP ? "map" : "read");
     printf("size: %ld byte(s)\n", reader->size);
     printf("buffer: 0x%p\n", (void*)(reader->base));
     printf("cur: 0x%p", (void*)(reader->cur));
@@ -97,14 +98,14 @@ void debug_symbol_table(hash_table* table)
     debug_shash_table(table);
 }
 
-void debug_tokenize(file_buffer* buffer, hash_table* table, java_error_logger* logger)
+void debug_tokenize(file_buffer* buffer, intern_table* names, java_error_logger* logger)
 {
     printf("===== TOKENIZED BUFFER CONTENT =====\n");
 
     java_token* token = (java_token*)malloc_assert(sizeof(java_token));
     java_lexer lexer;
 
-    init_lexer(&lexer, buffer, table, logger);
+    init_lexer(&lexer, buffer, names, logger);
 
     while (true)
     {
@@ -213,6 +214,18 @@ void debug_ast(java_parser* parser)
     __debug_ast(parser, parser->ast_root, 0);
 }
 
+void debug_parser_trigger_memo(java_parser* parser)
+{
+    parser_trigger_memo* memo = &parser->trigger_memo;
+    size_t total = memo->num_hit + memo->num_miss;
+
+    printf("\n===== PARSER TRIGGER MEMO =====\n");
+    printf("enabled: %s\n", memo->enabled ? "true" : "false");
+    printf("hit: %zd\n", memo->num_hit);
+    printf("miss: %zd\n", memo->num_miss);
+    printf("hit rate: %.2f%%\n", total > 0 ? memo->num_hit * 100.0f / total : 0.0f);
+}
+
 /**
  * NOTE: do NOT delete this one as it is useful for bucket size calculation
 */
@@ -268,6 +281,7 @@ void debug_java_symbol_lookup_table_no_collision_test(bool use_prime_size)
 void debug_global_import(java_ir* ir)
 {
     hash_table* table = &ir->tbl_import;
+    hash_table_iterator it;
 
     printf("\n===== IMPORTS =====\n");
     printf("count: %zd\n", table->num_pairs);
@@ -275,21 +289,14 @@ void debug_global_import(java_ir* ir)
     printf("load factor: %.2f%%\n", hash_table_load_factor(table) * 100.0f);
     printf("longest chain: %zd\n", hash_table_longest_chain_length(table));
 
-    for (size_t i = 0; i < ir->tbl_import.bucket_size; i++)
+    for (hash_pair* p = hash_table_first(table, &it); p != NULL; p = hash_table_next(table, &it))
     {
-        hash_pair* p = ir->tbl_import.bucket[i];
-
-        while (p)
-        {
-            // key
-            printf("    %s: %s%s\n",
-                (char*)(p->key),
-                p->value ? "FROM " : "(ON-DEMAND)",
-                p->value ? ((global_import*)p->value)->package_name : ""
-            );
-
-            p = p->next;
-        }
+        // key
+        printf("    %s: %s%s\n",
+            (char*)(p->key),
+            p->value ? "FROM " : "(ON-DEMAND)",
+            p->value ? ((global_import*)p->value)->package_name : ""
+        );
     }
 }
 
@@ -297,6 +304,7 @@ void debug_ir_global_names(java_ir* ir)
 {
     hash_table* table = lookup_global_scope(ir);
     global_top_level* top;
+    hash_table_iterator it;
 
     printf("\n===== GLOBAL NAMES =====\n");
     printf("count: %zd\n", table->num_pairs);
@@ -304,66 +312,63 @@ void debug_ir_global_names(java_ir* ir)
     printf("load factor: %.2f%%\n", hash_table_load_factor(table) * 100.0f);
     printf("longest chain: %zd\n", hash_table_longest_chain_length(table));
 
-    for (size_t i = 0; i < table->bucket_size; i++)
+    for (hash_pair* p = hash_table_first(table, &it); p != NULL; p = hash_table_next(table, &it))
     {
-        for (hash_pair* p = table->bucket[i]; p != NULL; p = p->next)
+        printf("    %s: ", (char*)(p->key));
+
+        top = p->value;
+
+        // ill-formed
+        if (!top)
         {
-            printf("    %s: ", (char*)(p->key));
+            printf("(null)\n");
+            continue;
+        }
 
-            top = p->value;
+        switch (top->type)
+        {
+            case TOP_LEVEL_CLASS:
+                printf("Access: ");
+                debug_print_modifier_bit_flag(top->modifier);
 
-            // ill-formed
-            if (!top)
-            {
-                printf("(null)\n");
-                continue;
-            }
+                if (top->extend)
+                {
+                    printf(" extends %s", top->extend);
+                }
 
-            switch (top->type)
-            {
-                case TOP_LEVEL_CLASS:
-                    printf("Access: ");
-                    debug_print_modifier_bit_flag(top->modifier);
+                if (top->implement)
+                {
+                    printf(" implements: ");
 
-                    if (top->extend)
+                    for (size_t j = 0; j < top->num_implement; j++)
                     {
-                        printf(" extends %s", top->extend);
+                        printf("%s%s", top->implement[j], j < top->num_implement - 1 ? ", " : " ");
                     }
+                }
 
-                    if (top->implement)
-                    {
-                        printf(" implements: ");
+                printf("\n");
 
-                        for (size_t j = 0; j < top->num_implement; j++)
-                        {
-                            printf("%s%s", top->implement[j], j < top->num_implement - 1 ? ", " : " ");
-                        }
-                    }
+                printf("*       Member Variable Initialization:\n");
+                debug_print_definition_pool(&top->member_init_variables, 3);
+                debug_print_cfg(top->code_member_init, 3);
+                printf("\n");
 
-                    printf("\n");
-
-                    printf("*       Member Variable Initialization:\n");
-                    debug_print_definition_pool(&top->member_init_variables, 3);
-                    debug_print_cfg(top->code_member_init, 3);
-                    printf("\n");
-
-                    printf("*       Member: %zd member(s)\n", top->tbl_member.num_pairs);
-                    debug_print_name_definition_table(&top->tbl_member, 3);
-                    printf("\n");
-
-                    printf("*       Literals: %zd literal(s)\n", top->tbl_literal.num_pairs);
-                    debug_print_name_definition_table(&top->tbl_literal, 3);
-                    printf("\n");
-
-                    break;
-                case TOP_LEVEL_INTERFACE:
-                    /**
-                     * TODO:
-                    */
-                    break;
-                default:
-                    break;
-            }
+                printf("*       Member: %zd member(s)\n", top->tbl_member.num_pairs);
+                debug_print_name_definition_table(&top->tbl_member, 3);
+                printf("\n");
+
+                printf("*       Literals: %zd literal(s)\n", top->tbl_literal.num_pairs);
+                debug_print_name_definition_table(&top->tbl_literal, 3);
+                printf("\n");
+
+                break;
+            case TOP_LEVEL_INTERFACE:
+                /**
+                 * TODO:
+                */
+                break;
+            default:
+                break;
         }
     }
 }
@@ -372,27 +377,32 @@ void debug_ir_lookup(java_ir* ir)
 {
     printf("\n===== LOOKUP STACK =====\n");
 
-    scope_frame* lh = ir->scope_stack_top;
+    scope_table* table = &ir->scope;
+    scope_entry* e;
+    size_t end = table->num_entries;
 
-    if (!lh)
+    if (!table->num_marks)
     {
         printf("(lookup stack is empty)\n");
         return;
     }
 
-    while (lh)
+    // innermost scope first
+    for (size_t i = table->num_marks; i > 0; i--)
     {
         printf(">>>>>>>>>>\n");
+        printf("entries: %zd\n", end - table->marks[i - 1]);
 
-        hash_table* table = lh->table;
-
-        printf("memory: %zd bytes\n", hash_table_memory_size(table));
-        printf("load factor: %.2f%%\n", hash_table_load_factor(table) * 100.0f);
-        printf("longest chain: %zd\n", hash_table_longest_chain_length(table));
+        for (size_t j = table->marks[i - 1]; j < end; j++)
+        {
+            e = &table->entries[j];
 
-        debug_print_name_definition_table(table, 1);
+            debug_print_indentation(1);
+            printf("[%p] %s: ", e->desc, e->name);
+            debug_print_definition(e->desc, 1);
+        }
 
-        lh = lh->next;
+        end = table->marks[i - 1];
     }
 }
 
@@ -408,6 +418,16 @@ void debug_error_logger(java_error_logger* logger)
     }
 }
 
+static void debug_print_dataflow_stats(const char* name, const dataflow_stats* stats)
+{
+    printf("%s Dataflow: %zd visits, %zd changes, %zd passes\n",
+        name,
+        stats->num_visits,
+        stats->num_changes,
+        stats->num_passes
+    );
+}
+
 void debug_optimization_context(optimization_context* oc)
 {
     printf("\n===== OPTIMIZATION CONTEXT =====\n");
@@ -427,6 +447,19 @@ void debug_optimization_context(optimization_context* oc)
                 code->om.profile.num_var_on_stack
             );
 
+            printf("SSA PHI Placed: %zd\n", code->om.ssa_stats.num_phi_placed);
+            if (OPTIMIZER_SSA_STATS)
+            {
+                printf("SSA PHI Avoided: %zd\n", code->om.ssa_stats.num_phi_avoided);
+            }
+            else
+            {
+                printf("SSA PHI Avoided: not counted, build with OPTIMIZER_SSA_STATS=1\n");
+            }
+
+            debug_print_dataflow_stats("SSA Liveness", &code->om.ssa_stats.liveness);
+            debug_print_dataflow_stats("Liveness", &code->om.liveness_stats);
+
             printf("Variable Allocation Info:\n");
             for (size_t k = 0; k < code->om.profile.num_variables; k++)
             {
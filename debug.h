@@ -44,15 +44,18 @@ void debug_report(compiler* compiler);
 void debug_reserved_words();
 void debug_file_buffer(file_buffer* reader);
 void debug_symbol_table(hash_table* table);
-void debug_tokenize(file_buffer* buffer, hash_table* table, java_error_logger* logger);
+void debug_tokenize(file_buffer* buffer, intern_table* names, java_error_logger* logger);
 void debug_ast(java_parser* parser);
+void debug_parser_trigger_memo(java_parser* parser);
 void debug_java_symbol_lookup_table_no_collision_test(bool use_prime_size);
 void debug_global_import(java_ir* ir);
 void debug_ir_global_names(java_ir* ir);
+void debug_ir_lookup(java_ir* ir);
 void debug_error_logger(java_error_logger* logger);
 void debug_optimization_context(optimization_context* oc);
 
 void debug_test_number_library();
 void debug_test_dominance();
+void debug_test_char_class();
 
 #endif
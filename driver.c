@@ -0,0 +1,734 @@
+#include "driver.h"
+#include "debug.h"
+
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#define DRIVER_PATH_SEPARATOR "\\"
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#define DRIVER_PATH_SEPARATOR "/"
+#endif
+
+#define DRIVER_NAME "jllc"
+#define DRIVER_DEFAULT_EXTENSION ".java"
+#define DRIVER_RESPONSE_FILE_MAX_DEPTH 8
+
+/**
+ * shared state of a parallel batch
+*/
+typedef struct
+{
+    driver* drv;
+    const compiler* master;
+    char** sources;
+    size_t num_sources;
+    driver_file_stat* stats;
+    /* next source to compile, shared by all workers */
+    volatile size_t next;
+} driver_batch;
+
+typedef enum
+{
+    DRIVER_PATH_NONE,
+    DRIVER_PATH_FILE,
+    DRIVER_PATH_DIRECTORY,
+} driver_path_type;
+
+static bool driver_handle_argument(driver* drv, string_list* paths, char* arg, size_t depth);
+
+/**
+ * wall clock in seconds
+*/
+static double driver_clock()
+{
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static driver_path_type driver_get_path_type(const char* path)
+{
+#if defined(_WIN32)
+    DWORD attr = GetFileAttributesA(path);
+
+    if (attr == INVALID_FILE_ATTRIBUTES)
+    {
+        return DRIVER_PATH_NONE;
+    }
+
+    return (attr & FILE_ATTRIBUTE_DIRECTORY) ? DRIVER_PATH_DIRECTORY : DRIVER_PATH_FILE;
+#else
+    struct stat st;
+
+    if (stat(path, &st) != 0)
+    {
+        return DRIVER_PATH_NONE;
+    }
+
+    if (S_ISDIR(st.st_mode))
+    {
+        return DRIVER_PATH_DIRECTORY;
+    }
+
+    return S_ISREG(st.st_mode) ? DRIVER_PATH_FILE : DRIVER_PATH_NONE;
+#endif
+}
+
+static char* driver_path_join(const char* dir, const char* name)
+{
+    size_t len_dir = strlen(dir);
+    size_t len_name = strlen(name);
+    char* path = (char*)malloc_assert(sizeof(char) * (len_dir + len_name + 2));
+
+    strcpy(path, dir);
+
+    // avoid doubled separator if directory already ends with one
+    if (len_dir == 0 || (dir[len_dir - 1] != '/' && dir[len_dir - 1] != '\\'))
+    {
+        strcat(path, DRIVER_PATH_SEPARATOR);
+    }
+
+    strcat(path, name);
+    return path;
+}
+
+/**
+ * extension test for directory scan
+ *
+ * empty filter accepts everything
+*/
+static bool driver_extension_match(const driver* drv, const char* name)
+{
+    if (!drv->extension)
+    {
+        return true;
+    }
+
+    size_t len_name = strlen(name);
+    size_t len_ext = strlen(drv->extension);
+
+    return len_name > len_ext && strcmp(name + len_name - len_ext, drv->extension) == 0;
+}
+
+static int driver_compare_string(const void* a, const void* b)
+{
+    return strcmp(*(const char**)a, *(const char**)b);
+}
+
+/**
+ * scan directory recursively
+ *
+ * entries are sorted by name so batch order does not depend
+ * on file system enumeration order
+*/
+static bool driver_add_directory(driver* drv, const char* path)
+{
+    string_list entries;
+    char** names;
+    size_t num_names;
+    bool ret = true;
+
+    init_string_list(&entries);
+
+#if defined(_WIN32)
+    WIN32_FIND_DATAA data;
+    char* pattern = driver_path_join(path, "*");
+    HANDLE h = FindFirstFileA(pattern, &data);
+
+    free(pattern);
+
+    if (h == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "%s: cannot open directory '%s'\n", DRIVER_NAME, path);
+        return false;
+    }
+
+    do
+    {
+        if (strcmp(data.cFileName, ".") != 0 && strcmp(data.cFileName, "..") != 0)
+        {
+            string_list_append(&entries, data.cFileName, true);
+        }
+    } while (FindNextFileA(h, &data));
+
+    FindClose(h);
+#else
+    struct dirent* e;
+    DIR* dir = opendir(path);
+
+    if (!dir)
+    {
+        fprintf(stderr, "%s: cannot open directory '%s'\n", DRIVER_NAME, path);
+        return false;
+    }
+
+    while ((e = readdir(dir)) != NULL)
+    {
+        if (strcmp(e->d_name, ".") != 0 && strcmp(e->d_name, "..") != 0)
+        {
+            string_list_append(&entries, e->d_name, true);
+        }
+    }
+
+    closedir(dir);
+#endif
+
+    num_names = entries.count;
+
+    if (num_names == 0)
+    {
+        return true;
+    }
+
+    names = string_list_to_string_array(&entries);
+    release_string_list(&entries);
+    qsort(names, num_names, sizeof(char*), driver_compare_string);
+
+    for (size_t i = 0; i < num_names; i++)
+    {
+        char* child = driver_path_join(path, names[i]);
+
+        switch (driver_get_path_type(child))
+        {
+            case DRIVER_PATH_DIRECTORY:
+                ret = driver_add_directory(drv, child) && ret;
+                free(child);
+                break;
+            case DRIVER_PATH_FILE:
+                if (driver_extension_match(drv, names[i]))
+                {
+                    // list takes the ownership
+                    string_list_append(&drv->sources, child, false);
+                }
+                else
+                {
+                    free(child);
+                }
+                break;
+            default:
+                free(child);
+                break;
+        }
+
+        free(names[i]);
+    }
+
+    free(names);
+    return ret;
+}
+
+/**
+ * read response file, every line is an argument
+*/
+static bool driver_add_response_file(driver* drv, string_list* paths, const char* path, size_t depth)
+{
+    FILE* fp;
+    char* content;
+    char* line;
+    char* end;
+    long size;
+    bool ret = true;
+
+    if (depth > DRIVER_RESPONSE_FILE_MAX_DEPTH)
+    {
+        fprintf(stderr, "%s: response file '%s' is nested too deep\n", DRIVER_NAME, path);
+        return false;
+    }
+
+    fp = fopen(path, "rb");
+
+    if (!fp)
+    {
+        fprintf(stderr, "%s: cannot open response file '%s'\n", DRIVER_NAME, path);
+        return false;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    content = (char*)malloc_assert(sizeof(char) * (size + 1));
+    size = (long)fread(content, 1, size, fp);
+    content[size] = '\0';
+    fclose(fp);
+
+    for (line = content; *line != '\0'; line = end)
+    {
+        // find line boundary, and terminate the line in-place
+        for (end = line; *end != '\0' && *end != '\r' && *end != '\n'; end++);
+
+        if (*end != '\0')
+        {
+            *end++ = '\0';
+        }
+
+        // trim
+        while (*line == ' ' || *line == '\t')
+        {
+            line++;
+        }
+
+        for (char* p = line + strlen(line); p > line && (p[-1] == ' ' || p[-1] == '\t'); p--)
+        {
+            p[-1] = '\0';
+        }
+
+        if (*line != '\0' && *line != '#')
+        {
+            ret = driver_handle_argument(drv, paths, line, depth) && ret;
+        }
+    }
+
+    free(content);
+    return ret;
+}
+
+/**
+ * option: --stage=<name>
+ *
+ * stages are cumulative, the named stage is the last one to run
+*/
+static bool driver_set_stage(driver* drv, const char* name)
+{
+    static const char* names[] = { "parse", "context", "optimize", "emit" };
+    compiler_stage stages = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(names); i++)
+    {
+        stages |= (compiler_stage)(1 << i);
+
+        if (strcmp(name, names[i]) == 0)
+        {
+            drv->stages = stages;
+            return true;
+        }
+    }
+
+    fprintf(stderr, "%s: unknown stage '%s'\n", DRIVER_NAME, name);
+    return false;
+}
+
+/**
+ * option: --scan=<name>
+ *
+ * mode not supported by CPU silently falls back to a lower one
+*/
+static bool driver_set_scan(driver* drv, const char* name)
+{
+    static const lexer_scan_mode modes[] = { LEXER_SCAN_AUTO, LEXER_SCAN_SCALAR, LEXER_SCAN_SSE2, LEXER_SCAN_AVX2 };
+
+    for (size_t i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        if (strcmp(name, lexer_scan_mode_name(modes[i])) == 0)
+        {
+            drv->scan_mode = modes[i];
+            return true;
+        }
+    }
+
+    fprintf(stderr, "%s: unknown scan mode '%s'\n", DRIVER_NAME, name);
+    return false;
+}
+
+/**
+ * option value: non-negative integer
+*/
+static bool driver_set_number(size_t* dest, const char* n)
+{
+    char* end;
+    size_t v = (size_t)strtoul(n, &end, 10);
+
+    if (*n == '\0' || *end != '\0')
+    {
+        fprintf(stderr, "%s: invalid number '%s'\n", DRIVER_NAME, n);
+        return false;
+    }
+
+    *dest = v;
+    return true;
+}
+
+/**
+ * handle one argument
+ *
+ * source paths are only collected here, because options may
+ * come after them (e.g. --ext affects directory scan)
+*/
+static bool driver_handle_argument(driver* drv, string_list* paths, char* arg, size_t depth)
+{
+    if (arg[0] == '@')
+    {
+        return driver_add_response_file(drv, paths, arg + 1, depth + 1);
+    }
+
+    if (arg[0] != '-')
+    {
+        string_list_append(paths, arg, true);
+        return true;
+    }
+
+    if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0)
+    {
+        drv->help = true;
+    }
+    else if (strcmp(arg, "--debug") == 0)
+    {
+        drv->debug = true;
+    }
+    else if (strcmp(arg, "--quiet") == 0)
+    {
+        drv->quiet = true;
+    }
+    else if (strncmp(arg, "--stage=", 8) == 0)
+    {
+        return driver_set_stage(drv, arg + 8);
+    }
+    else if (strcmp(arg, "--arch=32") == 0)
+    {
+        drv->arch.bits = ARCH_32_BIT;
+    }
+    else if (strcmp(arg, "--arch=64") == 0)
+    {
+        drv->arch.bits = ARCH_64_BIT;
+    }
+    else if (strcmp(arg, "-j") == 0)
+    {
+        drv->num_jobs = 0;
+    }
+    else if (strncmp(arg, "-j", 2) == 0)
+    {
+        return driver_set_number(&drv->num_jobs, arg + 2);
+    }
+    else if (strncmp(arg, "--jobs=", 7) == 0)
+    {
+        return driver_set_number(&drv->num_jobs, arg + 7);
+    }
+    else if (strncmp(arg, "--opt-jobs=", 11) == 0)
+    {
+        return driver_set_number(&drv->num_optimizer_jobs, arg + 11);
+    }
+    else if (strcmp(arg, "--pretokenize") == 0)
+    {
+        drv->pretokenize = true;
+    }
+    else if (strcmp(arg, "--memo-triggers") == 0)
+    {
+        drv->memo_triggers = true;
+    }
+    else if (strncmp(arg, "--scan=", 7) == 0)
+    {
+        return driver_set_scan(drv, arg + 7);
+    }
+    else if (strncmp(arg, "--ext=", 6) == 0)
+    {
+        free(drv->extension);
+        drv->extension = strmcpy_assert(arg + 6);
+    }
+    else
+    {
+        fprintf(stderr, "%s: unknown option '%s'\n", DRIVER_NAME, arg);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * report of one file: errors first, then statistics
+*/
+static void driver_report_file(const driver* drv, const driver_file_stat* stat, size_t idx, const char* path)
+{
+    if (stat->errors)
+    {
+        fputs(stat->errors, stderr);
+    }
+
+    if (drv->quiet)
+    {
+        return;
+    }
+
+    printf("[%zd/%zd] %s: %ld bytes, %.3f ms, %.2f MB/s%s\n",
+        idx + 1,
+        drv->sources.count,
+        path,
+        stat->size,
+        stat->time * 1000.0,
+        stat->time > 0 ? stat->size / stat->time / (1024.0 * 1024.0) : 0.0,
+        stat->success ? "" : " (failed)"
+    );
+}
+
+/**
+ * serial batch: one compiler instance, retasked for every file
+*/
+static void driver_run_serial(driver* drv, compiler* compiler, driver_file_stat* stats)
+{
+    size_t idx = 0;
+
+    for (string_list_item* item = drv->sources.first; item != NULL; item = item->next, idx++)
+    {
+        driver_file_stat* stat = &stats[idx];
+        double t = driver_clock();
+
+        stat->success = compile(compiler, &drv->arch, item->s, drv->stages);
+        stat->time = driver_clock() - t;
+        stat->size = compiler->reader.size;
+        stat->errors = NULL;
+
+        if (drv->debug)
+        {
+            printf("\nFile %zd: %s\n", idx + 1, item->s);
+            debug_parser_trigger_memo(&compiler->context);
+
+            if (stat->success)
+            {
+                debug_global_import(&compiler->ir);
+                debug_ir_global_names(&compiler->ir);
+                debug_ir_lookup(&compiler->ir);
+            }
+
+            debug_optimization_context(&compiler->optimizers);
+            debug_error_logger(&compiler->logger);
+        }
+
+        compiler_error_format_print(compiler);
+        driver_report_file(drv, stat, idx, item->s);
+    }
+}
+
+/**
+ * worker thread: pull next source until queue is drained
+*/
+static void driver_worker(void* arg)
+{
+    driver_batch* batch = (driver_batch*)arg;
+    compiler worker;
+    size_t idx;
+
+    init_compiler_worker(&worker, batch->master);
+
+    while ((idx = atomic_size_fetch_add(&batch->next, 1)) < batch->num_sources)
+    {
+        driver_file_stat* stat = &batch->stats[idx];
+        double t = driver_clock();
+
+        stat->success = compile(&worker, &batch->drv->arch, batch->sources[idx], batch->drv->stages);
+        stat->time = driver_clock() - t;
+        stat->size = worker.reader.size;
+        stat->errors = compiler_error_format(&worker);
+    }
+
+    release_compiler(&worker);
+}
+
+/**
+ * parallel batch: every thread owns a worker compiler
+ *
+ * reports are printed in source order after all threads finish
+*/
+static void driver_run_parallel(driver* drv, compiler* master, driver_file_stat* stats, size_t num_workers)
+{
+    driver_batch batch;
+    thread_handle* workers = (thread_handle*)malloc_assert(sizeof(thread_handle) * num_workers);
+    size_t num_started = 0;
+    size_t idx = 0;
+
+    batch.drv = drv;
+    batch.master = master;
+    batch.num_sources = drv->sources.count;
+    batch.sources = (char**)malloc_assert(sizeof(char*) * batch.num_sources);
+    batch.stats = stats;
+    batch.next = 0;
+
+    for (string_list_item* item = drv->sources.first; item != NULL; item = item->next)
+    {
+        batch.sources[idx++] = item->s;
+    }
+
+    for (size_t i = 0; i < num_workers; i++)
+    {
+        if (thread_start(&workers[num_started], driver_worker, &batch))
+        {
+            num_started++;
+        }
+    }
+
+    // started workers will drain the queue anyway, and if
+    // nothing could start, do the job on current thread
+    if (num_started == 0)
+    {
+        driver_worker(&batch);
+    }
+
+    for (size_t i = 0; i < num_started; i++)
+    {
+        thread_join(&workers[i]);
+    }
+
+    for (size_t i = 0; i < batch.num_sources; i++)
+    {
+        driver_report_file(drv, &stats[i], i, batch.sources[i]);
+        free(stats[i].errors);
+    }
+
+    free(batch.sources);
+    free(workers);
+}
+
+void init_driver(driver* drv)
+{
+    init_string_list(&drv->sources);
+
+    drv->arch.bits = ARCH_64_BIT;
+    drv->stages = COMPILER_STAGE_PARSE | COMPILER_STAGE_CONTEXT | COMPILER_STAGE_OPTIMIZE | COMPILER_STAGE_EMIT;
+    drv->num_jobs = 1;
+    drv->num_optimizer_jobs = 1;
+    drv->pretokenize = false;
+    drv->memo_triggers = false;
+    drv->scan_mode = LEXER_SCAN_AUTO;
+    drv->extension = strmcpy_assert(DRIVER_DEFAULT_EXTENSION);
+    drv->debug = false;
+    drv->quiet = false;
+    drv->help = false;
+}
+
+void release_driver(driver* drv)
+{
+    release_string_list(&drv->sources);
+    free(drv->extension);
+}
+
+/**
+ * Parse command line
+ *
+ * argv[0] is skipped, returns false if any of the arguments is invalid
+*/
+bool driver_parse_arguments(driver* drv, int argc, char* argv[])
+{
+    string_list paths;
+    bool ret = true;
+
+    init_string_list(&paths);
+
+    for (int i = 1; i < argc; i++)
+    {
+        ret = driver_handle_argument(drv, &paths, argv[i], 0) && ret;
+    }
+
+    // all options are settled, now expand sources
+    for (string_list_item* item = paths.first; item != NULL; item = item->next)
+    {
+        ret = driver_add_source(drv, item->s) && ret;
+    }
+
+    release_string_list(&paths);
+    return ret;
+}
+
+/**
+ * Add source path: a file or a directory
+ *
+ * a file specified explicitly is always accepted, extension filter
+ * only applies to directory scan
+*/
+bool driver_add_source(driver* drv, const char* path)
+{
+    switch (driver_get_path_type(path))
+    {
+        case DRIVER_PATH_FILE:
+            string_list_append(&drv->sources, (char*)path, true);
+            return true;
+        case DRIVER_PATH_DIRECTORY:
+            return driver_add_directory(drv, path);
+        default:
+            fprintf(stderr, "%s: cannot find source '%s'\n", DRIVER_NAME, path);
+            return false;
+    }
+}
+
+/**
+ * Compile all sources as one batch
+ *
+ * debug info is printed while compiling, so it forces serial mode
+ *
+ * returns number of failed files
+*/
+size_t driver_run(driver* drv)
+{
+    compiler compiler;
+    driver_file_stat* stats;
+    size_t num_failed = 0;
+    size_t total_size = 0;
+    size_t num_jobs = drv->num_jobs ? drv->num_jobs : thread_hardware_concurrency();
+    double time_begin = driver_clock();
+    double time_total;
+
+    num_jobs = min(num_jobs, drv->sources.count);
+    stats = (driver_file_stat*)malloc_assert(sizeof(driver_file_stat) * max(drv->sources.count, 1));
+
+    // this is heavy, initialize once and retask
+    // compiler for every input file
+    init_compiler(&compiler);
+    compiler.num_optimizer_threads = drv->num_optimizer_jobs ? drv->num_optimizer_jobs : thread_hardware_concurrency();
+    compiler.pretokenize = drv->pretokenize;
+    compiler.memo_triggers = drv->memo_triggers;
+    compiler.scan_mode = drv->scan_mode;
+
+    if (drv->debug)
+    {
+        debug_report(&compiler);
+    }
+
+    if (num_jobs > 1 && !drv->debug)
+    {
+        driver_run_parallel(drv, &compiler, stats, num_jobs);
+    }
+    else
+    {
+        driver_run_serial(drv, &compiler, stats);
+    }
+
+    release_compiler(&compiler);
+    time_total = driver_clock() - time_begin;
+
+    for (size_t i = 0; i < drv->sources.count; i++)
+    {
+        total_size += stats[i].size;
+        num_failed += stats[i].success ? 0 : 1;
+    }
+
+    printf("%zd file(s), %zd failed, %zd bytes, %.3f s, %.1f files/s, %.2f MB/s\n",
+        drv->sources.count,
+        num_failed,
+        total_size,
+        time_total,
+        time_total > 0 ? drv->sources.count / time_total : 0.0,
+        time_total > 0 ? total_size / time_total / (1024.0 * 1024.0) : 0.0
+    );
+
+    free(stats);
+    return num_failed;
+}
+
+void driver_print_usage(const char* program)
+{
+    printf("Usage: %s [options] <source|directory|@response-file>...\n", program);
+    printf("Options:\n");
+    printf("    --stage=<parse|context|optimize|emit>  last stage to run (default: emit)\n");
+    printf("    --arch=<32|64>                          target bit length (default: 64)\n");
+    printf("    -j<N>, --jobs=<N>                       compile with N threads, 0 or -j for all processors (default: 1)\n");
+    printf("    --opt-jobs=<N>                          optimize methods of a file with N threads, 0 for all processors (default: 1)\n");
+    printf("    --pretokenize                           tokenize whole file before parsing\n");
+    printf("    --memo-triggers                         memoize parser trigger results\n");
+    printf("    --scan=<auto|scalar|sse2|avx2>          lexer scanning kernels (default: auto)\n");
+    printf("    --ext=<extension>                       directory scan filter, empty for all (default: %s)\n", DRIVER_DEFAULT_EXTENSION);
+    printf("    --debug                                 print debug info for every file\n");
+    printf("    --quiet                                 suppress per-file report\n");
+    printf("    -h, --help                              print this message\n");
+    printf("Response file contains one argument per line, '#' starts a comment line.\n");
+}
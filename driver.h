@@ -0,0 +1,82 @@
+#pragma once
+#ifndef __COMPILER_DRIVER_H__
+#define __COMPILER_DRIVER_H__
+
+#include "types.h"
+#include "architecture.h"
+#include "compiler.h"
+#include "string-list.h"
+#include "thread.h"
+
+/**
+ * Per-file compilation statistics
+*/
+typedef struct
+{
+    /* file size (in bytes) */
+    long size;
+    /* wall time (in seconds) */
+    double time;
+    /* compilation result */
+    bool success;
+    /* formatted error messages, parallel mode only */
+    char* errors;
+} driver_file_stat;
+
+/**
+ * Compiler Driver
+ *
+ * driver collects source files from command line, then compiles
+ * all of them as one batch using one compiler instance, so static
+ * data (reserved words, expression data, error definitions) is
+ * initialized only once
+ *
+ * sources can be specified as:
+ * 1. path of a file
+ * 2. path of a directory, which is scanned recursively for files
+ *    matching the extension filter
+ * 3. @path of a response file, which contains one argument per line;
+ *    empty lines and lines starting with '#' are ignored
+ *
+ * in parallel mode every thread owns a worker compiler instance that
+ * borrows static data from one master instance; per-file reports are
+ * collected and printed in source order once all threads finish, so
+ * output does not depend on scheduling
+*/
+typedef struct
+{
+    /* source file paths, in compilation order */
+    string_list sources;
+    /* target architecture */
+    architecture arch;
+    /* compiler stages */
+    compiler_stage stages;
+    /* number of threads, 0 for all processors */
+    size_t num_jobs;
+    /* number of optimizer threads per file, 0 for all processors */
+    size_t num_optimizer_jobs;
+    /* tokenize whole file before parsing */
+    bool pretokenize;
+    /* memoize parser trigger results */
+    bool memo_triggers;
+    /* lexer scanning kernels */
+    lexer_scan_mode scan_mode;
+    /* extension filter for directory scan */
+    char* extension;
+    /* print debug info for every file */
+    bool debug;
+    /* suppress per-file report */
+    bool quiet;
+    /* print usage and exit */
+    bool help;
+} driver;
+
+void init_driver(driver* drv);
+void release_driver(driver* drv);
+
+bool driver_parse_arguments(driver* drv, int argc, char* argv[]);
+bool driver_add_source(driver* drv, const char* path);
+size_t driver_run(driver* drv);
+void driver_print_usage(const char* program);
+
+#endif
@@ -269,9 +269,9 @@ void release_expression(java_expression* expression)
 /**
  * map OPID to AST node
 */
-tree_node* expr_opid2node(const operator_id opid)
+tree_node* expr_opid2node(arena* a, const operator_id opid)
 {
-    tree_node* node = ast_node_new(JNT_EXPRESSION);
+    tree_node* node = ast_node_new(a, JNT_EXPRESSION);
     node->data.expression->op = opid;
 
     return node;
@@ -465,7 +465,6 @@ static bool expression_worker_evaluate(java_expression_worker* worker, tree_node
             collapse_ternary = true;
             top_opid = expression_worker_top_operator(worker);
             operand_count = expr_opid_operand_count(worker->definition, top_opid);
-            tree_node_delete(top_op);
         }
 
         /**
@@ -582,27 +581,11 @@ void init_expression_worker(java_expression_worker* worker, java_expression* def
 */
 void release_expression_worker(java_expression_worker* worker)
 {
-    tree_node* n;
+    // release operator stack, nodes are owned by arena
+    while (expression_worker_pop_operator(worker));
 
-    // release operator stack
-    while (true)
-    {
-        n = expression_worker_pop_operator(worker);
-
-        if (!n) { break; }
-
-        tree_node_delete(n);
-    }
-
-    // release operand stack
-    while (true)
-    {
-        n = expression_worker_pop_operand(worker);
-
-        if (!n) { break; }
-
-        tree_node_delete(n);
-    }
+    // release operand stack, nodes are owned by arena
+    while (expression_worker_pop_operand(worker));
 
     // worker->definition is a reference so no need to free
 }
@@ -228,7 +228,7 @@ typedef struct
 void init_expression(java_expression* expression);
 void release_expression(java_expression* expression);
 
-tree_node* expr_opid2node(const operator_id opid);
+tree_node* expr_opid2node(arena* a, const operator_id opid);
 java_operator expr_opid2def(const java_expression* expression, operator_id opid);
 operator_id expr_tid2opid(const java_expression* expression, java_lexeme_type tid);
 irop expr_opid2irop(const java_expression* expression, operator_id opid);
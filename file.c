@@ -1,8 +1,21 @@
 #include "file.h"
 
+#include <limits.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 void init_file_buffer(file_buffer* buffer, java_error_logger* error_logger)
 {
+    buffer->mode = FILE_BUFFER_MAP;
     buffer->size = 0;
+    buffer->map_size = 0;
     buffer->base = NULL;
     buffer->cur = NULL;
     buffer->limit = NULL;
@@ -11,7 +24,132 @@ void init_file_buffer(file_buffer* buffer, java_error_logger* error_logger)
 
 void release_file_buffer(file_buffer* buffer)
 {
-    free(buffer->base);
+    if (buffer->mode != FILE_BUFFER_MAP)
+    {
+        free(buffer->base);
+    }
+    else if (buffer->base)
+    {
+#if defined(_WIN32)
+        UnmapViewOfFile(buffer->base);
+#else
+        munmap(buffer->base, buffer->map_size);
+#endif
+    }
+
+    buffer->base = NULL;
+    buffer->map_size = 0;
+}
+
+/**
+ * map source file into memory (read-only)
+ *
+ * content must be followed by a 0x00 byte, because lexer relies on
+ * it to detect EOF; pages are zero-filled beyond end of file, so:
+ *
+ * POSIX: reserve one more page than the file needs, then map the
+ * file on top of it; the tail is either zero-filled remainder of
+ * the last file page, or the reserved zero page
+ * Windows: view cannot be padded, so if file size is a multiple of
+ * page size there is no tail, and mapping is rejected
+ *
+ * returns false if mapping is not possible, no error will be logged
+ * and caller is expected to fall back to read mode
+*/
+static bool map_source_file(file_buffer* buffer, const char* name)
+{
+    size_t size;
+    size_t page;
+    byte* base;
+
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+    LARGE_INTEGER file_size;
+    SYSTEM_INFO info;
+
+    file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    GetSystemInfo(&info);
+    page = info.dwPageSize;
+
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0 ||
+        file_size.QuadPart > LONG_MAX || file_size.QuadPart % page == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    size = (size_t)file_size.QuadPart;
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    // view keeps mapping alive, so handles can be closed right away
+    base = (byte*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    CloseHandle(file);
+
+    if (!base)
+    {
+        return false;
+    }
+
+    buffer->map_size = size;
+#else
+    struct stat st;
+    int fd = open(name, O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    if (fstat(fd, &st) != 0 || st.st_size <= 0 || st.st_size > LONG_MAX)
+    {
+        close(fd);
+        return false;
+    }
+
+    size = (size_t)st.st_size;
+    page = (size_t)sysconf(_SC_PAGESIZE);
+    buffer->map_size = (size / page + 1) * page;
+
+    // reserve zero pages, then put file content on top
+    base = (byte*)mmap(NULL, buffer->map_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (base == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    if (mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        munmap(base, buffer->map_size);
+        close(fd);
+        return false;
+    }
+
+    // lexer reads forward only
+    madvise(base, size, MADV_SEQUENTIAL);
+    close(fd);
+#endif
+
+    buffer->size = (long)size;
+    buffer->base = base;
+
+    return true;
 }
 
 bool load_source_file(file_buffer* buffer, const char* name)
@@ -23,6 +161,19 @@ bool load_source_file(file_buffer* buffer, const char* name)
         return false;
     }
 
+    // zero-copy if possible
+    if (buffer->mode == FILE_BUFFER_MAP)
+    {
+        if (map_source_file(buffer, name))
+        {
+            buffer->cur = buffer->base;
+            buffer->limit = buffer->base + buffer->size;
+            return true;
+        }
+
+        buffer->mode = FILE_BUFFER_READ;
+    }
+
     FILE* fp = fopen(name, "rb");
 
     if (!fp)
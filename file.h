@@ -5,18 +5,39 @@
 #include "types.h"
 #include "error.h"
 
+/**
+ * File buffer loading mode
+*/
+typedef enum
+{
+    /* read file content into a heap copy */
+    FILE_BUFFER_READ,
+    /* map file content into memory, no copy */
+    FILE_BUFFER_MAP,
+} file_buffer_mode;
+
 /**
  * Java source file buffer
  *
  * file buffer reader will read file content into memory
  * in binary format
  *
+ * in map mode the file is mapped read-only and the content is
+ * guaranteed to be followed by at least one 0x00 byte, so token
+ * data can point straight into the mapping; if mapping is not
+ * possible, loader falls back to read mode and "mode" reflects
+ * the actual mode after loading
+ *
  * error logger is external reference, no release required
 */
 typedef struct _file_buffer
 {
+    /* loading mode */
+    file_buffer_mode mode;
     /* file size (in bytes) */
     long size;
+    /* size of the mapped region (in bytes), map mode only */
+    size_t map_size;
     /* file content buffer */
     byte* base;
     /* buffer boundary */
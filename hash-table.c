@@ -10,15 +10,152 @@ void init_hash_table(hash_table* table, size_t data_size)
     data_size = data_size > 0 ? data_size : HASH_TABLE_DEFAULT_BUCKET_SIZE;
 
     table->bucket = (hash_pair**)malloc_assert(sizeof(hash_pair*) * data_size);
+    table->ctrl = NULL;
+    table->slots = NULL;
     table->bucket_size = data_size;
+    table->order = NULL;
+    table->size_order = 0;
     reset_hash_table(table);
 }
 
+/**
+ * control byte of a hash: top 7 bits
+*/
+static inline byte hash_ctrl_of(hash h)
+{
+    return (byte)(h >> (sizeof(hash) * 8 - 7));
+}
+
+/**
+ * flat layout: smallest power-of-2 size holding n pairs
+*/
+static size_t flat_size_for(size_t n)
+{
+    size_t size = HASH_TABLE_FLAT_MIN_SIZE;
+
+    while (n >= HASH_TABLE_FLAT_THRESHOLD * size)
+    {
+        size *= 2;
+    }
+
+    return size;
+}
+
+/**
+ * flat layout: allocate empty store
+ *
+ * order vector is not touched
+*/
+static void flat_alloc(hash_table* table, size_t size)
+{
+    table->bucket = NULL;
+    table->ctrl = (byte*)malloc_assert(sizeof(byte) * size);
+    table->slots = (hash_pair*)malloc_assert(sizeof(hash_pair) * size);
+    table->bucket_size = size;
+    table->num_filled = 0;
+    table->num_pairs = 0;
+    memset(table->ctrl, HASH_CTRL_EMPTY, sizeof(byte) * size);
+}
+
+/**
+ * Initialize hash table in flat layout with estimated input data size
+ *
+ * unlike init_hash_table, data_size is number of pairs, table is
+ * sized so that they fit without growing
+*/
+void init_flat_hash_table(hash_table* table, size_t data_size)
+{
+    table->order = NULL;
+    table->num_order = 0;
+    table->size_order = 0;
+    flat_alloc(table, flat_size_for(data_size));
+}
+
+/**
+ * keep insertion order for iteration
+ *
+ * must be called on an empty table, right after init
+*/
+void hash_table_keep_order(hash_table* table)
+{
+    table->size_order = max(table->size_order, HASH_TABLE_DEFAULT_BUCKET_SIZE);
+    table->order = (hash_pair**)realloc_assert(table->order, sizeof(hash_pair*) * table->size_order);
+    table->num_order = 0;
+}
+
+/**
+ * order vector: append a newly inserted pair
+ *
+ * holes left by removal are squeezed out before growing
+*/
+static void order_push(hash_table* table, hash_pair* pair)
+{
+    size_t n = 0;
+
+    if (table->num_order >= table->size_order)
+    {
+        if (table->num_pairs - 1 < table->num_order)
+        {
+            for (size_t i = 0; i < table->num_order; i++)
+            {
+                if (table->order[i])
+                {
+                    table->order[n++] = table->order[i];
+                }
+            }
+
+            table->num_order = n;
+        }
+
+        if (table->num_order >= table->size_order)
+        {
+            table->size_order *= 2;
+            table->order = (hash_pair**)realloc_assert(table->order, sizeof(hash_pair*) * table->size_order);
+        }
+    }
+
+    table->order[table->num_order++] = pair;
+}
+
+/**
+ * order vector: leave a hole for a removed pair
+ *
+ * NOTE: linear search, removal is rare for ordered tables
+*/
+static void order_erase(hash_table* table, hash_pair* pair)
+{
+    for (size_t i = 0; i < table->num_order; i++)
+    {
+        if (table->order[i] == pair)
+        {
+            table->order[i] = NULL;
+            return;
+        }
+    }
+}
+
 /**
  * release hash table
 */
 void release_hash_table(hash_table* table, pair_data_deleter deleter)
 {
+    // flat layout: pairs are inline
+    if (table->ctrl)
+    {
+        for (size_t i = 0; deleter && i < table->bucket_size; i++)
+        {
+            if (hash_ctrl_is_full(table->ctrl[i]))
+            {
+                (*deleter)(table->slots[i].key, table->slots[i].value);
+            }
+        }
+
+        free(table->ctrl);
+        free(table->slots);
+        free(table->order);
+        return;
+    }
+
     // free every header
     for (int i = 0; i < table->bucket_size; i++)
     {
@@ -40,6 +177,7 @@ void release_hash_table(hash_table* table, pair_data_deleter deleter)
     }
 
     free(table->bucket);
+    free(table->order);
 }
 
 /**
@@ -53,10 +191,81 @@ void reset_hash_table(hash_table* table)
 {
     table->num_filled = 0;
     table->num_pairs = 0;
+    table->num_order = 0;
 
     // this is important because we need to make sure 
     // all bucket header are set to NULL
-    memset(table->bucket, 0, sizeof(hash_pair*) * table->bucket_size);
+    if (table->ctrl)
+    {
+        memset(table->ctrl, HASH_CTRL_EMPTY, sizeof(byte) * table->bucket_size);
+    }
+    else
+    {
+        memset(table->bucket, 0, sizeof(hash_pair*) * table->bucket_size);
+    }
+}
+
+/**
+ * begin iteration, returns first pair or NULL if table is empty
+*/
+hash_pair* hash_table_first(const hash_table* table, hash_table_iterator* it)
+{
+    it->index = 0;
+    it->pair = NULL;
+
+    return hash_table_next(table, it);
+}
+
+/**
+ * next pair in iteration, NULL when all visited
+ *
+ * order is insertion order if kept, otherwise bucket order, then
+ * chain order; table must not be modified during iteration, except
+ * for pair values
+*/
+hash_pair* hash_table_next(const hash_table* table, hash_table_iterator* it)
+{
+    if (table->order)
+    {
+        for (; it->index < table->num_order; it->index++)
+        {
+            if (table->order[it->index])
+            {
+                it->pair = table->order[it->index++];
+                return it->pair;
+            }
+        }
+    }
+    else if (table->ctrl)
+    {
+        for (; it->index < table->bucket_size; it->index++)
+        {
+            if (hash_ctrl_is_full(table->ctrl[it->index]))
+            {
+                it->pair = &table->slots[it->index++];
+                return it->pair;
+            }
+        }
+    }
+    else if (it->pair && it->pair->next)
+    {
+        it->pair = it->pair->next;
+        return it->pair;
+    }
+    else
+    {
+        for (; it->index < table->bucket_size; it->index++)
+        {
+            if (table->bucket[it->index])
+            {
+                it->pair = table->bucket[it->index++];
+                return it->pair;
+            }
+        }
+    }
+
+    it->pair = NULL;
+    return NULL;
 }
 
 /**
@@ -68,6 +277,20 @@ size_t hash_table_longest_chain_length(hash_table* table)
 {
     size_t len = 0;
 
+    // flat layout: longest probe sequence
+    if (table->ctrl)
+    {
+        for (size_t i = 0; i < table->bucket_size; i++)
+        {
+            if (hash_ctrl_is_full(table->ctrl[i]))
+            {
+                len = max(len, ((i - table->slots[i].hash) & (table->bucket_size - 1)) + 1);
+            }
+        }
+
+        return len;
+    }
+
     for (int i = 0; i < table->bucket_size; i++)
     {
         hash_pair* b = table->bucket[i];
@@ -114,7 +337,14 @@ float hash_table_load_factor(hash_table* table)
 */
 size_t hash_table_memory_size(hash_table* table)
 {
-    return sizeof(hash_pair) * table->num_pairs + sizeof(hash_pair*) * table->bucket_size;
+    size_t order = sizeof(hash_pair*) * table->size_order;
+
+    if (table->ctrl)
+    {
+        return (sizeof(hash_pair) + sizeof(byte)) * table->bucket_size + order;
+    }
+
+    return sizeof(hash_pair) * table->num_pairs + sizeof(hash_pair*) * table->bucket_size + order;
 }
 
 /**
@@ -144,6 +374,8 @@ void pair_data_delete_value(void* k, void* v)
 
 /**
  * create a key-value pair
+ *
+ * hash is filled by insert
 */
 hash_pair* new_pair(void* k, void* v, bytes_length len)
 {
@@ -152,6 +384,7 @@ hash_pair* new_pair(void* k, void* v, bytes_length len)
     b->key = k;
     b->value = v;
     b->key_length = len;
+    b->hash = 0;
     b->prev = NULL;
     b->next = NULL;
 
@@ -163,10 +396,239 @@ hash_pair* new_pair(void* k, void* v, bytes_length len)
  *
  * key MUST match length as well as the content
  * otherwise a substring of a key will produce false-positive match result
+ *
+ * same key reference (e.g. interned names) matches without memcmp
 */
 bool hash_pair_key_compare(const hash_pair* pair, const void* key, size_t len)
 {
-    return pair->key_length == len && memcmp(pair->key, key, len) == 0;
+    return pair->key_length == len && (pair->key == key || memcmp(pair->key, key, len) == 0);
+}
+
+/**
+ * flat layout: first free slot on probe sequence of h
+ *
+ * there is always one, as threshold keeps empty slots
+*/
+static size_t flat_probe_free(const hash_table* table, hash h)
+{
+    size_t mask = table->bucket_size - 1;
+    size_t i = h & mask;
+
+    while (hash_ctrl_is_full(table->ctrl[i]))
+    {
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+/**
+ * flat layout: move all pairs into a new store of given size
+ *
+ * cached hashes are used, no key is touched; deleted slots are gone
+*/
+static void flat_rebuild(hash_table* table, size_t size)
+{
+    byte* ctrl = table->ctrl;
+    hash_pair* slots = table->slots;
+    size_t old_size = table->bucket_size;
+    size_t num_order = table->num_order;
+    size_t index;
+    size_t i;
+
+    flat_alloc(table, size);
+
+    // ordered: move in insertion order and repoint order vector,
+    // holes are squeezed out on the way
+    table->num_order = 0;
+
+    for (size_t k = 0; k < (table->order ? num_order : old_size); k++)
+    {
+        if (table->order)
+        {
+            if (!table->order[k])
+            {
+                continue;
+            }
+
+            i = table->order[k] - slots;
+        }
+        else if (hash_ctrl_is_full(ctrl[k]))
+        {
+            i = k;
+        }
+        else
+        {
+            continue;
+        }
+
+        index = flat_probe_free(table, slots[i].hash);
+        table->ctrl[index] = ctrl[i];
+        table->slots[index] = slots[i];
+        table->num_filled++;
+        table->num_pairs++;
+
+        if (table->order)
+        {
+            table->order[table->num_order++] = &table->slots[index];
+        }
+    }
+
+    free(ctrl);
+    free(slots);
+}
+
+/**
+ * flat layout: rehash test
+ *
+ * grows when live pairs need it, otherwise rebuilds at same size to
+ * purge deleted slots
+*/
+static void flat_rehash_test(hash_table* table)
+{
+    if (table->num_filled + 1 < HASH_TABLE_FLAT_THRESHOLD * table->bucket_size)
+    {
+        return;
+    }
+
+    flat_rebuild(table, max(flat_size_for(table->num_pairs + 1), table->bucket_size));
+}
+
+/**
+ * flat layout: insert
+*/
+static void flat_insert(hash_table* table, void* k, bytes_length len, hash h, void* v)
+{
+    flat_rehash_test(table);
+
+    size_t index = flat_probe_free(table, h);
+    hash_pair* slot = &table->slots[index];
+
+    // reusing a deleted slot does not change load
+    if (table->ctrl[index] == HASH_CTRL_EMPTY)
+    {
+        table->num_filled++;
+    }
+
+    table->ctrl[index] = hash_ctrl_of(h);
+    slot->key = k;
+    slot->value = v;
+    slot->key_length = len;
+    slot->hash = h;
+    slot->prev = NULL;
+    slot->next = NULL;
+    table->num_pairs++;
+
+    if (table->order)
+    {
+        order_push(table, slot);
+    }
+}
+
+/**
+ * flat layout: slot index of a key, bucket_size if not found
+*/
+static size_t flat_lookup(const hash_table* table, const void* k, bytes_length len, hash h)
+{
+    size_t mask = table->bucket_size - 1;
+    size_t i = h & mask;
+    byte c = hash_ctrl_of(h);
+
+    // deleted slots do not stop probing
+    while (table->ctrl[i] != HASH_CTRL_EMPTY)
+    {
+        if (table->ctrl[i] == c && table->slots[i].hash == h && hash_pair_key_compare(&table->slots[i], k, len))
+        {
+            return i;
+        }
+
+        i = (i + 1) & mask;
+    }
+
+    return table->bucket_size;
+}
+
+/**
+ * flat layout: detach a slot into a new pair
+*/
+static hash_pair* flat_detach(hash_table* table, size_t index)
+{
+    hash_pair* pair = &table->slots[index];
+    hash_pair* b = new_pair(pair->key, pair->value, pair->key_length);
+
+    b->hash = pair->hash;
+    table->ctrl[index] = HASH_CTRL_DELETED;
+    table->num_pairs--;
+
+    if (table->order)
+    {
+        order_erase(table, pair);
+    }
+
+    return b;
+}
+
+/**
+ * rehash: relink all pairs into a new bucket array
+ *
+ * cached hashes are used, no key is touched and no pair is
+ * allocated; pairs are visited in bucket order and pushed to chain
+ * head, same as re-inserting them one by one
+*/
+static void rehash(hash_table* table, size_t bucket_size)
+{
+    hash_pair** bucket = (hash_pair**)malloc_assert(sizeof(hash_pair*) * bucket_size);
+    hash_pair* b;
+    hash_pair* next;
+    size_t index;
+
+    memset(bucket, 0, sizeof(hash_pair*) * bucket_size);
+    table->num_filled = 0;
+
+    for (size_t i = 0; i < table->bucket_size; i++)
+    {
+        for (b = table->bucket[i]; b != NULL; b = next)
+        {
+            next = b->next;
+            index = b->hash % bucket_size;
+
+            b->prev = NULL;
+            b->next = bucket[index];
+
+            if (bucket[index])
+            {
+                bucket[index]->prev = b;
+            }
+            else
+            {
+                table->num_filled++;
+            }
+
+            bucket[index] = b;
+        }
+    }
+
+    free(table->bucket);
+    table->bucket = bucket;
+    table->bucket_size = bucket_size;
+}
+
+/**
+ * rehash: size needed for n pairs
+ *
+ * follows the doubling sequence of incremental growth, so a reserved
+ * table ends up with the same size as one grown pair by pair
+*/
+static size_t rehash_size_for(const hash_table* table, size_t n)
+{
+    size_t size = table->bucket_size;
+
+    while (n >= HASH_TABLE_REHASH_THRESHOLD * size)
+    {
+        size *= 2;
+    }
+
+    return size;
 }
 
 /**
@@ -187,46 +649,77 @@ static void rehash_test(hash_table* table)
     }
 
     // new table has twice the size
-    hash_table temp_table;
-    init_hash_table(&temp_table, table->bucket_size * 2);
+    rehash(table, table->bucket_size * 2);
+}
 
-    // rehash all entries
-    for (int i = 0; i < table->bucket_size; i++)
+/**
+ * make room for n pairs in total, so that inserting up to n pairs
+ * never grows the table
+*/
+void hash_table_reserve(hash_table* table, size_t n)
+{
+    size_t size;
+
+    if (table->order && n > table->size_order)
     {
-        hash_pair* b = table->bucket[i];
+        table->size_order = n;
+        table->order = (hash_pair**)realloc_assert(table->order, sizeof(hash_pair*) * n);
+    }
 
-        while (b)
+    if (table->ctrl)
+    {
+        size = flat_size_for(n);
+
+        if (size > table->bucket_size)
         {
-            bhash_table_insert(&temp_table, b->key, b->key_length, b->value);
-            b = b->next;
+            flat_rebuild(table, size);
         }
     }
+    else
+    {
+        size = rehash_size_for(table, n);
 
-    // now we override table
-    // but before that we need to release it
-    release_hash_table(table, NULL);
-    memcpy(table, &temp_table, sizeof(hash_table));
-
-    // now detach the shared reference from temp table
-    // no deletion required because this is the only 
-    // memory allocated
-    temp_table.bucket = NULL;
+        if (size > table->bucket_size)
+        {
+            rehash(table, size);
+        }
+    }
 }
 
 /**
  * insert a pair
  *
  * NOTE: insert does not assert duplicated keys, it keeps them all
- * use test function to check for existence
+ * use test function to check for existence; in flat layout, which
+ * one of duplicated keys is found first is unspecified
 */
 void bhash_table_insert(hash_table* table, void* k, bytes_length len, void* v)
 {
+    phash_table_insert(table, k, len, bhash(k, len), v);
+}
+
+/**
+ * insert a pair with pre-computed hash
+ *
+ * h MUST be bhash(k, len), as it is cached in the pair for
+ * lookup and rehash
+*/
+void phash_table_insert(hash_table* table, void* k, bytes_length len, hash h, void* v)
+{
+    if (table->ctrl)
+    {
+        flat_insert(table, k, len, h, v);
+        return;
+    }
+
     // first attempt to resize
     rehash_test(table);
 
-    size_t index = bhash(k, len) % table->bucket_size;
+    size_t index = h % table->bucket_size;
     hash_pair* b = new_pair(k, v, len);
 
+    b->hash = h;
+
     // collision check
     if (table->bucket[index])
     {
@@ -243,6 +736,11 @@ void bhash_table_insert(hash_table* table, void* k, bytes_length len, void* v)
     // insert it
     table->bucket[index] = b;
     table->num_pairs++;
+
+    if (table->order)
+    {
+        order_push(table, b);
+    }
 }
 
 /**
@@ -250,22 +748,14 @@ void bhash_table_insert(hash_table* table, void* k, bytes_length len, void* v)
 */
 bool bhash_table_update(hash_table* table, const void* k, bytes_length len, void* v)
 {
-    size_t index = bhash(k, len) % table->bucket_size;
-    hash_pair* b = table->bucket[index];
+    hash_pair* b = bhash_table_get(table, k, len);
 
-    // lookup with collision check
-    while (b)
+    if (b)
     {
-        if (hash_pair_key_compare(b, k, len))
-        {
-            b->value = v;
-            return true;
-        }
-
-        b = b->next;
+        b->value = v;
     }
 
-    return false;
+    return b != NULL;
 }
 
 /**
@@ -273,21 +763,7 @@ bool bhash_table_update(hash_table* table, const void* k, bytes_length len, void
 */
 bool bhash_table_test(const hash_table* table, const void* k, bytes_length len)
 {
-    size_t index = bhash(k, len) % table->bucket_size;
-    hash_pair* b = table->bucket[index];
-
-    // lookup with collision check
-    while (b)
-    {
-        if (hash_pair_key_compare(b, k, len))
-        {
-            return true;
-        }
-
-        b = b->next;
-    }
-
-    return false;
+    return bhash_table_get(table, k, len) != NULL;
 }
 
 /**
@@ -299,21 +775,9 @@ bool bhash_table_test(const hash_table* table, const void* k, bytes_length len)
 */
 void* bhash_table_find(hash_table* table, const void* k, bytes_length len)
 {
-    size_t index = bhash(k, len) % table->bucket_size;
-    hash_pair* b = table->bucket[index];
-
-    // lookup with collision check
-    while (b)
-    {
-        if (hash_pair_key_compare(b, k, len))
-        {
-            return b->value;
-        }
-
-        b = b->next;
-    }
+    hash_pair* b = bhash_table_get(table, k, len);
 
-    return NULL;
+    return b ? b->value : NULL;
 }
 
 /**
@@ -323,13 +787,28 @@ void* bhash_table_find(hash_table* table, const void* k, bytes_length len)
 */
 hash_pair* bhash_table_get(const hash_table* table, const void* k, bytes_length len)
 {
-    size_t index = bhash(k, len) % table->bucket_size;
+    return phash_table_get(table, k, len, bhash(k, len));
+}
+
+/**
+ * find a pair with pre-computed hash
+*/
+hash_pair* phash_table_get(const hash_table* table, const void* k, bytes_length len, hash h)
+{
+    if (table->ctrl)
+    {
+        size_t i = flat_lookup(table, k, len, h);
+
+        return i < table->bucket_size ? &table->slots[i] : NULL;
+    }
+
+    size_t index = h % table->bucket_size;
     hash_pair* b = table->bucket[index];
 
-    // lookup with collision check
+    // lookup with collision check, cached hash filters most mismatches
     while (b)
     {
-        if (hash_pair_key_compare(b, k, len))
+        if (b->hash == h && hash_pair_key_compare(b, k, len))
         {
             return b;
         }
@@ -342,16 +821,27 @@ hash_pair* bhash_table_get(const hash_table* table, const void* k, bytes_length
 
 /**
  * detach a specific pair from hash table
+ *
+ * returned pair is owned by caller in both layouts
 */
 hash_pair* bhash_table_remove(hash_table* table, const void* k, bytes_length len)
 {
-    size_t index = bhash(k, len) % table->bucket_size;
+    hash h = bhash(k, len);
+
+    if (table->ctrl)
+    {
+        size_t i = flat_lookup(table, k, len, h);
+
+        return i < table->bucket_size ? flat_detach(table, i) : NULL;
+    }
+
+    size_t index = h % table->bucket_size;
     hash_pair* b = table->bucket[index];
 
     // lookup with collision check
     while (b)
     {
-        if (hash_pair_key_compare(b, k, len))
+        if (b->hash == h && hash_pair_key_compare(b, k, len))
         {
             if (!b->prev && !b->next)
             {
@@ -364,6 +854,11 @@ hash_pair* bhash_table_remove(hash_table* table, const void* k, bytes_length len
                 {
                     b->prev->next = b->next;
                 }
+                else
+                {
+                    // chain head
+                    table->bucket[index] = b->next;
+                }
 
                 if (b->next)
                 {
@@ -372,6 +867,12 @@ hash_pair* bhash_table_remove(hash_table* table, const void* k, bytes_length len
             }
 
             table->num_pairs--;
+
+            if (table->order)
+            {
+                order_erase(table, b);
+            }
+
             return b;
         }
 
@@ -388,6 +889,34 @@ hash_pair* bhash_table_pop(hash_table* table)
 {
     hash_pair* b;
 
+    // ordered: first live entry, in insertion order
+    if (table->order)
+    {
+        for (size_t i = 0; i < table->num_order; i++)
+        {
+            if (table->order[i])
+            {
+                b = table->order[i];
+                return bhash_table_remove(table, b->key, b->key_length);
+            }
+        }
+
+        return NULL;
+    }
+
+    if (table->ctrl)
+    {
+        for (size_t index = 0; index < table->bucket_size; index++)
+        {
+            if (hash_ctrl_is_full(table->ctrl[index]))
+            {
+                return flat_detach(table, index);
+            }
+        }
+
+        return NULL;
+    }
+
     for (size_t index = 0; index < table->bucket_size; index++)
     {
         b = table->bucket[index];
@@ -399,6 +928,11 @@ hash_pair* bhash_table_pop(hash_table* table)
                 table->num_filled--;
             }
 
+            else
+            {
+                b->next->prev = NULL;
+            }
+
             table->bucket[index] = b->next;
             table->num_pairs--;
             return b;
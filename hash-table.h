@@ -6,7 +6,24 @@
  * to do extra deletion work during deconstruction
  *
  * Table uses separate chaining approach to resolve hash collision
+ * by default; a table initialized by init_flat_hash_table uses open
+ * addressing instead, with all pairs stored inline in one array, and
+ * works with the same bhash_*, shash_* and phash_* functions
  *
+ * flat layout (Swiss-style): every slot has a control byte, either
+ * empty, deleted, or the top 7 bits of the key hash; probing is
+ * linear and compares control bytes first, so a key is only compared
+ * when 7 hash bits already match; hash of every pair is cached in the
+ * pair so growing never rehashes keys
+ *
+ * NOTE: in flat layout, pairs move when table grows, so a pair
+ * pointer returned by get is only valid until next insert
+ *
+ * use hash_table_first/hash_table_next to iterate either layout;
+ * iteration follows bucket order by default, which depends on table
+ * size and hash seed; a table set up by hash_table_keep_order also
+ * keeps a dense vector of pairs in insertion order, and iterates it
+ * instead, so order is reproducible and empty buckets are skipped
 */
 
 #pragma once
@@ -30,11 +47,36 @@
 */
 #define HASH_TABLE_DEFAULT_BUCKET_SIZE (11)
 
+/**
+ * flat layout load factor threshold
+ *
+ * probing is linear, so it stays below chained threshold to keep
+ * clusters short; deleted slots count as load, as they lengthen probe
+ * sequences as well
+*/
+#define HASH_TABLE_FLAT_THRESHOLD (0.7)
+
+/**
+ * flat layout minimum number of slots, must be power of 2
+*/
+#define HASH_TABLE_FLAT_MIN_SIZE (8)
+
+/**
+ * flat layout control bytes
+ *
+ * a full slot stores top 7 bits of hash, so MSB tells if it is full
+*/
+#define HASH_CTRL_EMPTY (0x80)
+#define HASH_CTRL_DELETED (0xFE)
+#define hash_ctrl_is_full(c) (((c) & 0x80) == 0)
+
 typedef struct _hash_bucket
 {
     void* key;
     void* value;
     bytes_length key_length;
+    /* bhash of key, cached for rehash and fast mismatch */
+    hash hash;
 
     struct _hash_bucket* prev;
     struct _hash_bucket* next;
@@ -42,22 +84,48 @@ typedef struct _hash_bucket
 
 typedef struct
 {
-    /* store */
+    /* store, NULL in flat layout */
     hash_pair** bucket;
-    /* number of buckets */
+    /* flat layout: control byte of every slot, NULL in chained layout */
+    byte* ctrl;
+    /* flat layout: inline store, pair links are not used */
+    hash_pair* slots;
+    /* number of buckets, or slots in flat layout */
     size_t bucket_size;
-    /* number of bucket head occupied */
+    /* number of bucket head occupied, or slots not empty in flat layout */
     size_t num_filled;
     /* number of total inserted elements */
     size_t num_pairs;
+    /* pairs in insertion order, NULL if order is not kept */
+    hash_pair** order;
+    /* used entries of order, removed pairs leave NULL holes */
+    size_t num_order;
+    size_t size_order;
 } hash_table;
 
+/**
+ * iteration cursor, works with both layouts
+*/
+typedef struct
+{
+    /* next bucket, slot or order entry to visit */
+    size_t index;
+    /* last visited pair */
+    hash_pair* pair;
+} hash_table_iterator;
+
 // pair data deleter interface
 typedef void (*pair_data_deleter)(void* key, void* value);
 
 void init_hash_table(hash_table* table, size_t data_size);
+void init_flat_hash_table(hash_table* table, size_t data_size);
 void release_hash_table(hash_table* table, pair_data_deleter deleter);
 void reset_hash_table(hash_table* table);
+void hash_table_keep_order(hash_table* table);
+void hash_table_reserve(hash_table* table, size_t n);
+
+hash_pair* hash_table_first(const hash_table* table, hash_table_iterator* it);
+hash_pair* hash_table_next(const hash_table* table, hash_table_iterator* it);
 
 size_t hash_table_longest_chain_length(hash_table* table);
 size_t hash_table_bucket_head_filled(hash_table* table);
@@ -79,6 +147,9 @@ hash_pair* bhash_table_get(const hash_table* table, const void* k, bytes_length
 hash_pair* bhash_table_remove(hash_table* table, const void* k, bytes_length len);
 hash_pair* bhash_table_pop(hash_table* table);
 
+void phash_table_insert(hash_table* table, void* k, bytes_length len, hash h, void* v);
+hash_pair* phash_table_get(const hash_table* table, const void* k, bytes_length len, hash h);
+
 void shash_table_insert(hash_table* table, char* k, void* v);
 bool shash_table_update(hash_table* table, const char* k, void* v);
 bool shash_table_test(hash_table* table, const char* k);
@@ -57,12 +57,10 @@ static il_byte_stream_add(il_byte_stream* stream, void* data, size_t size)
 void jil_emit(java_ir* ir)
 {
     hash_table* table = lookup_global_scope(ir);
+    hash_table_iterator it;
 
     // every top-level has one JIL
-    for (size_t i = 0; i < table->bucket_size; i++)
+    for (hash_pair* p = hash_table_first(table, &it); p != NULL; p = hash_table_next(table, &it))
     {
-        for (hash_pair* p = table->bucket[i]; p != NULL; p = p->next)
-        {
-        }
     }
 }
@@ -1,4 +1,27 @@
 #include "index-set.h"
+#include "utils.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(INDEX_SET_AVX2)
+#include <immintrin.h>
+#endif
+
+/**
+ * per-function ISA enablement, see lexer-scan.c
+*/
+#if defined(_MSC_VER)
+#define INDEX_SET_TARGET_AVX2
+#else
+#define INDEX_SET_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+/**
+ * cells per AVX2 vector
+*/
+#define INDEX_SET_AVX2_CELLS (32 / sizeof(INDEX_CELL_TYPE))
 
 /**
  * get cell index of given index
@@ -13,7 +36,7 @@ inline static size_t idx2cidx(size_t idx)
 */
 inline static INDEX_CELL_TYPE idx2mask(size_t idx)
 {
-    return INDEX_CELL_MASK_IDX0 >> (idx % INDEX_CELL_BITS);
+    return INDEX_CELL_MASK_IDX0 << (idx % INDEX_CELL_BITS);
 }
 
 /**
@@ -24,6 +47,192 @@ inline static size_t cidx2idx(size_t cell_idx, size_t in_cell_idx)
     return cell_idx * INDEX_CELL_BITS + in_cell_idx;
 }
 
+/**
+ * number of elements in a cell
+ *
+ * MSVC __popcnt needs POPCNT, which is not in x86-64 baseline, so it
+ * falls back to bit slicing
+*/
+inline static size_t cell_popcount(INDEX_CELL_TYPE c)
+{
+#if defined(_MSC_VER)
+    uint64_t v = c;
+
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+
+    return (size_t)((v * 0x0101010101010101ULL) >> 56);
+#elif defined(INDEX_SET_CELL_32)
+    return (size_t)__builtin_popcount(c);
+#else
+    return (size_t)__builtin_popcountll(c);
+#endif
+}
+
+/**
+ * in-cell index of lowest element, cell must not be 0
+*/
+inline static size_t cell_ctz(INDEX_CELL_TYPE c)
+{
+#if defined(_MSC_VER)
+    unsigned long idx;
+
+#if defined(INDEX_SET_CELL_32)
+    _BitScanForward(&idx, c);
+#elif defined(_M_X64)
+    _BitScanForward64(&idx, c);
+#else
+    if (_BitScanForward(&idx, (unsigned long)c))
+    {
+        return idx;
+    }
+
+    _BitScanForward(&idx, (unsigned long)(c >> 32));
+    idx += 32;
+#endif
+
+    return idx;
+#elif defined(INDEX_SET_CELL_32)
+    return (size_t)__builtin_ctz(c);
+#else
+    return (size_t)__builtin_ctzll(c);
+#endif
+}
+
+/**
+ * cell of a set, 0 beyond its size
+*/
+inline static INDEX_CELL_TYPE cell_at(const index_set* ixs, size_t cidx)
+{
+    return cidx < ixs->n_cell ? ixs->data[cidx] : 0;
+}
+
+/* AVX2 KERNELS */
+
+/**
+ * every kernel handles whole vectors from the start of the cell
+ * arrays and returns number of cells done, caller finishes the rest
+*/
+
+#if defined(INDEX_SET_AVX2)
+
+INDEX_SET_TARGET_AVX2
+static size_t avx2_union(INDEX_CELL_TYPE* d, const INDEX_CELL_TYPE* s, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + INDEX_SET_AVX2_CELLS <= n; i += INDEX_SET_AVX2_CELLS)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(d + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(s + i));
+
+        _mm256_storeu_si256((__m256i*)(d + i), _mm256_or_si256(a, b));
+    }
+
+    return i;
+}
+
+INDEX_SET_TARGET_AVX2
+static size_t avx2_intersect(INDEX_CELL_TYPE* d, const INDEX_CELL_TYPE* s, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + INDEX_SET_AVX2_CELLS <= n; i += INDEX_SET_AVX2_CELLS)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(d + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(s + i));
+
+        _mm256_storeu_si256((__m256i*)(d + i), _mm256_and_si256(a, b));
+    }
+
+    return i;
+}
+
+INDEX_SET_TARGET_AVX2
+static size_t avx2_subtract(INDEX_CELL_TYPE* d, const INDEX_CELL_TYPE* s, size_t n)
+{
+    size_t i = 0;
+
+    for (; i + INDEX_SET_AVX2_CELLS <= n; i += INDEX_SET_AVX2_CELLS)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(d + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(s + i));
+
+        // andnot negates its first operand
+        _mm256_storeu_si256((__m256i*)(d + i), _mm256_andnot_si256(b, a));
+    }
+
+    return i;
+}
+
+/**
+ * *equal is set to false on first mismatching vector
+*/
+INDEX_SET_TARGET_AVX2
+static size_t avx2_equal(const INDEX_CELL_TYPE* a, const INDEX_CELL_TYPE* b, size_t n, bool* equal)
+{
+    size_t i = 0;
+
+    for (; i + INDEX_SET_AVX2_CELLS <= n; i += INDEX_SET_AVX2_CELLS)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i diff = _mm256_xor_si256(x, y);
+
+        if (!_mm256_testz_si256(diff, diff))
+        {
+            *equal = false;
+            break;
+        }
+    }
+
+    return i;
+}
+
+/**
+ * *changed is set to true if any output cell is modified
+*/
+INDEX_SET_TARGET_AVX2
+static size_t avx2_transfer(
+    INDEX_CELL_TYPE* out,
+    const INDEX_CELL_TYPE* in,
+    const INDEX_CELL_TYPE* kill,
+    const INDEX_CELL_TYPE* gen,
+    size_t n,
+    bool* changed
+)
+{
+    __m256i diff = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + INDEX_SET_AVX2_CELLS <= n; i += INDEX_SET_AVX2_CELLS)
+    {
+        __m256i o = _mm256_loadu_si256((const __m256i*)(out + i));
+        __m256i x = _mm256_loadu_si256((const __m256i*)(in + i));
+        __m256i k = _mm256_loadu_si256((const __m256i*)(kill + i));
+        __m256i g = _mm256_loadu_si256((const __m256i*)(gen + i));
+        __m256i v = _mm256_or_si256(_mm256_andnot_si256(k, x), g);
+
+        diff = _mm256_or_si256(diff, _mm256_xor_si256(v, o));
+        _mm256_storeu_si256((__m256i*)(out + i), v);
+    }
+
+    if (!_mm256_testz_si256(diff, diff))
+    {
+        *changed = true;
+    }
+
+    return i;
+}
+
+/**
+ * AVX2 is worth it only with at least one full vector
+*/
+#define index_set_use_avx2(n) ((n) >= INDEX_SET_AVX2_CELLS && cpu_has_avx2())
+
+#endif
+
 /**
  * match set cell count with the longest one
 */
@@ -51,6 +260,161 @@ static void index_set_match_source_cell_count(index_set* dest, const index_set*
     dest->n_cell = src->n_cell;
 }
 
+/* SPARSE REPRESENTATION */
+
+/**
+ * test if set is sparse
+*/
+inline static bool is_sparse(const index_set* ixs)
+{
+    return ixs->data == NULL;
+}
+
+/**
+ * most elements a sparse set may hold
+*/
+inline static size_t sparse_limit(const index_set* ixs)
+{
+    return ixs->n_cell * INDEX_CELL_BITS / INDEX_SET_SPARSE_DENSITY;
+}
+
+/**
+ * sparse lookup: position of first element not less than index
+ *
+ * it returns true if index is found at that position
+*/
+static bool sparse_find(const index_set* ixs, size_t index, size_t* pos)
+{
+    size_t lo = 0;
+    size_t hi = ixs->n_sparse;
+    size_t mid;
+
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+
+        if (ixs->sparse[mid] < index)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    *pos = lo;
+    return lo < ixs->n_sparse && ixs->sparse[lo] == index;
+}
+
+/**
+ * sparse storage: make room for n elements
+*/
+static void sparse_reserve(index_set* ixs, size_t n)
+{
+    if (n <= ixs->size_sparse) { return; }
+
+    ixs->size_sparse = max(n, max(ixs->size_sparse * 2, 4));
+    ixs->sparse = (uint32_t*)realloc_assert(ixs->sparse, sizeof(uint32_t) * ixs->size_sparse);
+}
+
+/**
+ * switch set to bit vector for good
+*/
+static void index_set_densify(index_set* ixs)
+{
+    size_t n = ixs->n_cell;
+
+    if (ixs->n_sparse)
+    {
+        n = max(n, idx2cidx(ixs->sparse[ixs->n_sparse - 1]) + 1);
+    }
+
+    ixs->n_cell = max(n, 1);
+    ixs->data = (INDEX_CELL_TYPE*)malloc_assert(sizeof(INDEX_CELL_TYPE) * ixs->n_cell);
+    memset(ixs->data, 0, sizeof(INDEX_CELL_TYPE) * ixs->n_cell);
+
+    for (size_t i = 0; i < ixs->n_sparse; i++)
+    {
+        ixs->data[idx2cidx(ixs->sparse[i])] |= idx2mask(ixs->sparse[i]);
+    }
+
+    free(ixs->sparse);
+    ixs->sparse = NULL;
+    ixs->n_sparse = 0;
+    ixs->size_sparse = 0;
+}
+
+/**
+ * switch set to bit vector if it is too dense
+*/
+inline static void sparse_check_density(index_set* ixs)
+{
+    if (ixs->n_sparse > sparse_limit(ixs))
+    {
+        index_set_densify(ixs);
+    }
+}
+
+/**
+ * sparse filter: keep elements that are (not) in other set
+*/
+static void sparse_filter(index_set* ixs, const index_set* other, bool keep_contained)
+{
+    size_t n = 0;
+
+    for (size_t i = 0; i < ixs->n_sparse; i++)
+    {
+        if (index_set_contains(other, ixs->sparse[i]) == keep_contained)
+        {
+            ixs->sparse[n++] = ixs->sparse[i];
+        }
+    }
+
+    ixs->n_sparse = n;
+}
+
+/**
+ * sparse union: merge sorted element vectors
+*/
+static void sparse_union(index_set* dest, const index_set* src)
+{
+    size_t size = dest->n_sparse + src->n_sparse;
+    uint32_t* merged;
+    size_t i = 0;
+    size_t j = 0;
+    size_t n = 0;
+
+    if (!src->n_sparse) { return; }
+
+    merged = (uint32_t*)malloc_assert(sizeof(uint32_t) * size);
+
+    while (i < dest->n_sparse || j < src->n_sparse)
+    {
+        if (j >= src->n_sparse || (i < dest->n_sparse && dest->sparse[i] < src->sparse[j]))
+        {
+            merged[n++] = dest->sparse[i++];
+        }
+        else if (i >= dest->n_sparse || src->sparse[j] < dest->sparse[i])
+        {
+            merged[n++] = src->sparse[j++];
+        }
+        else
+        {
+            merged[n++] = dest->sparse[i++];
+            j++;
+        }
+    }
+
+    free(dest->sparse);
+    dest->sparse = merged;
+    dest->n_sparse = n;
+    dest->size_sparse = size;
+    dest->n_cell = max(dest->n_cell, src->n_cell);
+
+    sparse_check_density(dest);
+}
+
 /**
  * initialize set with fill option
  *
@@ -64,6 +428,17 @@ void init_index_set_fill(index_set* ixs, size_t upper_bound, bool fill)
     size_t sz_cells = sizeof(INDEX_CELL_TYPE) * (cell_idx_max + 1);
 
     ixs->n_cell = cell_idx_max + 1;
+    ixs->sparse = NULL;
+    ixs->n_sparse = 0;
+    ixs->size_sparse = 0;
+
+    // large empty set starts sparse, nothing allocated
+    if (!fill && upper_bound >= INDEX_SET_SPARSE_MIN_BOUND && upper_bound <= UINT32_MAX)
+    {
+        ixs->data = NULL;
+        return;
+    }
+
     ixs->data = (INDEX_CELL_TYPE*)malloc_assert(sz_cells);
 
     if (fill)
@@ -73,11 +448,16 @@ void init_index_set_fill(index_set* ixs, size_t upper_bound, bool fill)
         size_t tail_shift = INDEX_CELL_BITS - (upper_bound % INDEX_CELL_BITS);
 
         // upper bound does not necessarily imply the upper cell is occupied fully
-        // so we need to flip unused bits back to 0 to make iterator work properly
+        // so we need to flip unused bits back to 0 to make iterator work properly;
+        // upper cell is not occupied at all if bound is a multiple of cell bits
         if (tail_shift != INDEX_CELL_BITS)
         {
-            ixs->data[cell_idx_max] >>= tail_shift;
             ixs->data[cell_idx_max] <<= tail_shift;
+            ixs->data[cell_idx_max] >>= tail_shift;
+        }
+        else
+        {
+            ixs->data[cell_idx_max] = 0;
         }
     }
     else
@@ -92,7 +472,8 @@ void init_index_set_fill(index_set* ixs, size_t upper_bound, bool fill)
  *
  * it will initialize set size that can hold range [0, upper_bound)
  *
- * by default, it reserves 1 cell, hence [0, INDEX_CELL_BITS)
+ * by default, it reserves 1 cell, hence [0, INDEX_CELL_BITS);
+ * a large range starts sparse
 */
 void init_index_set(index_set* ixs, size_t upper_bound)
 {
@@ -109,6 +490,23 @@ void init_index_set_copy(index_set* dest, const index_set* src)
     size_t sz = sizeof(INDEX_CELL_TYPE) * src->n_cell;
 
     dest->n_cell = src->n_cell;
+    dest->data = NULL;
+    dest->sparse = NULL;
+    dest->n_sparse = 0;
+    dest->size_sparse = 0;
+
+    if (is_sparse(src))
+    {
+        if (src->n_sparse)
+        {
+            sparse_reserve(dest, src->n_sparse);
+            memcpy(dest->sparse, src->sparse, sizeof(uint32_t) * src->n_sparse);
+            dest->n_sparse = src->n_sparse;
+        }
+
+        return;
+    }
+
     dest->data = (INDEX_CELL_TYPE*)malloc_assert(sz);
 
     memcpy(dest->data, src->data, sz);
@@ -119,7 +517,11 @@ void init_index_set_copy(index_set* dest, const index_set* src)
 */
 void release_index_set(index_set* ixs)
 {
-    if (ixs) { free(ixs->data); }
+    if (ixs)
+    {
+        free(ixs->data);
+        free(ixs->sparse);
+    }
 }
 
 /**
@@ -129,6 +531,25 @@ void index_set_add(index_set* ixs, size_t index)
 {
     size_t cidx = idx2cidx(index);
     size_t n = cidx + 1;
+    size_t pos;
+
+    if (is_sparse(ixs) && index <= UINT32_MAX)
+    {
+        if (sparse_find(ixs, index, &pos)) { return; }
+
+        sparse_reserve(ixs, ixs->n_sparse + 1);
+        memmove(ixs->sparse + pos + 1, ixs->sparse + pos, sizeof(uint32_t) * (ixs->n_sparse - pos));
+        ixs->sparse[pos] = (uint32_t)index;
+        ixs->n_sparse++;
+        ixs->n_cell = max(ixs->n_cell, n);
+
+        sparse_check_density(ixs);
+        return;
+    }
+    else if (is_sparse(ixs))
+    {
+        index_set_densify(ixs);
+    }
 
     // resize
     if (cidx >= ixs->n_cell)
@@ -147,6 +568,18 @@ void index_set_add(index_set* ixs, size_t index)
 void index_set_remove(index_set* ixs, size_t index)
 {
     size_t cidx = idx2cidx(index);
+    size_t pos;
+
+    if (is_sparse(ixs))
+    {
+        if (sparse_find(ixs, index, &pos))
+        {
+            ixs->n_sparse--;
+            memmove(ixs->sparse + pos, ixs->sparse + pos + 1, sizeof(uint32_t) * (ixs->n_sparse - pos));
+        }
+
+        return;
+    }
 
     if (cidx >= ixs->n_cell) { return; }
 
@@ -161,28 +594,30 @@ void index_set_remove(index_set* ixs, size_t index)
 */
 bool index_set_pop(index_set* ixs, size_t* idx)
 {
-    for (size_t i = 0; i < ixs->n_cell; i++)
+    if (is_sparse(ixs))
     {
-        if (ixs->data[i] != 0)
-        {
-            size_t out;
+        if (!ixs->n_sparse) { return false; }
 
-            for (size_t j = 0; j < INDEX_CELL_BITS; j++)
-            {
-                INDEX_CELL_TYPE mask = idx2mask(j);
+        if (idx) { *idx = ixs->sparse[0]; }
+
+        ixs->n_sparse--;
+        memmove(ixs->sparse, ixs->sparse + 1, sizeof(uint32_t) * ixs->n_sparse);
 
-                if (ixs->data[i] & mask)
-                {
-                    out = cidx2idx(i, j);
+        return true;
+    }
+
+    for (size_t i = 0; i < ixs->n_cell; i++)
+    {
+        INDEX_CELL_TYPE c = ixs->data[i];
 
-                    if (idx) { *idx = out; }
+        if (c != 0)
+        {
+            if (idx) { *idx = cidx2idx(i, cell_ctz(c)); }
 
-                    // fast index_set_remove, since we already know cell index and mask
-                    ixs->data[i] &= ~mask;
+            // clear lowest set bit
+            ixs->data[i] = c & (c - 1);
 
-                    return true;
-                }
-            }
+            return true;
         }
     }
 
@@ -194,10 +629,13 @@ bool index_set_pop(index_set* ixs, size_t* idx)
 */
 void index_set_clear(index_set* ixs)
 {
-    for (size_t i = 0; i < ixs->n_cell; i++)
+    if (is_sparse(ixs))
     {
-        ixs->data[i] = 0;
+        ixs->n_sparse = 0;
+        return;
     }
+
+    memset(ixs->data, 0, sizeof(INDEX_CELL_TYPE) * ixs->n_cell);
 }
 
 /**
@@ -206,6 +644,13 @@ void index_set_clear(index_set* ixs)
 bool index_set_contains(const index_set* ixs, size_t index)
 {
     size_t cidx = idx2cidx(index);
+    size_t pos;
+
+    if (is_sparse(ixs))
+    {
+        return sparse_find(ixs, index, &pos);
+    }
+
     return cidx < ixs->n_cell && (bool)(ixs->data[cidx] & idx2mask(index));
 }
 
@@ -214,6 +659,8 @@ bool index_set_contains(const index_set* ixs, size_t index)
 */
 bool index_set_empty(const index_set* ixs)
 {
+    if (is_sparse(ixs)) { return ixs->n_sparse == 0; }
+
     for (size_t i = 0; i < ixs->n_cell; i++)
     {
         if (ixs->data[i] != 0) { return false; }
@@ -229,17 +676,11 @@ size_t index_set_count(const index_set* ixs)
 {
     size_t count = 0;
 
+    if (is_sparse(ixs)) { return ixs->n_sparse; }
+
     for (size_t i = 0; i < ixs->n_cell; i++)
     {
-        INDEX_CELL_TYPE c = ixs->data[i];
-
-        for (size_t j = 0; j < INDEX_CELL_BITS; j++)
-        {
-            if ((c >> j) & 1)
-            {
-                count++;
-            }
-        }
+        count += cell_popcount(ixs->data[i]);
     }
 
     return count;
@@ -252,18 +693,51 @@ bool index_set_equal(const index_set* ixs1, const index_set* ixs2)
 {
     const index_set* longer = ixs1->n_cell >= ixs2->n_cell ? ixs1 : ixs2;
     const index_set* shorter = longer == ixs1 ? ixs2 : ixs1;
+    bool equal = true;
+    size_t i = 0;
+
+    if (is_sparse(ixs1) && is_sparse(ixs2))
+    {
+        if (ixs1->n_sparse != ixs2->n_sparse) { return false; }
+
+        // sparse array of an empty set may be NULL
+        if (ixs1->n_sparse == 0) { return true; }
+
+        return !memcmp(ixs1->sparse, ixs2->sparse, sizeof(uint32_t) * ixs1->n_sparse);
+    }
+    else if (is_sparse(ixs1) || is_sparse(ixs2))
+    {
+        const index_set* sparse = is_sparse(ixs1) ? ixs1 : ixs2;
+        const index_set* dense = sparse == ixs1 ? ixs2 : ixs1;
+
+        if (index_set_count(dense) != sparse->n_sparse) { return false; }
+
+        for (i = 0; i < sparse->n_sparse; i++)
+        {
+            if (!index_set_contains(dense, sparse->sparse[i])) { return false; }
+        }
+
+        return true;
+    }
+
+#if defined(INDEX_SET_AVX2)
+    if (index_set_use_avx2(shorter->n_cell))
+    {
+        i = avx2_equal(longer->data, shorter->data, shorter->n_cell, &equal);
+    }
+#endif
 
     // traverse as many as possible
-    for (size_t i = 0; i < longer->n_cell; i++)
+    for (; equal && i < longer->n_cell; i++)
     {
         if ((i < shorter->n_cell && longer->data[i] != shorter->data[i]) ||
             (i >= shorter->n_cell && longer->data[i] != 0))
         {
-            return false;
+            equal = false;
         }
     }
 
-    return true;
+    return equal;
 }
 
 /**
@@ -271,10 +745,40 @@ bool index_set_equal(const index_set* ixs1, const index_set* ixs2)
 */
 void index_set_union(index_set* dest, const index_set* src)
 {
+    size_t i = 0;
+
+    if (is_sparse(src))
+    {
+        if (is_sparse(dest))
+        {
+            sparse_union(dest, src);
+        }
+        else
+        {
+            for (; i < src->n_sparse; i++)
+            {
+                index_set_add(dest, src->sparse[i]);
+            }
+        }
+
+        return;
+    }
+    else if (is_sparse(dest))
+    {
+        index_set_densify(dest);
+    }
+
     index_set_match_source_cell_count(dest, src);
 
+#if defined(INDEX_SET_AVX2)
+    if (index_set_use_avx2(src->n_cell))
+    {
+        i = avx2_union(dest->data, src->data, src->n_cell);
+    }
+#endif
+
     // source cell count is always <= dest cell count here
-    for (size_t i = 0; i < src->n_cell; i++)
+    for (; i < src->n_cell; i++)
     {
         dest->data[i] |= src->data[i];
     }
@@ -282,16 +786,59 @@ void index_set_union(index_set* dest, const index_set* src)
 
 /**
  * intersect sets
+ *
+ * dest cells beyond source have nothing in common with it
 */
 void index_set_intersect(index_set* dest, const index_set* src)
 {
+    size_t i = 0;
+
+    if (is_sparse(dest))
+    {
+        sparse_filter(dest, src, true);
+        return;
+    }
+    else if (is_sparse(src))
+    {
+        // result is no larger than source, so it goes sparse
+        uint32_t* kept = (uint32_t*)malloc_assert(sizeof(uint32_t) * max(src->n_sparse, 1));
+        size_t n = 0;
+
+        for (; i < src->n_sparse; i++)
+        {
+            if (index_set_contains(dest, src->sparse[i]))
+            {
+                kept[n++] = src->sparse[i];
+            }
+        }
+
+        free(dest->data);
+        dest->data = NULL;
+        dest->sparse = kept;
+        dest->n_sparse = n;
+        dest->size_sparse = max(src->n_sparse, 1);
+        dest->n_cell = max(dest->n_cell, src->n_cell);
+
+        sparse_check_density(dest);
+        return;
+    }
+
     index_set_match_source_cell_count(dest, src);
 
+#if defined(INDEX_SET_AVX2)
+    if (index_set_use_avx2(src->n_cell))
+    {
+        i = avx2_intersect(dest->data, src->data, src->n_cell);
+    }
+#endif
+
     // source cell count is always <= dest cell count here
-    for (size_t i = 0; i < src->n_cell; i++)
+    for (; i < src->n_cell; i++)
     {
         dest->data[i] &= src->data[i];
     }
+
+    memset(dest->data + src->n_cell, 0, sizeof(INDEX_CELL_TYPE) * (dest->n_cell - src->n_cell));
 }
 
 /**
@@ -299,15 +846,101 @@ void index_set_intersect(index_set* dest, const index_set* src)
 */
 void index_set_subtract(index_set* dest, const index_set* src)
 {
+    size_t i = 0;
+
+    if (is_sparse(dest))
+    {
+        sparse_filter(dest, src, false);
+        return;
+    }
+    else if (is_sparse(src))
+    {
+        for (; i < src->n_sparse; i++)
+        {
+            index_set_remove(dest, src->sparse[i]);
+        }
+
+        return;
+    }
+
     index_set_match_source_cell_count(dest, src);
 
+#if defined(INDEX_SET_AVX2)
+    if (index_set_use_avx2(src->n_cell))
+    {
+        i = avx2_subtract(dest->data, src->data, src->n_cell);
+    }
+#endif
+
     // source cell count is always <= dest cell count here
-    for (size_t i = 0; i < src->n_cell; i++)
+    for (; i < src->n_cell; i++)
     {
         dest->data[i] &= ~src->data[i];
     }
 }
 
+/**
+ * dataflow transfer: out = (in - kill) union gen
+ *
+ * fused form of clear, union, subtract, union and equality test
+ * against old out, in one pass and without a copy of old out
+ *
+ * it returns true if out is changed
+ *
+ * sparse operands go through a temporary set
+*/
+bool index_set_transfer(index_set* out, const index_set* in, const index_set* kill, const index_set* gen)
+{
+    size_t n = min(min(out->n_cell, in->n_cell), min(kill->n_cell, gen->n_cell));
+    bool changed = false;
+    INDEX_CELL_TYPE v;
+    size_t i = 0;
+
+    if (is_sparse(out) || is_sparse(in) || is_sparse(kill) || is_sparse(gen))
+    {
+        index_set t;
+
+        init_index_set_copy(&t, in);
+        index_set_subtract(&t, kill);
+        index_set_union(&t, gen);
+
+        changed = !index_set_equal(&t, out);
+
+        release_index_set(out);
+        *out = t;
+
+        return changed;
+    }
+
+    index_set_match_source_cell_count(out, in);
+    index_set_match_source_cell_count(out, gen);
+
+#if defined(INDEX_SET_AVX2)
+    if (index_set_use_avx2(n))
+    {
+        i = avx2_transfer(out->data, in->data, kill->data, gen->data, n, &changed);
+    }
+#endif
+
+    // common part
+    for (; i < n; i++)
+    {
+        v = (in->data[i] & ~kill->data[i]) | gen->data[i];
+        changed |= v != out->data[i];
+        out->data[i] = v;
+    }
+
+    // uneven tail
+    for (; i < out->n_cell; i++)
+    {
+        v = (cell_at(in, i) & ~cell_at(kill, i)) | cell_at(gen, i);
+        changed |= v != out->data[i];
+        out->data[i] = v;
+    }
+
+    return changed;
+}
+
 /**
  * generate an array of index
 */
@@ -347,20 +980,17 @@ size_t index_set_to_array(index_set* set, size_t* buf)
 */
 static void index_set_iterator_locate_next(index_set_iterator* itor)
 {
-    for (; itor->cur_cell < itor->set->n_cell; itor->cur_cell++)
+    while (!itor->cur_rest)
     {
-        if (itor->set->data[itor->cur_cell] != 0)
+        if (++itor->cur_cell >= itor->set->n_cell)
         {
-            for (; itor->cur_offset < INDEX_CELL_BITS; itor->cur_offset++)
-            {
-                if (itor->set->data[itor->cur_cell] & idx2mask(itor->cur_offset))
-                {
-                    // break everything
-                    return;
-                }
-            }
+            return;
         }
+
+        itor->cur_rest = itor->set->data[itor->cur_cell];
     }
+
+    itor->cur_offset = cell_ctz(itor->cur_rest);
 }
 
 /**
@@ -371,8 +1001,20 @@ void index_set_iterator_init(index_set_iterator* itor, index_set* set)
     itor->set = set;
     itor->cur_cell = 0;
     itor->cur_offset = 0;
+    itor->cur_pos = 0;
 
-    index_set_iterator_locate_next(itor);
+    if (is_sparse(set))
+    {
+        itor->cur_rest = 0;
+        return;
+    }
+
+    itor->cur_rest = set->n_cell ? set->data[0] : 0;
+
+    if (set->n_cell)
+    {
+        index_set_iterator_locate_next(itor);
+    }
 }
 
 /**
@@ -388,15 +1030,15 @@ void index_set_iterator_release(index_set_iterator* itor)
 */
 void index_set_iterator_next(index_set_iterator* itor)
 {
-    // progress
-    itor->cur_offset = (itor->cur_offset + 1) % INDEX_CELL_BITS;
-
-    // progress cell carry
-    if (itor->cur_offset == 0)
+    if (is_sparse(itor->set))
     {
-        itor->cur_cell++;
+        itor->cur_pos++;
+        return;
     }
 
+    // drop current element
+    itor->cur_rest &= itor->cur_rest - 1;
+
     index_set_iterator_locate_next(itor);
 }
 
@@ -405,6 +1047,8 @@ void index_set_iterator_next(index_set_iterator* itor)
 */
 size_t index_set_iterator_get(const index_set_iterator* itor)
 {
+    if (is_sparse(itor->set)) { return itor->set->sparse[itor->cur_pos]; }
+
     return cidx2idx(itor->cur_cell, itor->cur_offset);
 }
 
@@ -413,5 +1057,7 @@ size_t index_set_iterator_get(const index_set_iterator* itor)
 */
 bool index_set_iterator_end(const index_set_iterator* itor)
 {
+    if (is_sparse(itor->set)) { return itor->cur_pos >= itor->set->n_sparse; }
+
     return itor->cur_cell >= itor->set->n_cell;
 }
@@ -4,15 +4,30 @@
  * Index set uses bit-mask to implement set properties for any data
  * that is associated with an index identifier
  *
- * each cell in the set has 32(64) bits for corresponding number of indicies;
+ * each cell in the set has 64(32) bits for corresponding number of indicies;
  * to locate the unique position of an index number:
  *
  * For any index number i:
  * cell index: i / INDEX_CELL_BITS
- * bit shift-right amount: i % INDEX_CELL_BITS
+ * bit shift-left amount: i % INDEX_CELL_BITS
  * union: bit-OR for every cell
  * intersect: bit-AND for every cell
  *
+ * lowest index of a cell is its least significant bit, so counting
+ * is a popcount and finding the first element is a count of trailing
+ * zeros; bulk operations use AVX2 when running CPU supports it
+ *
+ * Sparse Representation
+ *
+ * a set over a large domain starts sparse: a sorted vector of its
+ * elements, nothing allocated until the first one; it switches to
+ * the bit vector for good once it holds more than one element per
+ * INDEX_SET_SPARSE_DENSITY indices of its domain, at which point the
+ * sparse vector would take half the memory of the bit vector
+ *
+ * both representations sit behind the same index_set_* API, data is
+ * NULL in sparse mode; n_cell always covers the domain
+ *
 */
 
 #pragma once
@@ -21,22 +36,50 @@
 
 #include "types.h"
 
+/**
+ * 64-bit profile by default, define INDEX_SET_CELL_32 for 32-bit one
+*/
+#if defined(INDEX_SET_CELL_32)
 #define INDEX_CELL_TYPE uint32_t
 #define INDEX_CELL_BITS 32 // sizeof(INDEX_CELL_TYPE) * 8
-#define INDEX_CELL_MASK_IDX0 ((INDEX_CELL_TYPE)(0x80000000))
+#else
+#define INDEX_CELL_TYPE uint64_t
+#define INDEX_CELL_BITS 64 // sizeof(INDEX_CELL_TYPE) * 8
+#endif
+#define INDEX_CELL_MASK_IDX0 ((INDEX_CELL_TYPE)1)
 #define INDEX_CELL_COUNT_DEFAULT 0
 
 /**
- * 64-bit profile, not used
+ * smallest domain that starts sparse, SIZE_MAX disables sparse sets
+*/
+#ifndef INDEX_SET_SPARSE_MIN_BOUND
+#define INDEX_SET_SPARSE_MIN_BOUND 256
+#endif
+
+/**
+ * indices of domain per sparse element before switching to dense
+*/
+#ifndef INDEX_SET_SPARSE_DENSITY
+#define INDEX_SET_SPARSE_DENSITY 64
+#endif
+
+/**
+ * AVX2 kernels, x86 only; define INDEX_SET_NO_SIMD to disable
 */
-// #define INDEX_CELL_TYPE uint64_t
-// #define INDEX_CELL_BITS 64 // sizeof(INDEX_CELL_TYPE) * 8
-// #define INDEX_CELL_MASK_IDX0 0x8000000000000000
+#if !defined(INDEX_SET_NO_SIMD) && \
+    (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__))
+#define INDEX_SET_AVX2
+#endif
 
 typedef struct _index_set
 {
+    /* bit vector, NULL if sparse */
     INDEX_CELL_TYPE* data;
     size_t n_cell;
+    /* sorted elements if sparse */
+    uint32_t* sparse;
+    size_t n_sparse;
+    size_t size_sparse;
 } index_set;
 
 typedef struct _index_set_iterator
@@ -44,6 +87,10 @@ typedef struct _index_set_iterator
     index_set* set;
     size_t cur_cell;
     size_t cur_offset;
+    /* elements of current cell not visited yet, current one included */
+    INDEX_CELL_TYPE cur_rest;
+    /* sparse: position in element vector */
+    size_t cur_pos;
 } index_set_iterator;
 
 void init_index_set_fill(index_set* ixs, size_t upper_bound, bool fill);
@@ -62,6 +109,7 @@ bool index_set_equal(const index_set* ixs1, const index_set* ixs2);
 void index_set_union(index_set* dest, const index_set* src);
 void index_set_intersect(index_set* dest, const index_set* src);
 void index_set_subtract(index_set* dest, const index_set* src);
+bool index_set_transfer(index_set* out, const index_set* in, const index_set* kill, const index_set* gen);
 size_t index_set_to_array(index_set* set, size_t* buf);
 
 void index_set_iterator_init(index_set_iterator* itor, index_set* set);
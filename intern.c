@@ -0,0 +1,135 @@
+#include "intern.h"
+
+/**
+ * initial number of id slots
+*/
+#define INTERN_TABLE_INIT_SIZE 256
+
+/**
+ * initialize intern table
+ *
+ * id 0 is taken by INTERN_ID_NONE
+*/
+void init_intern_table(intern_table* table)
+{
+    init_hash_table(&table->lookup, INTERN_TABLE_INIT_SIZE);
+    init_arena(&table->strings, 0);
+
+    table->names = (char**)malloc_assert(sizeof(char*) * INTERN_TABLE_INIT_SIZE);
+    table->names[INTERN_ID_NONE] = NULL;
+    table->num_names = 1;
+    table->size_names = INTERN_TABLE_INIT_SIZE;
+}
+
+/**
+ * release intern table
+ *
+ * all canonical strings are gone with the arena
+*/
+void release_intern_table(intern_table* table)
+{
+    release_hash_table(&table->lookup, NULL);
+    release_arena(&table->strings);
+    free(table->names);
+
+    table->names = NULL;
+    table->num_names = 0;
+    table->size_names = 0;
+}
+
+/**
+ * intern a buffer slice, returns canonical string
+ *
+ * slice does not need to be '\0'-terminated
+*/
+char* intern_slice(intern_table* table, const byte* from, size_t len)
+{
+    hash h = bhash(from, len);
+    hash_pair* pair = phash_table_get(&table->lookup, from, len, h);
+    intern_header* header;
+    char* name;
+
+    if (pair)
+    {
+        return pair->key;
+    }
+
+    // new name: header and content in one allocation
+    header = (intern_header*)arena_alloc(&table->strings, sizeof(intern_header) + len + 1);
+    name = (char*)(header + 1);
+
+    memcpy(name, from, len);
+    name[len] = '\0';
+
+    header->id = table->num_names;
+    header->length = len;
+    header->hash = h;
+
+    // register id
+    if (table->num_names >= table->size_names)
+    {
+        table->size_names *= 2;
+        table->names = (char**)realloc_assert(table->names, sizeof(char*) * table->size_names);
+    }
+
+    table->names[table->num_names++] = name;
+    phash_table_insert(&table->lookup, name, len, h, header);
+
+    return name;
+}
+
+/**
+ * intern a '\0'-terminated string, returns canonical string
+*/
+char* intern_string(intern_table* table, const char* s)
+{
+    return s ? intern_slice(table, (const byte*)s, strlen(s)) : NULL;
+}
+
+/**
+ * canonical string of an id, NULL if id is unknown
+*/
+char* intern_name(const intern_table* table, size_t id)
+{
+    return id < table->num_names ? table->names[id] : NULL;
+}
+
+/**
+ * interned key insert
+*/
+void ihash_table_insert(hash_table* table, char* name, void* v)
+{
+    intern_header* header = intern_header_of(name);
+
+    phash_table_insert(table, name, header->length, header->hash, v);
+}
+
+/**
+ * interned key test
+*/
+bool ihash_table_test(const hash_table* table, const char* name)
+{
+    return ihash_table_get(table, name) != NULL;
+}
+
+/**
+ * interned key find
+*/
+void* ihash_table_find(const hash_table* table, const char* name)
+{
+    hash_pair* pair = ihash_table_get(table, name);
+
+    return pair ? pair->value : NULL;
+}
+
+/**
+ * interned key get
+ *
+ * as all keys are canonical, matching pair shares the key pointer
+*/
+hash_pair* ihash_table_get(const hash_table* table, const char* name)
+{
+    intern_header* header = intern_header_of(name);
+
+    return phash_table_get(table, name, header->length, header->hash);
+}
@@ -0,0 +1,99 @@
+/**
+ * Name Interning
+ *
+ * every distinct name is stored exactly once and gets a stable id,
+ * so two interned names are equal if and only if their pointers are
+ * equal; canonical strings are read-only and never freed by user
+ *
+ * a canonical string is preceded by a header carrying its id, length
+ * and hash, so tables keyed on interned names (ihash_table_*) never
+ * need strlen, hashing, or memcmp; bucket placement is identical to
+ * shash_table_* on the same string
+ *
+ * the table belongs to one compiler instance and lives across files,
+ * ids are never reused until the table is released
+*/
+
+#pragma once
+#ifndef __COMPILER_INTERN_H__
+#define __COMPILER_INTERN_H__
+
+#include "types.h"
+#include "arena.h"
+#include "hash.h"
+#include "hash-table.h"
+
+/**
+ * id reserved for "no name"
+*/
+#define INTERN_ID_NONE 0
+
+/**
+ * Canonical String Header
+ *
+ * content follows the header directly, '\0'-terminated
+*/
+typedef struct
+{
+    /* stable id */
+    size_t id;
+    /* content length, '\0' excluded */
+    size_t length;
+    /* bhash of content */
+    hash hash;
+} intern_header;
+
+/**
+ * Intern Table
+*/
+typedef struct
+{
+    /* content -> header */
+    hash_table lookup;
+    /* header and content storage */
+    arena strings;
+    /* id -> canonical string */
+    char** names;
+    size_t num_names;
+    size_t size_names;
+} intern_table;
+
+void init_intern_table(intern_table* table);
+void release_intern_table(intern_table* table);
+
+char* intern_slice(intern_table* table, const byte* from, size_t len);
+char* intern_string(intern_table* table, const char* s);
+char* intern_name(const intern_table* table, size_t id);
+
+/**
+ * header of a canonical string
+*/
+static inline intern_header* intern_header_of(const char* name)
+{
+    return (intern_header*)name - 1;
+}
+
+/**
+ * stable id of a canonical string
+*/
+static inline size_t intern_id(const char* name)
+{
+    return name ? intern_header_of(name)->id : INTERN_ID_NONE;
+}
+
+/**
+ * length of a canonical string
+*/
+static inline size_t intern_length(const char* name)
+{
+    return intern_header_of(name)->length;
+}
+
+// tables keyed on canonical strings
+
+void ihash_table_insert(hash_table* table, char* name, void* v);
+bool ihash_table_test(const hash_table* table, const char* name);
+void* ihash_table_find(const hash_table* table, const char* name);
+hash_pair* ihash_table_get(const hash_table* table, const char* name);
+
+#endif
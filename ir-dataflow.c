@@ -0,0 +1,224 @@
+#include "ir.h"
+
+/**
+ * Dataflow Engine
+ *
+ * a generic iterative solver on CFG, facts are index sets and the
+ * analysis plugs in its meet and transfer functions
+ *
+ * it relies on the same assumption as other CFG algorithms: every
+ * node is reachable from entry, so postorder covers all nodes
+*/
+
+/**
+ * initialize dataflow problem
+ *
+ * postorder is borrowed, it must stay valid until solved
+*/
+void init_dataflow(
+    dataflow* df,
+    const cfg* g,
+    basic_block** postorder,
+    dataflow_direction direction,
+    size_t domain,
+    dataflow_meet meet,
+    dataflow_transfer transfer
+)
+{
+    size_t num_nodes = g->nodes.num;
+
+    df->graph = g;
+    df->order = postorder;
+    df->direction = direction;
+    df->meet = meet;
+    df->transfer = transfer;
+    df->domain = domain;
+    df->init_fill = false;
+    df->context = NULL;
+    df->gen = NULL;
+    df->kill = NULL;
+
+    init_index_set(&df->boundary, domain);
+
+    df->in = (index_set*)malloc_assert(sizeof(index_set) * num_nodes);
+    df->out = (index_set*)malloc_assert(sizeof(index_set) * num_nodes);
+
+    for (size_t i = 0; i < num_nodes; i++)
+    {
+        init_index_set(&df->in[i], domain);
+        init_index_set(&df->out[i], domain);
+    }
+
+    memset(&df->stats, 0, sizeof(dataflow_stats));
+}
+
+/**
+ * release dataflow problem
+*/
+void release_dataflow(dataflow* df)
+{
+    size_t num_nodes = df->graph->nodes.num;
+
+    for (size_t i = 0; i < num_nodes; i++)
+    {
+        release_index_set(&df->in[i]);
+        release_index_set(&df->out[i]);
+
+        if (df->gen) { release_index_set(&df->gen[i]); }
+        if (df->kill) { release_index_set(&df->kill[i]); }
+    }
+
+    release_index_set(&df->boundary);
+    free(df->in);
+    free(df->out);
+    free(df->gen);
+    free(df->kill);
+
+    df->in = NULL;
+    df->out = NULL;
+    df->gen = NULL;
+    df->kill = NULL;
+}
+
+/**
+ * allocate empty per-block gen and kill facts
+*/
+void dataflow_use_gen_kill(dataflow* df)
+{
+    size_t num_nodes = df->graph->nodes.num;
+
+    df->gen = (index_set*)malloc_assert(sizeof(index_set) * num_nodes);
+    df->kill = (index_set*)malloc_assert(sizeof(index_set) * num_nodes);
+
+    for (size_t i = 0; i < num_nodes; i++)
+    {
+        init_index_set(&df->gen[i], df->domain);
+        init_index_set(&df->kill[i], df->domain);
+    }
+}
+
+/**
+ * meet: union, for may-problems such as liveness
+*/
+void dataflow_meet_union(index_set* dest, const index_set* src)
+{
+    index_set_union(dest, src);
+}
+
+/**
+ * meet: intersect, for must-problems such as available expressions
+*/
+void dataflow_meet_intersect(index_set* dest, const index_set* src)
+{
+    index_set_intersect(dest, src);
+}
+
+/**
+ * transfer: (source - kill) union gen
+*/
+bool dataflow_transfer_gen_kill(dataflow* df, basic_block* b, index_set* result, const index_set* source)
+{
+    return index_set_transfer(result, source, &df->kill[b->id], &df->gen[b->id]);
+}
+
+/**
+ * fact flowing from a neighbor along analysis direction
+*/
+static const index_set* dataflow_neighbor_fact(dataflow* df, const edge_array* edges, size_t i)
+{
+    return df->direction == DATAFLOW_FORWARD ?
+        &df->out[edges->arr[i]->from->id] :
+        &df->in[edges->arr[i]->to->id];
+}
+
+/**
+ * meet all facts flowing into a block
+*/
+static void dataflow_meet_block(dataflow* df, basic_block* b, index_set* source)
+{
+    bool forward = df->direction == DATAFLOW_FORWARD;
+    const edge_array* edges = forward ? &b->in : &b->out;
+    size_t i = 0;
+
+    index_set_clear(source);
+
+    // boundary: entry for forward problem, exits for backward problem
+    if ((forward && b == df->graph->entry) || edges->num == 0)
+    {
+        index_set_union(source, &df->boundary);
+    }
+    else
+    {
+        index_set_union(source, dataflow_neighbor_fact(df, edges, i++));
+    }
+
+    for (; i < edges->num; i++)
+    {
+        df->meet(source, dataflow_neighbor_fact(df, edges, i));
+    }
+}
+
+/**
+ * solve dataflow problem to its fixed point
+ *
+ * worklist holds visit positions, so popping the lowest one gives
+ * reverse postorder for forward problem and postorder for backward
+ * problem; a changed block queues blocks that depend on it
+*/
+void dataflow_solve(dataflow* df)
+{
+    size_t num_nodes = df->graph->nodes.num;
+    bool forward = df->direction == DATAFLOW_FORWARD;
+    basic_block** visit = (basic_block**)malloc_assert(sizeof(basic_block*) * num_nodes);
+    size_t* rank = (size_t*)malloc_assert(sizeof(size_t) * num_nodes);
+    index_set worklist;
+    size_t pos;
+
+    for (size_t i = 0; i < num_nodes; i++)
+    {
+        visit[i] = forward ? df->order[num_nodes - i - 1] : df->order[i];
+        rank[visit[i]->id] = i;
+    }
+
+    // top element for intersect-style meets
+    if (df->init_fill)
+    {
+        for (size_t i = 0; i < num_nodes; i++)
+        {
+            release_index_set(&df->in[i]);
+            release_index_set(&df->out[i]);
+            init_index_set_fill(&df->in[i], df->domain, true);
+            init_index_set_fill(&df->out[i], df->domain, true);
+        }
+    }
+
+    memset(&df->stats, 0, sizeof(dataflow_stats));
+    init_index_set_fill(&worklist, num_nodes, true);
+
+    while (index_set_pop(&worklist, &pos))
+    {
+        basic_block* b = visit[pos];
+        index_set* source = forward ? &df->in[b->id] : &df->out[b->id];
+        index_set* result = forward ? &df->out[b->id] : &df->in[b->id];
+        const edge_array* edges = forward ? &b->out : &b->in;
+
+        dataflow_meet_block(df, b, source);
+        df->stats.num_visits++;
+
+        if (df->transfer(df, b, result, source))
+        {
+            df->stats.num_changes++;
+
+            for (size_t i = 0; i < edges->num; i++)
+            {
+                index_set_add(&worklist, rank[forward ? edges->arr[i]->to->id : edges->arr[i]->from->id]);
+            }
+        }
+    }
+
+    df->stats.num_passes = num_nodes ? (df->stats.num_visits + num_nodes - 1) / num_nodes : 0;
+
+    release_index_set(&worklist);
+    free(visit);
+    free(rank);
+}
@@ -48,7 +48,7 @@ size_t get_variable_id(const definition* def)
  * otherwise type_def will be set to NULL if data control is
  * DEF_DATA_MOVE
  *
- * name will be set to NULL if successful; stay as-is otherwise
+ * name must be interned
  *
  * it returns the definition reference of the variable after
  * successful registration; NULL otherwise
@@ -57,7 +57,7 @@ size_t get_variable_id(const definition* def)
 */
 definition* def(
     java_ir* ir,
-    char** name,
+    char* name,
     definition** type_def,
     size_t name_dims,
     def_use_control duc,
@@ -67,7 +67,7 @@ definition* def(
 )
 {
     // test if declarator can be registered
-    if (use(ir, *name, duc, JAVA_E_MAX) || shash_table_get(&ir->tbl_import, *name))
+    if (use(ir, name, duc, JAVA_E_MAX) || ihash_table_get(&ir->tbl_import, name))
     {
         ir_error(ir, err_dup);
         return NULL;
@@ -81,7 +81,7 @@ definition* def(
          * is currently scoping. In this case this method is a
          * constructor
         */
-        hash_pair* __p = shash_table_get(&ir->tbl_global, *name);
+        hash_pair* __p = ihash_table_get(&ir->tbl_global, name);
 
         if (__p && !(
             __p->value == ir->working_top_level &&
@@ -93,7 +93,7 @@ definition* def(
         }
     }
 
-    hash_table* table = lookup_working_scope(ir);
+    bool local = lookup_in_scope(ir);
     bool copy_def = duc & DU_CTL_DATA_COPY;
     definition* tdef = NULL;
 
@@ -104,10 +104,14 @@ definition* def(
     }
 
     // register
-    shash_table_insert(table, *name, tdef);
-
-    // we always move name, so simply detach
-    *name = NULL;
+    if (local)
+    {
+        lookup_scope_register(ir, name, tdef);
+    }
+    else
+    {
+        ihash_table_insert(lookup_top_level_scope(ir), name, tdef);
+    }
 
     // only detach if the reference is moved successfully
     if (!copy_def && type_def)
@@ -125,7 +129,7 @@ definition* def(
     {
         if (tdef->variable->kind == VARIABLE_KIND_MEMBER)
         {
-            if (!ir->working_top_level || lookup_top_level_scope(ir) != table)
+            if (!ir->working_top_level || local)
             {
                 fprintf(stderr, "TODO ERROR: internal error: member variable detected inside local scope.\n");
             }
@@ -134,7 +138,7 @@ definition* def(
         }
         else
         {
-            if (lookup_top_level_scope(ir) == table)
+            if (!local)
             {
                 fprintf(stderr, "TODO ERROR: internal error: local variable detected outside local scope.\n");
             }
@@ -178,36 +182,33 @@ definition* def(
  * NOTE: on-demand imports are not checked here, meaning definitions
  * are prioritized as local definitions, and during linking, names
  * will be imported and check for ambiguity
+ *
+ * name must be interned
 */
 definition* use(java_ir* ir, const char* name, def_use_control duc, java_error_id err_undef)
 {
-    scope_frame* cur = ir->scope_stack_top;
     hash_table* top_level = lookup_top_level_scope(ir);
-    hash_pair* p;
+    scope_entry* e;
+    hash_pair* p = NULL;
 
     // nothing to look for
-    if (!cur && !top_level)
+    if (!lookup_in_scope(ir) && !top_level)
     {
         return NULL;
     }
 
-    // first we go through hierarchy
-    while (cur)
-    {
-        p = shash_table_get(cur->table, name);
+    // first we go through hierarchy, innermost entry wins
+    e = lookup_scope_find(ir, name);
 
-        if (p)
-        {
-            return p->value;
-        }
-
-        cur = cur->next;
+    if (e)
+    {
+        return e->desc;
     }
 
     // if nothing we try top level
     if (duc & DU_CTL_LOOKUP_TOP_LEVEL)
     {
-        p = shash_table_get(top_level, name);
+        p = ihash_table_get(top_level, name);
     }
 
     // error check
@@ -363,32 +364,32 @@ definition* def_li_raw(
  *
  * node: JNT_TYPE
 */
-definition* type2def(tree_node* node, definition_type type)
+definition* type2def(java_ir* ir, flat_node* node, definition_type type)
 {
     definition* desc = new_definition(type);
 
     switch (type)
     {
         case DEFINITION_VARIABLE:
-            desc->variable->type.primitive = node->data.declarator->id.simple;
-            desc->variable->type.dim = node->data.declarator->dimension;
+            desc->variable->type.primitive = node->data.id.simple;
+            desc->variable->type.dim = node->dimension;
 
             // if not primitive type, then it must be a reference type
             if (desc->variable->type.primitive == JLT_MAX)
             {
                 // type->class_type->unit
-                desc->variable->type.reference = name_unit_concat(node->first_child->first_child, NULL);
+                desc->variable->type.reference = name_unit_concat(ir, flat_first_child(flat_first_child(node)), NULL);
             }
             break;
         case DEFINITION_METHOD:
-            desc->method->return_type.primitive = node->data.declarator->id.simple;
-            desc->method->return_type.dim = node->data.declarator->dimension;
+            desc->method->return_type.primitive = node->data.id.simple;
+            desc->method->return_type.dim = node->dimension;
 
             // if not primitive type, then it must be a reference type
             if (desc->method->return_type.primitive == JLT_MAX)
             {
                 // type->class_type->unit
-                desc->method->return_type.reference = name_unit_concat(node->first_child->first_child, NULL);
+                desc->method->return_type.reference = name_unit_concat(ir, flat_first_child(flat_first_child(node)), NULL);
             }
             break;
         default:
@@ -404,7 +405,7 @@ definition* type2def(tree_node* node, definition_type type)
  *
  * node: JNT_FORMAL_PARAM_LIST | NULL
 */
-static char* get_param_list_type_name(java_ir* ir, tree_node* node, size_t* counter)
+static char* get_param_list_type_name(java_ir* ir, flat_node* node, size_t* counter)
 {
     /**
      * type check provides robustness especially to contructor's AST
@@ -444,18 +445,18 @@ static char* get_param_list_type_name(java_ir* ir, tree_node* node, size_t* coun
      * |
      * +--- ...
     */
-    node = node->first_child;
+    node = flat_first_child(node);
 
     while (node)
     {
         // parse dimensions
-        for (size_t i = node->first_child->data.declarator->dimension; i > 0; i--)
+        for (size_t i = flat_first_child(node)->dimension; i > 0; i--)
         {
             string_list_append_char(&sl, JIL_TYPE_ARRAY_DIM);
         }
 
         // parse primitive type
-        c = primitive_type_to_jil_type(node->first_child->data.declarator->id.simple);
+        c = primitive_type_to_jil_type(flat_first_child(node)->data.id.simple);
 
         if (c)
         {
@@ -465,12 +466,12 @@ static char* get_param_list_type_name(java_ir* ir, tree_node* node, size_t* coun
         {
             // parse reference type name
             string_list_append_char(&sl, JIL_TYPE_OBJECT);
-            string_list_append(&sl, name_unit_concat(node->first_child->first_child->first_child, NULL), false);
+            string_list_append(&sl, name_unit_concat(ir, flat_first_child(flat_first_child(flat_first_child(node))), NULL), true);
             string_list_append_char(&sl, ';');
         }
 
         param_count++;
-        node = node->next_sibling;
+        node = flat_next_sibling(node);
     }
 
     // prepare result
@@ -492,9 +493,11 @@ static char* get_param_list_type_name(java_ir* ir, tree_node* node, size_t* coun
  *
  * an optional counter param_count is used for parameter count
  *
+ * returned name is interned
+ *
  * node: JNT_METHOD_HEADER | JNT_CTOR_DECL
 */
-static char* get_full_method_name(java_ir* ir, tree_node* node, size_t* param_count)
+static char* get_full_method_name(java_ir* ir, flat_node* node, size_t* param_count)
 {
     /**
      * JNT_METHOD_HEADER | JNT_CTOR_DECL    <--- HERE
@@ -514,20 +517,23 @@ static char* get_full_method_name(java_ir* ir, tree_node* node, size_t* param_co
      * for constructor, so no further adjustment
      * needs to be done here
     */
-    char* name = t2s(node->data.declarator->id.complex);
-    char* param_name = get_param_list_type_name(ir, node->first_child, param_count);
+    char* name = t2n(ir, node->data.id.complex);
+    char* param_name = get_param_list_type_name(ir, flat_first_child(node), param_count);
+    char* full_name;
     size_t len_n, len_p;
 
     if (param_name)
     {
-        len_n = strlen(name);
+        len_n = intern_length(name);
         len_p = strlen(param_name);
-        name = (char*)realloc_assert(name, sizeof(char) * (len_n + len_p + 1));
+        full_name = (char*)malloc_assert(sizeof(char) * (len_n + len_p));
 
-        strcpy(name + len_n, param_name);
-        free(param_name);
+        memcpy(full_name, name, len_n);
+        memcpy(full_name + len_n, param_name, len_p);
+        name = intern_slice(ir->names, (byte*)full_name, len_n + len_p);
 
-        name[len_n + len_p] = '\0';
+        free(full_name);
+        free(param_name);
     }
 
     return name;
@@ -542,7 +548,7 @@ static char* get_full_method_name(java_ir* ir, tree_node* node, size_t* param_co
  *
  * node: JNT_CTOR_DECL
 */
-static void def_constructor(java_ir* ir, tree_node* node, lbit_flag modifier)
+static void def_constructor(java_ir* ir, flat_node* node, lbit_flag modifier)
 {
     definition* desc = new_definition(DEFINITION_METHOD);
     definition* method;
@@ -565,7 +571,7 @@ static void def_constructor(java_ir* ir, tree_node* node, lbit_flag modifier)
 
     // register
     method = def(
-        ir, &name, &desc, 0,
+        ir, name, &desc, 0,
         DU_CTL_LOOKUP_TOP_LEVEL | DU_CTL_METHOD_NAME,
         JAVA_E_METHOD_DUPLICATE,
         JAVA_E_METHOD_DIM_AMBIGUOUS,
@@ -582,7 +588,6 @@ static void def_constructor(java_ir* ir, tree_node* node, lbit_flag modifier)
     }
 
     // cleanup
-    free(name);
     definition_delete(desc);
 }
 
@@ -596,7 +601,7 @@ static void def_constructor(java_ir* ir, tree_node* node, lbit_flag modifier)
 */
 definition* def_var(
     java_ir* ir,
-    tree_node* node,
+    flat_node* node,
     definition** type,
     lbit_flag modifier,
     variable_kind kind,
@@ -608,7 +613,7 @@ definition* def_var(
      * |
      * +--- JNT_EXPRESSION   <--- root_code_walk if is_member=true
     */
-    char* name = t2s(node->data.declarator->id.complex);
+    char* name = t2n(ir, node->data.id.complex);
     bool is_member = kind == VARIABLE_KIND_MEMBER;
 
     // fill must finish before def()
@@ -619,8 +624,8 @@ definition* def_var(
     }
 
     definition* data = def(
-        ir, &name, type,
-        node->data.declarator->dimension,
+        ir, name, type,
+        node->dimension,
         duc | DU_CTL_LOOKUP_TOP_LEVEL,
         is_member ? JAVA_E_MEMBER_VAR_DUPLICATE : JAVA_E_LOCAL_VAR_DUPLICATE,
         is_member ? JAVA_E_MEMBER_VAR_DIM_AMBIGUOUS : JAVA_E_LOCAL_VAR_DIM_AMBIGUOUS,
@@ -633,12 +638,9 @@ definition* def_var(
     */
     if (is_member)
     {
-        data->root_code_walk = node->first_child;
+        data->root_code_walk = flat_first_child(node);
     }
 
-    // if succeeds, name is NULL here so it is safe
-    free(name);
-
     return data;
 }
 
@@ -647,9 +649,9 @@ definition* def_var(
  *
  * node: JNT_TYPE
 */
-void def_vars(java_ir* ir, tree_node* node, lbit_flag modifier, variable_kind kind)
+void def_vars(java_ir* ir, flat_node* node, lbit_flag modifier, variable_kind kind)
 {
-    definition* desc = type2def(node, DEFINITION_VARIABLE);
+    definition* desc = type2def(ir, node, DEFINITION_VARIABLE);
 
     /**
      * JNT_TYPE
@@ -664,14 +666,14 @@ void def_vars(java_ir* ir, tree_node* node, lbit_flag modifier, variable_kind ki
      * |
      * +--- ...
     */
-    node = node->next_sibling->first_child;
+    node = flat_first_child(flat_next_sibling(node));
 
     // register, every id has same type
     while (node)
     {
         // only move the definition for the last variable
-        def_var(ir, node, &desc, modifier, kind, node->next_sibling ? DU_CTL_DATA_COPY : DU_CTL_DEFAULT);
-        node = node->next_sibling;
+        def_var(ir, node, &desc, modifier, kind, flat_next_sibling(node) ? DU_CTL_DATA_COPY : DU_CTL_DEFAULT);
+        node = flat_next_sibling(node);
     }
 
     // cleanup
@@ -689,7 +691,7 @@ void def_vars(java_ir* ir, tree_node* node, lbit_flag modifier, variable_kind ki
  *
  * node: JNT_FORMAL_PARAM_LIST
 */
-void def_params(java_ir* ir, tree_node* node, definition** ordered_list)
+void def_params(java_ir* ir, flat_node* node, definition** ordered_list)
 {
     if (!node)
     {
@@ -714,24 +716,24 @@ void def_params(java_ir* ir, tree_node* node, definition** ordered_list)
      * |
      * +--- ...
     */
-    node = node->first_child;
+    node = flat_first_child(node);
 
     while (node)
     {
-        desc = type2def(node->first_child, DEFINITION_VARIABLE);
-        name = t2s(node->data.declarator->id.complex);
+        desc = type2def(ir, flat_first_child(node), DEFINITION_VARIABLE);
+        name = t2n(ir, node->data.id.complex);
 
         // fill
         desc->variable->kind = VARIABLE_KIND_PARAMETER;
 
         /**
-         * 1. move name and desc
+         * 1. move desc
          * 2. do NOT lookup global scope: parameter name is scoped so it can co-exist
          *    with class member with same name
         */
         param = def(
-            ir, &name, &desc,
-            node->data.declarator->dimension,
+            ir, name, &desc,
+            node->dimension,
             DU_CTL_DEFAULT,
             JAVA_E_PARAM_DUPLICATE,
             JAVA_E_PARAM_DIM_AMBIGUOUS,
@@ -745,10 +747,9 @@ void def_params(java_ir* ir, tree_node* node, definition** ordered_list)
         }
 
         // cleanup
-        free(name);
         definition_delete(desc);
 
-        node = node->next_sibling;
+        node = flat_next_sibling(node);
         idx++;
     }
 }
@@ -758,11 +759,11 @@ void def_params(java_ir* ir, tree_node* node, definition** ordered_list)
  *
  * node: JNT_TYPE
 */
-static void def_method(java_ir* ir, tree_node* node, lbit_flag modifier)
+static void def_method(java_ir* ir, flat_node* node, lbit_flag modifier)
 {
-    definition* desc = type2def(node, DEFINITION_METHOD);
+    definition* desc = type2def(ir, node, DEFINITION_METHOD);
     definition* method;
-    tree_node* node_method_decl = node->next_sibling;
+    flat_node* node_method_decl = flat_next_sibling(node);
     char* name;
     size_t param_count;
 
@@ -783,15 +784,15 @@ static void def_method(java_ir* ir, tree_node* node, lbit_flag modifier)
      * |
      * +--- JNT_METHOD_BODY
     */
-    node = node_method_decl->first_child;
+    node = flat_first_child(node_method_decl);
 
     // get name
     name = get_full_method_name(ir, node, &param_count);
 
     // register
     method = def(
-        ir, &name, &desc,
-        node->data.declarator->dimension,
+        ir, name, &desc,
+        node->dimension,
         DU_CTL_LOOKUP_TOP_LEVEL | DU_CTL_METHOD_NAME,
         JAVA_E_METHOD_DUPLICATE,
         JAVA_E_METHOD_DIM_AMBIGUOUS,
@@ -815,7 +816,6 @@ static void def_method(java_ir* ir, tree_node* node, lbit_flag modifier)
     }
 
     // cleanup
-    free(name);
     definition_delete(desc);
 }
 
@@ -824,12 +824,12 @@ static void def_method(java_ir* ir, tree_node* node, lbit_flag modifier)
  *
  * node: JNT_IMPORT_DECL
 */
-static void def_import(java_ir* ir, tree_node* node)
+static void def_import(java_ir* ir, flat_node* node)
 {
     global_import* desc;
     hash_pair* pair;
-    tree_node* name = node->first_child;
-    tree_node* last_unit = NULL;
+    flat_node* name = flat_first_child(node);
+    flat_node* last_unit = NULL;
     char* registered_name = NULL;
     char* pkg_name = NULL;
 
@@ -844,15 +844,15 @@ static void def_import(java_ir* ir, tree_node* node)
      *      |
      *      +--- ...
     */
-    if (!node->data.import->on_demand)
+    if (!node->data.import.on_demand)
     {
         // last name unit is the import target
-        last_unit = name->last_child;
-        registered_name = t2s(last_unit->data.id->complex);
+        last_unit = flat_last_child(name);
+        registered_name = t2n(ir, last_unit->data.id.complex);
     }
 
     // construct package name list
-    pkg_name = name_unit_concat(name->first_child, last_unit);
+    pkg_name = name_unit_concat(ir, flat_first_child(name), last_unit);
 
     // register the class name if applicable
     if (registered_name)
@@ -867,9 +867,9 @@ static void def_import(java_ir* ir, tree_node* node)
     }
 
     // name resolution must be unique
-    if (!lookup_register(ir, &ir->tbl_import, &registered_name, &desc, JAVA_E_MAX))
+    if (!lookup_register(ir, &ir->tbl_import, registered_name, &desc, JAVA_E_MAX))
     {
-        pair = shash_table_get(&ir->tbl_import, registered_name);
+        pair = ihash_table_get(&ir->tbl_import, registered_name);
 
         /**
          * duplicate only happen when both are:
@@ -881,7 +881,7 @@ static void def_import(java_ir* ir, tree_node* node)
          * the package name matches
         */
         if (((desc == NULL) == (pair->value == NULL)) &&
-            strcmp(pair->value ? ((global_import*)pair->value)->package_name : pair->key, pkg_name) == 0)
+            (pair->value ? ((global_import*)pair->value)->package_name : pair->key) == pkg_name)
         {
             ir_error(ir, JAVA_E_IMPORT_DUPLICATE);
         }
@@ -891,8 +891,7 @@ static void def_import(java_ir* ir, tree_node* node)
         }
     }
 
-    // cleanup: no need to free pkg_name as it was already moved
-    free(registered_name);
+    // cleanup: names are interned
     delete_global_import(desc);
 }
 
@@ -912,7 +911,7 @@ static void def_import(java_ir* ir, tree_node* node)
  *
  * node: JNT_TOP_LEVEL
 */
-static void def_class(java_ir* ir, tree_node* node)
+static void def_class(java_ir* ir, flat_node* node)
 {
     /**
      * JNT_TOP_LEVEL
@@ -943,65 +942,69 @@ static void def_class(java_ir* ir, tree_node* node)
      *           |
      *           +--- ...
     */
-    tree_node* part = node->first_child;
-    tree_node* probe;
+    flat_node* part = flat_first_child(node);
+    flat_node* probe;
 
     global_top_level* desc = new_global_top_level(TOP_LEVEL_CLASS);
-    char* registered_name = t2s(part->data.id->complex);
-    string_list sl;
+    char* registered_name = t2n(ir, part->data.id.complex);
+    flat_node* unit;
+    size_t num_implement;
+    size_t num_members;
 
     // definition data
-    desc->modifier = node->data.top_level->modifier;
+    desc->modifier = node->data.top_level.modifier;
 
     // [extends, implements, body]
-    part = part->first_child;
+    part = flat_first_child(part);
 
     // extends, this name will be resolved later in linker
     if (part && part->type == JNT_CLASS_EXTENDS)
     {
         // extends->classtype->unit
-        desc->extend = name_unit_concat(part->first_child->first_child, NULL);
-        part = part->next_sibling;
+        desc->extend = name_unit_concat(ir, flat_first_child(flat_first_child(part)), NULL);
+        part = flat_next_sibling(part);
     }
 
     // implements, names will be resolved later in linker
     if (part && part->type == JNT_CLASS_IMPLEMENTS)
     {
         // implements->list->interfacetype
-        probe = part->first_child->first_child;
+        probe = flat_first_child(flat_first_child(part));
 
-        // extract all names
-        init_string_list(&sl);
-        while (probe)
+        // count all names
+        num_implement = 0;
+        for (unit = probe; unit; unit = flat_next_sibling(unit))
         {
-            string_list_append(&sl, name_unit_concat(probe->first_child, NULL), false);
-            probe = probe->next_sibling;
+            num_implement++;
         }
 
-        // concat all names
-        desc->implement = string_list_to_string_array(&sl);
-        desc->num_implement = sl.count;
-        release_string_list(&sl);
+        // extract all names
+        desc->implement = (char**)malloc_assert(sizeof(char*) * num_implement);
+        desc->num_implement = num_implement;
+        for (size_t i = 0; probe; i++)
+        {
+            desc->implement[i] = name_unit_concat(ir, flat_first_child(probe), NULL);
+            probe = flat_next_sibling(probe);
+        }
 
-        part = part->next_sibling;
+        part = flat_next_sibling(part);
     }
 
     // now we must have class body
     // otherwise it should not pass syntax parser
 
     // log first body declaration
-    desc->node_first_body_decl = part->first_child;
+    desc->node_first_body_decl = flat_first_child(part);
 
     // setup lookup hierarchy
     lookup_top_level_begin(ir, desc);
 
     // class register with import name conflict check
-    if (shash_table_get(&ir->tbl_import, registered_name) ||
-        !lookup_register(ir, lookup_global_scope(ir), &registered_name, &desc, JAVA_E_MAX))
+    if (ihash_table_get(&ir->tbl_import, registered_name) ||
+        !lookup_register(ir, lookup_global_scope(ir), registered_name, &desc, JAVA_E_MAX))
     {
         ir_error(ir, JAVA_E_CLASS_NAME_DUPLICATE);
 
-        free(registered_name);
         delete_global_top_level(desc);
         lookup_top_level_end(ir);
 
@@ -1012,30 +1015,61 @@ static void def_class(java_ir* ir, tree_node* node)
     ////////// desc is NULL after this line //////////
 
     // each part is a class body declaration
-    part = part->first_child;
+    part = flat_first_child(part);
+
+    // count members first so member table never grows while registering
+    num_members = 0;
+    for (unit = part; unit; unit = flat_next_sibling(unit))
+    {
+        probe = flat_first_child(unit);
+
+        if (probe->type == JNT_CTOR_DECL)
+        {
+            num_members++;
+        }
+        else if (probe->type == JNT_TYPE)
+        {
+            probe = flat_next_sibling(probe);
+
+            if (probe->type == JNT_METHOD_DECL)
+            {
+                num_members++;
+            }
+            else if (probe->type == JNT_VAR_DECLARATORS)
+            {
+                // one member per declarator
+                for (probe = flat_first_child(probe); probe; probe = flat_next_sibling(probe))
+                {
+                    num_members++;
+                }
+            }
+        }
+    }
+
+    hash_table_reserve(lookup_top_level_scope(ir), num_members);
 
     // register definitions
     while (part)
     {
         // class body declaration -> [static|ctor|type]
-        probe = part->first_child;
+        probe = flat_first_child(part);
 
         if (probe->type == JNT_CTOR_DECL)
         {
-            def_constructor(ir, probe, part->data.top_level->modifier);
+            def_constructor(ir, probe, part->data.top_level.modifier);
         }
         else if (probe->type == JNT_TYPE)
         {
             /**
              * Type as starter, it can be method/variable declarator
             */
-            switch (probe->next_sibling->type)
+            switch (flat_next_sibling(probe)->type)
             {
                 case JNT_VAR_DECLARATORS:
-                    def_vars(ir, probe, part->data.top_level->modifier, VARIABLE_KIND_MEMBER);
+                    def_vars(ir, probe, part->data.top_level.modifier, VARIABLE_KIND_MEMBER);
                     break;
                 case JNT_METHOD_DECL:
-                    def_method(ir, probe, part->data.top_level->modifier);
+                    def_method(ir, probe, part->data.top_level.modifier);
                     ir->working_top_level->num_methods++;
                     break;
                 default:
@@ -1043,7 +1077,7 @@ static void def_class(java_ir* ir, tree_node* node)
             }
         }
 
-        part = part->next_sibling;
+        part = flat_next_sibling(part);
     }
 
     ir->working_top_level->num_fields = ir->walk_state.num_member_variable;
@@ -1059,7 +1093,7 @@ static void def_class(java_ir* ir, tree_node* node)
  *
  * node: JNT_TOP_LEVEL
 */
-static void def_interface(java_ir* ir, tree_node* node)
+static void def_interface(java_ir* ir, flat_node* node)
 {
     global_top_level* desc = new_global_top_level(TOP_LEVEL_INTERFACE);
 
@@ -1084,7 +1118,7 @@ static void def_interface(java_ir* ir, tree_node* node)
  *
  * node: JNT_UNIT
 */
-void def_global(java_ir* ir, tree_node* compilation_unit)
+void def_global(java_ir* ir, flat_node* compilation_unit)
 {
     /**
      * JNT_UNIT
@@ -1095,7 +1129,7 @@ void def_global(java_ir* ir, tree_node* compilation_unit)
      * |
      * +--- {JNT_CLASS_DECL|JNT_INTERFACE_DECL}
     */
-    tree_node* node = compilation_unit->first_child;
+    flat_node* node = flat_first_child(compilation_unit);
 
     // package
     if (node && node->type == JNT_PKG_DECL)
@@ -1103,21 +1137,21 @@ void def_global(java_ir* ir, tree_node* compilation_unit)
         /**
          * TODO: handle pkg decl
         */
-        node = node->next_sibling;
+        node = flat_next_sibling(node);
     }
 
     // imports
     while (node && node->type == JNT_IMPORT_DECL)
     {
         def_import(ir, node);
-        node = node->next_sibling;
+        node = flat_next_sibling(node);
     }
 
     // top-levels
     while (node && node->type == JNT_TOP_LEVEL)
     {
         // handle top level
-        if (node->first_child->type == JNT_CLASS_DECL)
+        if (flat_first_child(node)->type == JNT_CLASS_DECL)
         {
             def_class(ir, node);
         }
@@ -1126,6 +1160,6 @@ void def_global(java_ir* ir, tree_node* compilation_unit)
             def_interface(ir, node);
         }
 
-        node = node->next_sibling;
+        node = flat_next_sibling(node);
     }
 }
@@ -326,82 +326,370 @@ void cfg_delete_node_order(basic_block** list)
 }
 
 /**
- * Calculate Immediate Dominator Set
+ * SEMI-NCA: path compression on DFS spanning forest
  *
- * according to definition: immediate dominator of node n, IDOM(n), has
- * exactly one node: for any node p, there does not exist node q, such that:
- * p DOM q DOM n, AND p DOM n
+ * forest links are ancestor[], numbers are DFS preorder; after it
+ * returns, label[v] has minimum semi on the compressed path
+*/
+static void semi_nca_compress(size_t v, size_t* ancestor, size_t* label, const size_t* semi, size_t* stack)
+{
+    size_t top = 0;
+    size_t u;
+
+    // collect path up to the node right below a forest root
+    for (u = v; ancestor[ancestor[u]] != DOM_TREE_NONE; u = ancestor[u])
+    {
+        stack[top++] = u;
+    }
+
+    // compress top down
+    while (top)
+    {
+        u = stack[--top];
+
+        if (semi[label[ancestor[u]]] < semi[label[u]])
+        {
+            label[u] = label[ancestor[u]];
+        }
+
+        ancestor[u] = ancestor[ancestor[u]];
+    }
+}
+
+/**
+ * number dominator tree nodes in DFS pre and post order
+*/
+static void dom_tree_number(dom_tree* tree, size_t root)
+{
+    size_t* stack = (size_t*)malloc_assert(sizeof(size_t) * tree->num_nodes);
+    size_t* next = (size_t*)malloc_assert(sizeof(size_t) * tree->num_nodes);
+    size_t top = 0;
+    size_t pre = 0;
+    size_t post = 0;
+    size_t v;
+
+    stack[top++] = root;
+    next[root] = tree->child[root];
+    tree->pre[root] = pre++;
+
+    while (top)
+    {
+        v = stack[top - 1];
+
+        if (next[v] != DOM_TREE_NONE)
+        {
+            size_t c = next[v];
+
+            next[v] = tree->sibling[c];
+            next[c] = tree->child[c];
+            tree->pre[c] = pre++;
+            stack[top++] = c;
+        }
+        else
+        {
+            tree->post[v] = post++;
+            top--;
+        }
+    }
+
+    free(stack);
+    free(next);
+}
+
+/**
+ * Build Dominator Tree
  *
  * Algorithm is based on:
- * A Simple, Fast Dominance Algorithm by Cooper et al.
+ * Finding Dominators in Practice by Georgiadis et al. (SEMI-NCA)
  *
- * it returns an array of node reference, where each element
- * represents the IDOM of the node with ID equals to the index
+ * 1. number nodes in DFS preorder, remember spanning tree parents
+ * 2. semidominators in reverse preorder, Lengauer-Tarjan style, using
+ *    path compression over already processed nodes
+ * 3. idom of a node is the nearest common ancestor of its parent
+ *    and semidominator in the dominator tree built so far, found by
+ *    climbing from parent while above semidominator
+ *
+ * all per-node work data is indexed by DFS number
 */
-basic_block** cfg_idom(const cfg* g, basic_block** postorder)
+void init_dom_tree(dom_tree* tree, const cfg* g)
 {
     size_t num_nodes = g->nodes.num;
-    size_t* idx_node2post = (size_t*)malloc_assert(sizeof(size_t) * num_nodes);
-    basic_block** idom = (basic_block**)malloc_assert(sizeof(basic_block*) * num_nodes);
-    bool changed = true;
-
-    // initialize dominators array
-    memset(idom, 0, sizeof(basic_block*) * num_nodes);
+    size_t sz = sizeof(size_t) * num_nodes;
+    size_t* dfnum = (size_t*)malloc_assert(sz);
+    size_t* parent = (size_t*)malloc_assert(sz);
+    size_t* semi = (size_t*)malloc_assert(sz);
+    size_t* label = (size_t*)malloc_assert(sz);
+    size_t* ancestor = (size_t*)malloc_assert(sz);
+    size_t* idom = (size_t*)malloc_assert(sz);
+    size_t* nc = (size_t*)malloc_assert(sz);
+    size_t* stack = (size_t*)malloc_assert(sz);
+    basic_block** vertex = (basic_block**)malloc_assert(sizeof(basic_block*) * num_nodes);
+    size_t num_reached = 0;
+    size_t top = 0;
+
+    tree->num_nodes = num_nodes;
+    tree->idom = (basic_block**)malloc_assert(sizeof(basic_block*) * num_nodes);
+    tree->child = (size_t*)malloc_assert(sz);
+    tree->sibling = (size_t*)malloc_assert(sz);
+    tree->pre = (size_t*)malloc_assert(sz);
+    tree->post = (size_t*)malloc_assert(sz);
 
-    // initialize node-to-postorder-index map
     for (size_t i = 0; i < num_nodes; i++)
     {
-        idx_node2post[postorder[i]->id] = i;
+        dfnum[i] = DOM_TREE_NONE;
+        tree->idom[i] = NULL;
+        tree->child[i] = DOM_TREE_NONE;
+        tree->sibling[i] = DOM_TREE_NONE;
+        tree->pre[i] = DOM_TREE_NONE;
+        tree->post[i] = DOM_TREE_NONE;
+    }
+
+    if (!g->entry)
+    {
+        goto cleanup;
     }
 
-    idom[g->entry->id] = g->entry;
+    // 1. DFS preorder, stack holds DFS numbers
+    dfnum[g->entry->id] = num_reached;
+    vertex[num_reached] = g->entry;
+    parent[num_reached] = DOM_TREE_NONE;
+    nc[num_reached] = 0;
+    stack[top++] = num_reached++;
 
-    while (changed)
+    while (top)
     {
-        changed = false;
+        size_t v = stack[top - 1];
+        basic_block* b = vertex[v];
 
-        for (size_t i = 0; i < num_nodes; i++)
+        if (nc[v] < b->out.num)
+        {
+            basic_block* next = b->out.arr[nc[v]++]->to;
+
+            if (dfnum[next->id] == DOM_TREE_NONE)
+            {
+                dfnum[next->id] = num_reached;
+                vertex[num_reached] = next;
+                parent[num_reached] = v;
+                nc[num_reached] = 0;
+                stack[top++] = num_reached++;
+            }
+        }
+        else
         {
-            basic_block* b = postorder[num_nodes - i - 1]; // traverse in reverse postorder
+            top--;
+        }
+    }
+
+    // 2. semidominators
+    for (size_t v = 0; v < num_reached; v++)
+    {
+        semi[v] = v;
+        label[v] = v;
+        ancestor[v] = DOM_TREE_NONE;
+    }
+
+    for (size_t w = num_reached - 1; w > 0; w--)
+    {
+        basic_block* b = vertex[w];
 
-            if (b == g->entry) { continue; }
+        for (size_t i = 0; i < b->in.num; i++)
+        {
+            size_t v = dfnum[b->in.arr[i]->from->id];
+            size_t u = v;
 
-            basic_block* new_idom = b->in.arr[0]->from; // pick first predecessor ?
+            // unreachable predecessor
+            if (v == DOM_TREE_NONE) { continue; }
 
-            // for all other predecessors
-            for (size_t j = 1; j < b->in.num; j++)
+            // eval: processed nodes are linked into forest
+            if (ancestor[v] != DOM_TREE_NONE)
             {
-                basic_block* pred = b->in.arr[j]->from;
+                semi_nca_compress(v, ancestor, label, semi, stack);
+                u = label[v];
+            }
 
-                if (idom[pred->id] != NULL)
-                {
-                    // fast intersect(pred, new_idom), using their postorder index
-                    // converge to same node, hence a dominator
-                    while (new_idom != pred)
-                    {
-                        while (idx_node2post[new_idom->id] < idx_node2post[pred->id])
-                        {
-                            new_idom = idom[new_idom->id];
-                        }
-                        while (idx_node2post[pred->id] < idx_node2post[new_idom->id])
-                        {
-                            pred = idom[pred->id];
-                        }
-                    }
-                }
+            semi[w] = min(semi[w], semi[u]);
+        }
+
+        // link
+        ancestor[w] = parent[w];
+    }
+
+    // 3. nearest common ancestor, in preorder so ancestors are final
+    idom[0] = 0;
+
+    for (size_t w = 1; w < num_reached; w++)
+    {
+        size_t d = parent[w];
+
+        while (d > semi[w])
+        {
+            d = idom[d];
+        }
+
+        idom[w] = d;
+    }
+
+    // tree links, children in ascending id order
+    for (size_t i = num_nodes; i > 0; i--)
+    {
+        size_t v = dfnum[i - 1];
+
+        if (v == DOM_TREE_NONE) { continue; }
+
+        tree->idom[i - 1] = vertex[idom[v]];
+
+        if (v != 0)
+        {
+            size_t p = vertex[idom[v]]->id;
+
+            tree->sibling[i - 1] = tree->child[p];
+            tree->child[p] = i - 1;
+        }
+    }
+
+    dom_tree_number(tree, g->entry->id);
+
+cleanup:
+    free(dfnum);
+    free(parent);
+    free(semi);
+    free(label);
+    free(ancestor);
+    free(idom);
+    free(nc);
+    free(stack);
+    free(vertex);
+}
+
+/**
+ * release dominator tree
+*/
+void release_dom_tree(dom_tree* tree)
+{
+    free(tree->idom);
+    free(tree->child);
+    free(tree->sibling);
+    free(tree->pre);
+    free(tree->post);
+
+    tree->idom = NULL;
+    tree->child = NULL;
+    tree->sibling = NULL;
+    tree->pre = NULL;
+    tree->post = NULL;
+    tree->num_nodes = 0;
+}
+
+/**
+ * test if a dominates b, O(1)
+ *
+ * every node dominates itself
+*/
+bool dom_tree_dominates(const dom_tree* tree, const basic_block* a, const basic_block* b)
+{
+    return tree->pre[a->id] != DOM_TREE_NONE &&
+        tree->pre[a->id] <= tree->pre[b->id] &&
+        tree->post[b->id] <= tree->post[a->id];
+}
+
+/**
+ * Calculate Dominance Frontier (DF) Set From Dominator Tree
+ *
+ * Algorithm is based on:
+ * Efficiently Computing Static Single Assignment Form and the
+ * Control Dependence Graph by Cytron et al.
+ *
+ * nodes are visited in tree postorder, so children are done first:
+ * DF(b) = DF_local(b) union DF_up(c), c is every child of b
+ * DF_local(b): successors s of b, idom(s) != b
+ * DF_up(c): w in DF(c), idom(w) != b
+ *
+ * entry is its own idom, so like before it never lands in its own
+ * DF set, even if it is a loop header
+ *
+ * it returns an array of index set, where each element
+ * represents the DF set of the node with ID equals to the index;
+ * use cfg_delete_dominance_frontiers() to delete it
+*/
+index_set* dom_tree_frontiers(const dom_tree* tree, const cfg* g)
+{
+    size_t num_nodes = tree->num_nodes;
+    index_set* df = (index_set*)malloc_assert(sizeof(index_set) * num_nodes);
+    size_t* by_post = (size_t*)malloc_assert(sizeof(size_t) * num_nodes);
+    size_t num_reached = 0;
+    index_set_iterator it;
+
+    for (size_t i = 0; i < num_nodes; i++)
+    {
+        init_index_set(&df[i], num_nodes);
+
+        if (tree->post[i] != DOM_TREE_NONE)
+        {
+            by_post[tree->post[i]] = i;
+            num_reached++;
+        }
+    }
+
+    for (size_t k = 0; k < num_reached; k++)
+    {
+        basic_block* b = g->nodes.arr[by_post[k]];
+
+        // local
+        for (size_t i = 0; i < b->out.num; i++)
+        {
+            basic_block* s = b->out.arr[i]->to;
+
+            if (tree->idom[s->id] != b)
+            {
+                index_set_add(&df[b->id], s->id);
             }
+        }
 
-            // update
-            if (idom[b->id] != new_idom)
+        // up
+        for (size_t c = tree->child[b->id]; c != DOM_TREE_NONE; c = tree->sibling[c])
+        {
+            for (index_set_iterator_init(&it, &df[c]); !index_set_iterator_end(&it); index_set_iterator_next(&it))
             {
-                idom[b->id] = new_idom;
-                changed = true;
+                size_t w = index_set_iterator_get(&it);
+
+                if (tree->idom[w] != b)
+                {
+                    index_set_add(&df[b->id], w);
+                }
             }
+
+            index_set_iterator_release(&it);
         }
     }
 
-    // cleanup
-    free(idx_node2post);
+    free(by_post);
+
+    return df;
+}
+
+/**
+ * Calculate Immediate Dominator Set
+ *
+ * according to definition: immediate dominator of node n, IDOM(n), has
+ * exactly one node: for any node p, there does not exist node q, such that:
+ * p DOM q DOM n, AND p DOM n
+ *
+ * it returns an array of node reference, where each element
+ * represents the IDOM of the node with ID equals to the index,
+ * taken from the dominator tree
+*/
+basic_block** cfg_idom(const cfg* g)
+{
+    dom_tree tree;
+    basic_block** idom;
+
+    init_dom_tree(&tree, g);
+
+    // detach
+    idom = tree.idom;
+    tree.idom = NULL;
+
+    release_dom_tree(&tree);
 
     return idom;
 }
@@ -3,77 +3,193 @@
 /**
  * lookup hierarchy table pair deleter
  *
+ * key is interned so it is not owned
 */
 void definition_lookup_deleter(char* k, definition* v)
+{
+    definition_delete(v);
+}
+
+/**
+ * literal table pair deleter
+*/
+void literal_lookup_deleter(char* k, definition* v)
 {
     free(k);
     definition_delete(v);
 }
 
 /**
- * push a new lookup node
+ * initial number of scope entries and marks
+*/
+#define SCOPE_TABLE_INIT_SIZE 32
+
+/**
+ * initialize local symbol lookup
 */
-hash_table* lookup_new_scope(java_ir* ir)
+void init_scope_table(scope_table* table)
 {
-    scope_frame* scope = (scope_frame*)malloc_assert(sizeof(scope_frame));
+    init_flat_hash_table(&table->lookup, SCOPE_TABLE_INIT_SIZE);
 
-    // init
-    scope->table = (hash_table*)malloc_assert(sizeof(hash_table));
-    init_hash_table(scope->table, HASH_TABLE_DEFAULT_BUCKET_SIZE);
+    table->entries = (scope_entry*)malloc_assert(sizeof(scope_entry) * SCOPE_TABLE_INIT_SIZE);
+    table->num_entries = 0;
+    table->size_entries = SCOPE_TABLE_INIT_SIZE;
+
+    table->marks = (size_t*)malloc_assert(sizeof(size_t) * SCOPE_TABLE_INIT_SIZE);
+    table->num_marks = 0;
+    table->size_marks = SCOPE_TABLE_INIT_SIZE;
+}
+
+/**
+ * release local symbol lookup
+ *
+ * scopes must be popped first, entries are not released here
+*/
+void release_scope_table(scope_table* table)
+{
+    release_hash_table(&table->lookup, NULL);
+    free(table->entries);
+    free(table->marks);
+
+    table->entries = NULL;
+    table->num_entries = 0;
+    table->size_entries = 0;
+    table->marks = NULL;
+    table->num_marks = 0;
+    table->size_marks = 0;
+}
+
+/**
+ * push a new lookup node
+*/
+void lookup_new_scope(java_ir* ir)
+{
+    scope_table* table = &ir->scope;
 
-    // push
-    scope->next = ir->scope_stack_top;
-    ir->scope_stack_top = scope;
+    if (table->num_marks >= table->size_marks)
+    {
+        table->size_marks *= 2;
+        table->marks = (size_t*)realloc_assert(table->marks, sizeof(size_t) * table->size_marks);
+    }
 
-    return scope->table;
+    table->marks[table->num_marks++] = table->num_entries;
 }
 
 /**
  * pop current lookup node
  *
- * if merge_global is true, table contents will be merged into global lookup
- *
- * TODO: deprecate merge_global logic
- * instead of merging into the global table, we merge it into a pool that only contains
- * local definitions: the pool is a linked list, O(1) insert front and we do not
- * care the order because we only book-keep the data so that code graphs can reference
- * from it
+ * entries of current scope are undone, newest first, and their
+ * definitions are flushed into pool in declaration order; if pool
+ * is NULL, definitions are deleted
 */
 bool lookup_pop_scope(java_ir* ir, definition_pool* pool)
 {
-    scope_frame* top = ir->scope_stack_top;
+    scope_table* table = &ir->scope;
+    scope_entry* e;
+    hash_pair* p;
+    size_t mark;
+
+    if (!table->num_marks)
+    {
+        return false;
+    }
+
+    mark = table->marks[--table->num_marks];
 
     // flush all definitions into the pool
-    if (top)
+    for (size_t i = mark; i < table->num_entries; i++)
     {
-        hash_table* table = top->table;
+        e = &table->entries[i];
 
         if (pool)
         {
-            for (size_t i = 0; i < table->bucket_size; i++)
-            {
-                hash_pair* p = table->bucket[i];
-
-                while (p)
-                {
-                    // move to pool
-                    definition_pool_add(pool, p->value);
-                    p->value = NULL;
-                    p = p->next;
-                }
-            }
+            definition_pool_add(pool, e->desc);
+        }
+        else
+        {
+            definition_delete(e->desc);
         }
+    }
 
-        // release table
-        release_hash_table(top->table, &definition_lookup_deleter);
-        free(top->table);
-        ir->scope_stack_top = top->next;
-        free(top);
+    // undo: unshadow outer entries
+    while (table->num_entries > mark)
+    {
+        e = &table->entries[--table->num_entries];
+        p = ihash_table_get(&table->lookup, e->name);
+        p->value = (void*)e->shadow;
+    }
 
-        return true;
+    // nothing is in scope, forget names
+    if (!table->num_marks)
+    {
+        reset_hash_table(&table->lookup);
     }
 
-    return false;
+    return true;
+}
+
+/**
+ * test if any local scope is active
+*/
+bool lookup_in_scope(java_ir* ir)
+{
+    return ir->scope.num_marks > 0;
+}
+
+/**
+ * innermost local definition of a name, NULL if not in scope
+ *
+ * name must be interned
+*/
+scope_entry* lookup_scope_find(java_ir* ir, const char* name)
+{
+    scope_table* table = &ir->scope;
+    hash_pair* p;
+
+    if (!table->num_entries)
+    {
+        return NULL;
+    }
+
+    p = ihash_table_get(&table->lookup, name);
+
+    return p && p->value ? &table->entries[(size_t)p->value - 1] : NULL;
+}
+
+/**
+ * register a definition in current local scope
+ *
+ * it shadows any outer entry of the same name; duplication check
+ * is done by caller
+ *
+ * name must be interned
+*/
+void lookup_scope_register(java_ir* ir, char* name, definition* desc)
+{
+    scope_table* table = &ir->scope;
+    hash_pair* p = ihash_table_get(&table->lookup, name);
+    scope_entry* e;
+
+    if (table->num_entries >= table->size_entries)
+    {
+        table->size_entries *= 2;
+        table->entries = (scope_entry*)realloc_assert(table->entries, sizeof(scope_entry) * table->size_entries);
+    }
+
+    e = &table->entries[table->num_entries++];
+    e->name = name;
+    e->desc = desc;
+
+    if (p)
+    {
+        e->shadow = (size_t)p->value;
+        p->value = (void*)table->num_entries;
+    }
+    else
+    {
+        e->shadow = 0;
+        ihash_table_insert(&table->lookup, name, (void*)table->num_entries);
+    }
 }
 
 /**
@@ -106,20 +222,6 @@ hash_table* lookup_top_level_literal_scope(java_ir* ir)
     return ir->working_top_level ? &ir->working_top_level->tbl_literal : NULL;
 }
 
-/**
- * get hierarchical scope
- *
- * TYPE: map<string, definition*>
- *
- * all definitions can go as high as ir->working_top_level, global
- * is higher but it only stores reserved names (global_top_level)
- * instead of definitions
-*/
-hash_table* lookup_working_scope(java_ir* ir)
-{
-    return ir->scope_stack_top ? ir->scope_stack_top->table : lookup_top_level_scope(ir);
-}
-
 /**
  * attach top level definition to lookup hierarchy
 */
@@ -150,27 +252,28 @@ static void __init_type_name(type_name* t)
  *
  * when passing error code JAVA_E_MAX, no error will be logged
  *
- * NOTE: if failed, name and desc will stay as-is
+ * name must be interned
+ *
+ * NOTE: if failed, desc will stay as-is
 */
 bool lookup_register(
     java_ir* ir,
     hash_table* table,
-    char** name,
+    char* name,
     void** desc,
     java_error_id err
 )
 {
-    if (shash_table_test(table, *name))
+    if (ihash_table_test(table, name))
     {
         ir_error(ir, err);
         return false;
     }
     else
     {
-        shash_table_insert(table, *name, *desc);
+        ihash_table_insert(table, name, *desc);
 
         // detach
-        *name = NULL;
         *desc = NULL;
 
         return true;
@@ -193,6 +296,7 @@ definition* new_definition(definition_type type)
             v->variable = (definition_variable*)malloc_assert(sizeof(definition_variable));
             v->variable->kind = VARIABLE_KIND_MAX;
             v->variable->modifier = JLT_UNDEFINED;
+            memset(&v->variable->allocation, 0, sizeof(register_allocation_info));
             __init_type_name(&v->variable->type);
             break;
         case DEFINITION_METHOD:
@@ -236,11 +340,9 @@ void definition_delete(definition* v)
     switch (v->type)
     {
         case DEFINITION_VARIABLE:
-            free(v->variable->type.reference);
             free(v->variable);
             break;
         case DEFINITION_METHOD:
-            free(v->method->return_type.reference);
             free(v->method->parameters);
             release_definition_pool(&v->method->local_variables);
             release_cfg(&v->method->code);
@@ -280,7 +382,6 @@ definition* definition_copy(definition* v)
         case DEFINITION_VARIABLE:
             w->variable = (definition_variable*)malloc_assert(sizeof(definition_variable));
             memcpy(w->variable, v->variable, sizeof(definition_variable));
-            w->variable->type.reference = strmcpy_assert(v->variable->type.reference);
             break;
         case DEFINITION_METHOD:
             w->method = (definition_method*)malloc_assert(sizeof(definition_method));
@@ -291,7 +392,6 @@ definition* definition_copy(definition* v)
              * so we leave it empty
             */
             fprintf(stderr, "TODO ERROR: internal error: method copy detected, but it is not implemented yet.\n");
-            w->method->return_type.reference = strmcpy_assert(v->method->return_type.reference);
             memset(&w->method->local_variables, 0, sizeof(definition_pool));
             memset(&w->method->code, 0, sizeof(cfg));
             break;
@@ -16,13 +16,14 @@ static const architecture default_arch = { .bits = ARCH_64_BIT };
  * Context Analysis Entry Point
  *
 */
-void contextualize(java_ir* ir, architecture* arch, tree_node* compilation_unit)
+void contextualize(java_ir* ir, architecture* arch, flat_node* compilation_unit)
 {
     // register architecture of current target
     ir->arch = arch ? arch : &default_arch;
 
-    tree_node* node = compilation_unit->first_child;
+    flat_node* node = flat_first_child(compilation_unit);
     global_top_level* top;
+    hash_table_iterator it;
 
     /**
      * state init
@@ -40,25 +41,22 @@ void contextualize(java_ir* ir, architecture* arch, tree_node* compilation_unit)
      * now we have all defs in place, we can start generating code
      *
     */
-    for (size_t i = 0; i < ir->tbl_global.bucket_size; i++)
+    for (hash_pair* p = hash_table_first(&ir->tbl_global, &it); p != NULL; p = hash_table_next(&ir->tbl_global, &it))
     {
-        for (hash_pair* p = ir->tbl_global.bucket[i]; p != NULL; p = p->next)
-        {
-            top = p->value;
+        top = p->value;
 
-            if (!top) { continue; }
+        if (!top) { continue; }
 
-            switch (top->type)
-            {
-                case TOP_LEVEL_CLASS:
-                    walk_class(ir, top);
-                    break;
-                case TOP_LEVEL_INTERFACE:
-                    walk_interface(ir, top);
-                    break;
-                default:
-                    break;
-            }
+        switch (top->type)
+        {
+            case TOP_LEVEL_CLASS:
+                walk_class(ir, top);
+                break;
+            case TOP_LEVEL_INTERFACE:
+                walk_interface(ir, top);
+                break;
+            default:
+                break;
         }
     }
 }
@@ -235,9 +235,9 @@ typedef enum
 typedef struct _expression_walk_stack_frame
 {
     // basic: the operator node
-    tree_node* operator;
+    flat_node* operator;
     // basic: the child to be processed
-    tree_node* operator_next_child;
+    flat_node* operator_next_child;
     // basic: number of operand required
     size_t num_required_operand;
     // basic: number of walked child nodes
@@ -259,7 +259,7 @@ typedef struct _expression_walk_stack_frame
     struct _expression_walk_stack_frame* next;
 } expression_walk_stack;
 
-static void expression_walk_stack_push(java_ir* ir, expression_walk_stack** stack, tree_node* operator)
+static void expression_walk_stack_push(java_ir* ir, expression_walk_stack** stack, flat_node* operator)
 {
     if (!stack || operator->type != JNT_EXPRESSION) { return; }
 
@@ -267,8 +267,8 @@ static void expression_walk_stack_push(java_ir* ir, expression_walk_stack** stac
 
     // initialize basics
     s->operator = operator;
-    s->operator_next_child = operator->first_child;
-    s->num_required_operand = expr_opid_operand_count(ir->expression, operator->data.expression->op);
+    s->operator_next_child = flat_first_child(operator);
+    s->num_required_operand = expr_opid_operand_count(ir->expression, operator->data.expression.op);
     s->num_walked_children = 0;
     s->next = *stack;
 
@@ -291,7 +291,7 @@ static void expression_walk_stack_push(java_ir* ir, expression_walk_stack** stac
     s->var_return = NULL;
 
     // initialize current basic block context
-    switch (operator->data.expression->op)
+    switch (operator->data.expression.op)
     {
         case OPID_TERNARY_1:
             s->var_return = def_tmp(ir);
@@ -300,7 +300,7 @@ static void expression_walk_stack_push(java_ir* ir, expression_walk_stack** stac
         case OPID_LOGIC_AND:
             // optimize: if both are primary, 
             // then logical "and" is equivalent to bit-wise "and"
-            if (operator->first_child->type == JNT_PRIMARY && operator->last_child->type == JNT_PRIMARY)
+            if (flat_first_child(operator)->type == JNT_PRIMARY && flat_last_child(operator)->type == JNT_PRIMARY)
             {
                 // by default, opid will be mapped to bit-wise irop
                 s->block_context = EXPRESSION_BLOCK_DEFAULT;
@@ -314,7 +314,7 @@ static void expression_walk_stack_push(java_ir* ir, expression_walk_stack** stac
         case OPID_LOGIC_OR:
             // optimize: if both are primary, 
             // then logical "or" is equivalent to bit-wise "or"
-            if (operator->first_child->type == JNT_PRIMARY && operator->last_child->type == JNT_PRIMARY)
+            if (flat_first_child(operator)->type == JNT_PRIMARY && flat_last_child(operator)->type == JNT_PRIMARY)
             {
                 // by default, opid will be mapped to bit-wise irop
                 s->block_context = EXPRESSION_BLOCK_DEFAULT;
@@ -421,7 +421,7 @@ typedef enum
  *
  * node: JNT_PRIMARY
 */
-static reference* walk_operand(java_ir* ir, tree_node* base)
+static reference* walk_operand(java_ir* ir, flat_node* base)
 {
     // this is not a guard: an operand can be marked as not-needed (thus NULL)
     // if so, the function is no-op
@@ -437,7 +437,7 @@ static reference* walk_operand(java_ir* ir, tree_node* base)
     operand_bound_state bound_state = OPERAND_BOUND_FIRST;
 
     // locate first primary item
-    base = base->first_child;
+    base = flat_first_child(base);
 
     /**
      * TODO: other primary types
@@ -455,24 +455,14 @@ static reference* walk_operand(java_ir* ir, tree_node* base)
         switch (base->type)
         {
             case JNT_PRIMARY_COMPLEX:
-                token = base->data.id->complex;
-                content = t2s(token);
-
-                // try get literal definition
-                // if token is not literal, funtion is no-op and NULL is returned
-                __def = def_li(ir, &content, token->type, token->number.type, token->number.bits);
+                token = base->data.id.complex;
 
                 /**
                  * TODO: interpret all token types
                  * TODO: this includes sequence of JT_IDENTIFIER
                  *       as field access
                 */
-                if (__def)
-                {
-                    ref->type = IR_ASN_REF_LITERAL;
-                    ref->def = __def;
-                }
-                else if (token->class == JT_IDENTIFIER)
+                if (token->class == JT_IDENTIFIER)
                 {
                     /**
                      * TODO: now we need to way to enforce lookup-from scope
@@ -482,7 +472,7 @@ static reference* walk_operand(java_ir* ir, tree_node* base)
                      * field access point, if there is none, it has to be current
                      * top-level scope (only)
                     */
-                    __def = use(ir, content, DU_CTL_LOOKUP_TOP_LEVEL, JAVA_E_REF_UNDEFINED);
+                    __def = use(ir, t2n(ir, token), DU_CTL_LOOKUP_TOP_LEVEL, JAVA_E_REF_UNDEFINED);
 
                     // progress counter for current CFG
                     if (is_def_member_variable(__def))
@@ -498,8 +488,22 @@ static reference* walk_operand(java_ir* ir, tree_node* base)
                      * TODO: how to handle field access?
                     */
                 }
+                else
+                {
+                    content = t2s(token);
+
+                    // try get literal definition
+                    // if token is not literal, funtion is no-op and NULL is returned
+                    __def = def_li(ir, &content, token->type, token->number.type, token->number.bits);
 
-                free(content);
+                    if (__def)
+                    {
+                        ref->type = IR_ASN_REF_LITERAL;
+                        ref->def = __def;
+                    }
+
+                    free(content);
+                }
                 break;
             case JNT_PRIMARY_SIMPLE:
                 /**
@@ -520,7 +524,7 @@ static reference* walk_operand(java_ir* ir, tree_node* base)
                  * current local scope
                  * "super" is parent class
                 */
-                switch (base->data.id->simple)
+                switch (base->data.id.simple)
                 {
                     case JLT_RWD_TRUE:
                         def_li_raw(ir, "true", JLT_RWD_TRUE, JT_NUM_MAX, JT_NUM_BIT_LENGTH_NORMAL);
@@ -615,7 +619,7 @@ static reference* walk_operand(java_ir* ir, tree_node* base)
                 break;
         }
 
-        base = base->next_sibling;
+        base = flat_next_sibling(base);
     }
 
     return ref;
@@ -628,7 +632,7 @@ static reference* walk_operand(java_ir* ir, tree_node* base)
  *
  * node (root of expression): JNT_EXPRESSION | JNT_PRIMARY
 */
-static definition* walk_expression(java_ir* ir, tree_node* root)
+static definition* walk_expression(java_ir* ir, flat_node* root)
 {
     expression_walk_stack* execution_stack = NULL;
     reference* operand_value;
@@ -677,7 +681,7 @@ static definition* walk_expression(java_ir* ir, tree_node* root)
                         IR_ASN_REF_DEFINITION,
                         execute_opid_instruction(
                             ir,
-                            execution_stack->operator->data.expression->op,
+                            execution_stack->operator->data.expression.op,
                             &execution_stack->operands[0],
                             &execution_stack->operands[1]
                         )
@@ -718,7 +722,7 @@ static definition* walk_expression(java_ir* ir, tree_node* root)
 
                     // if first child changes exit, entry node of its parent will be updated as well
                     // this is necessary for ternary operator
-                    if (!execution_stack->operator_next_child->prev_sibling)
+                    if (execution_stack->operator_next_child == flat_first_child(execution_stack->operator))
                     {
                         execution_stack->entry = exit;
                     }
@@ -795,7 +799,7 @@ static definition* walk_expression(java_ir* ir, tree_node* root)
                 // mutate stack block context
                 execution_stack->block_context = blk_ctx == EXPRESSION_BLOCK_LOGICAL_AND ?
                     EXPRESSION_BLOCK_LOGICAL_AND_BRANCH : EXPRESSION_BLOCK_LOGICAL_OR_BRANCH;
-                execution_stack->operator_next_child = execution_stack->operator_next_child->next_sibling;
+                execution_stack->operator_next_child = flat_next_sibling(execution_stack->operator_next_child);
                 break;
             case EXPRESSION_BLOCK_TERNARY:
                 /**
@@ -826,7 +830,7 @@ static definition* walk_expression(java_ir* ir, tree_node* root)
                 // mutate stack block context
                 // for ternary, 2 bodies share another tmp variable for the return of this syntatic sugar
                 execution_stack->block_context = EXPRESSION_BLOCK_TERNARY_BRANCH_TRUE;
-                execution_stack->operator_next_child = execution_stack->operator_next_child->next_sibling;
+                execution_stack->operator_next_child = flat_next_sibling(execution_stack->operator_next_child);
                 execution_stack->var_return = def_tmp(ir);
                 break;
             case EXPRESSION_BLOCK_TERNARY_BRANCH_TRUE:
@@ -847,7 +851,7 @@ static definition* walk_expression(java_ir* ir, tree_node* root)
 
                 // mutate stack block context
                 execution_stack->block_context = EXPRESSION_BLOCK_TERNARY_BRANCH_FALSE;
-                execution_stack->operator_next_child = execution_stack->operator_next_child->next_sibling;
+                execution_stack->operator_next_child = flat_next_sibling(execution_stack->operator_next_child);
                 break;
             case EXPRESSION_BLOCK_TERNARY_BRANCH_FALSE:
             case EXPRESSION_BLOCK_LOGICAL_AND_BRANCH:
@@ -861,7 +865,7 @@ static definition* walk_expression(java_ir* ir, tree_node* root)
                 cfg_worker_jump(TSW(ir), execution_stack->exit, false, true);
 
                 // validate tree
-                if (execution_stack->operator_next_child->next_sibling)
+                if (flat_next_sibling(execution_stack->operator_next_child))
                 {
                     ir_error(ir, JAVA_E_EXPRESSION_TOO_MANY_OPERAND);
                 }
@@ -889,7 +893,7 @@ static definition* walk_expression(java_ir* ir, tree_node* root)
                 // by default, buffer the operand and move on to next
                 execution_stack->operands[execution_stack->num_walked_children] = operand_value;
                 execution_stack->num_walked_children++;
-                execution_stack->operator_next_child = execution_stack->operator_next_child->next_sibling;
+                execution_stack->operator_next_child = flat_next_sibling(execution_stack->operator_next_child);
                 break;
         }
     }
@@ -902,7 +906,7 @@ static definition* walk_expression(java_ir* ir, tree_node* root)
  *
  * It generate a reference of returned definition
 */
-static reference* walk_expression_gen_ref(java_ir* ir, tree_node* root)
+static reference* walk_expression_gen_ref(java_ir* ir, flat_node* root)
 {
     definition* var = walk_expression(ir, root);
     return new_reference(ir->walk_state.last_expression_walk_ref_type, var);
@@ -921,9 +925,9 @@ static reference* walk_expression_gen_ref(java_ir* ir, tree_node* root)
  *
  * node: JNT_EXPRESSION_LIST
 */
-static void __execute_expression_list(java_ir* ir, tree_node* stmt)
+static void __execute_expression_list(java_ir* ir, flat_node* stmt)
 {
-    stmt = stmt->first_child;
+    stmt = flat_first_child(stmt);
 
     while (stmt)
     {
@@ -934,7 +938,7 @@ static void __execute_expression_list(java_ir* ir, tree_node* stmt)
          * of a new one
         */
         walk_expression(ir, stmt);
-        stmt = stmt->next_sibling;
+        stmt = flat_next_sibling(stmt);
     }
 }
 
@@ -957,19 +961,19 @@ static void __execute_expression_list(java_ir* ir, tree_node* stmt)
  *
  * node: JNT_LOCAL_VAR_DECL
 */
-static void __execute_variable_declaration(java_ir* ir, tree_node* stmt)
+static void __execute_variable_declaration(java_ir* ir, flat_node* stmt)
 {
     // JNT_TYPE
-    stmt = stmt->first_child;
+    stmt = flat_first_child(stmt);
 
     // get type definition
-    definition* type = type2def(stmt, DEFINITION_VARIABLE);
+    definition* type = type2def(ir, stmt, DEFINITION_VARIABLE);
     definition* var;
     reference* lvalue;
     reference* operand;
 
     // register from first JNT_VAR_DECL, every id has same type
-    for (stmt = stmt->next_sibling->first_child; stmt != NULL; stmt = stmt->next_sibling)
+    for (stmt = flat_first_child(flat_next_sibling(stmt)); stmt != NULL; stmt = flat_next_sibling(stmt))
     {
         // only move the definition for the last variable
         var = def_var(
@@ -978,7 +982,7 @@ static void __execute_variable_declaration(java_ir* ir, tree_node* stmt)
             &type,
             JLT_UNDEFINED,
             VARIABLE_KIND_LOCAL,
-            stmt->next_sibling ? DU_CTL_DATA_COPY : DU_CTL_DEFAULT
+            flat_next_sibling(stmt) ? DU_CTL_DATA_COPY : DU_CTL_DEFAULT
         );
 
         // only generate code for successful registration
@@ -987,10 +991,10 @@ static void __execute_variable_declaration(java_ir* ir, tree_node* stmt)
         // create variable data chunk reference
         lvalue = new_reference(IR_ASN_REF_DEFINITION, var);
 
-        if (stmt->first_child)
+        if (flat_first_child(stmt))
         {
             // if there is an initializer, parse it
-            operand = walk_expression_gen_ref(ir, stmt->first_child);
+            operand = walk_expression_gen_ref(ir, flat_first_child(stmt));
 
             // assignment code
             execute_irop_instruction(ir, TSW(ir), IROP_ASN, &lvalue, &operand, NULL);
@@ -1034,8 +1038,8 @@ static void __execute_variable_declaration(java_ir* ir, tree_node* stmt)
  *
 */
 
-static void __execute_statement(java_ir* ir, tree_node* stmt);
-static cfg_worker* walk_block(java_ir* ir, tree_node* block, bool use_new_scope);
+static void __execute_statement(java_ir* ir, flat_node* stmt);
+static cfg_worker* walk_block(java_ir* ir, flat_node* block, bool use_new_scope);
 
 /**
  * walk if statement
@@ -1052,14 +1056,14 @@ static cfg_worker* walk_block(java_ir* ir, tree_node* block, bool use_new_scope)
  *
  * node: JNT_STATEMENT_IF
 */
-static void __execute_statement_if(java_ir* ir, tree_node* stmt)
+static void __execute_statement_if(java_ir* ir, flat_node* stmt)
 {
     basic_block* test;
     basic_block* phi;
     reference* var_expr_condition;
 
     // Expression
-    stmt = stmt->first_child;
+    stmt = flat_first_child(stmt);
 
     // parse condition
     var_expr_condition = new_reference(IR_ASN_REF_DEFINITION, walk_expression(ir, stmt));
@@ -1071,7 +1075,7 @@ static void __execute_statement_if(java_ir* ir, tree_node* stmt)
     test = cfg_worker_current_block(TSW(ir));
 
     // Statement (TRUE Branch)
-    stmt = stmt->next_sibling;
+    stmt = flat_next_sibling(stmt);
 
     // branch into TRUE branch
     cfg_worker_next_outbound_strategy(TSW(ir), EDGE_TRUE);
@@ -1091,7 +1095,7 @@ static void __execute_statement_if(java_ir* ir, tree_node* stmt)
     phi = cfg_worker_grow(TSW(ir));
 
     // Statement (FALSE Branch, optional)
-    stmt = stmt->next_sibling;
+    stmt = flat_next_sibling(stmt);
 
     // go back to test node and prepare for false branch
     cfg_worker_jump(TSW(ir), test, true, false);
@@ -1125,9 +1129,9 @@ static void __execute_statement_if(java_ir* ir, tree_node* stmt)
  *
  * node: JNT_STATEMENT_VAR_DECL
 */
-static void __execute_statement_variable_declaration(java_ir* ir, tree_node* stmt)
+static void __execute_statement_variable_declaration(java_ir* ir, flat_node* stmt)
 {
-    __execute_variable_declaration(ir, stmt->first_child);
+    __execute_variable_declaration(ir, flat_first_child(stmt));
 }
 
 /**
@@ -1141,7 +1145,7 @@ static void __execute_statement_variable_declaration(java_ir* ir, tree_node* stm
  *
  * node: JNT_STATEMENT_WHILE
 */
-static void __execute_statement_while(java_ir* ir, tree_node* stmt)
+static void __execute_statement_while(java_ir* ir, flat_node* stmt)
 {
     statement_context* sc = push_statement_context(ir, SCQ_LOOP);
     reference* var_expr_condition;
@@ -1161,7 +1165,7 @@ static void __execute_statement_while(java_ir* ir, tree_node* stmt)
     sc->_continue = cfg_worker_current_block(TSW(ir));
 
     // parse condition
-    stmt = stmt->first_child;
+    stmt = flat_first_child(stmt);
     var_expr_condition = new_reference(IR_ASN_REF_DEFINITION, walk_expression(ir, stmt));
     sc->_test = cfg_worker_current_block(TSW(ir));
 
@@ -1185,7 +1189,7 @@ static void __execute_statement_while(java_ir* ir, tree_node* stmt)
     sc->_break = cfg_worker_grow(TSW(ir));
 
     // Statement (loop body)
-    stmt = stmt->next_sibling;
+    stmt = flat_next_sibling(stmt);
 
     // go back to test node and branch into loop body
     cfg_worker_jump(TSW(ir), sc->_test, true, false);
@@ -1233,7 +1237,7 @@ static void __execute_statement_while(java_ir* ir, tree_node* stmt)
  *
  * node: JNT_STATEMENT_DO
 */
-static void __execute_statement_do(java_ir* ir, tree_node* stmt)
+static void __execute_statement_do(java_ir* ir, flat_node* stmt)
 {
     statement_context* sc = push_statement_context(ir, SCQ_LOOP);
     basic_block* body;
@@ -1245,7 +1249,7 @@ static void __execute_statement_do(java_ir* ir, tree_node* stmt)
      * do not use cfg_worker_grow here: we do not know if
      * current node is empty
      *
-     * NOTE: do NOT use body type stmt->first_child->type
+     * NOTE: do NOT use body type flat_first_child(stmt)->type
      * to determine whether we need a new node. In fact:
      * we need new node no matter what; because otherwise
      * it is impossible for us to know which one is the
@@ -1273,7 +1277,7 @@ static void __execute_statement_do(java_ir* ir, tree_node* stmt)
     sc->_break = cfg_new_basic_block(TSW(ir)->graph);
 
     // Statement (loop body)
-    stmt = stmt->first_child;
+    stmt = flat_first_child(stmt);
     cfg_worker_jump(TSW(ir), body, true, false);
 
     // parse loop body
@@ -1295,7 +1299,7 @@ static void __execute_statement_do(java_ir* ir, tree_node* stmt)
     cfg_worker_jump(TSW(ir), body, false, true);
 
     // parse condition
-    var_expr_condition = new_reference(IR_ASN_REF_DEFINITION, walk_expression(ir, stmt->next_sibling));
+    var_expr_condition = new_reference(IR_ASN_REF_DEFINITION, walk_expression(ir, flat_next_sibling(stmt)));
     execute_irop_instruction(ir, TSW(ir), IROP_TEST, NULL, &var_expr_condition, NULL);
 
     // connect end of expression to break point then stop there
@@ -1326,7 +1330,7 @@ static void __execute_statement_do(java_ir* ir, tree_node* stmt)
  *
  * node: JNT_STATEMENT_FOR
 */
-static void __execute_statement_for(java_ir* ir, tree_node* stmt)
+static void __execute_statement_for(java_ir* ir, flat_node* stmt)
 {
     statement_context* sc = push_statement_context(ir, SCQ_LOOP);
     basic_block* test_expr_start; // loop-back node (NOT continue point!)
@@ -1338,24 +1342,24 @@ static void __execute_statement_for(java_ir* ir, tree_node* stmt)
     lookup_new_scope(ir);
 
     // not sure what it is yet
-    stmt = stmt->first_child;
+    stmt = flat_first_child(stmt);
 
     // for init
     if (stmt->type == JNT_FOR_INIT)
     {
-        switch (stmt->first_child->type)
+        switch (flat_first_child(stmt)->type)
         {
             case JNT_EXPRESSION_LIST:
-                __execute_expression_list(ir, stmt->first_child);
+                __execute_expression_list(ir, flat_first_child(stmt));
                 break;
             case JNT_LOCAL_VAR_DECL:
-                __execute_variable_declaration(ir, stmt->first_child);
+                __execute_variable_declaration(ir, flat_first_child(stmt));
                 break;
             default:
                 break;
         }
 
-        stmt = stmt->next_sibling;
+        stmt = flat_next_sibling(stmt);
     }
 
     // enforce new block, which is condition block
@@ -1366,7 +1370,7 @@ static void __execute_statement_for(java_ir* ir, tree_node* stmt)
     if (stmt->type == JNT_EXPRESSION || stmt->type == JNT_PRIMARY)
     {
         var_expr_condition = new_reference(IR_ASN_REF_DEFINITION, walk_expression(ir, stmt));
-        stmt = stmt->next_sibling;
+        stmt = flat_next_sibling(stmt);
     }
 
     // mark, also makes sure that this node is not empty
@@ -1394,8 +1398,8 @@ static void __execute_statement_for(java_ir* ir, tree_node* stmt)
     cfg_worker_jump(TSW(ir), sc->_continue, true, false);
     if (stmt->type == JNT_FOR_UPDATE)
     {
-        __execute_expression_list(ir, stmt->first_child);
-        stmt = stmt->next_sibling;
+        __execute_expression_list(ir, flat_first_child(stmt));
+        stmt = flat_next_sibling(stmt);
     }
 
     // go back to test node and branch into loop body
@@ -1440,12 +1444,12 @@ static void __execute_statement_for(java_ir* ir, tree_node* stmt)
  *
  * node: JNT_STATEMENT_RETURN
 */
-static void __execute_statement_return(java_ir* ir, tree_node* stmt)
+static void __execute_statement_return(java_ir* ir, flat_node* stmt)
 {
     reference* ref = NULL;
 
     // Expression
-    stmt = stmt->first_child;
+    stmt = flat_first_child(stmt);
 
     if (stmt)
     {
@@ -1469,11 +1473,11 @@ static void __execute_statement_return(java_ir* ir, tree_node* stmt)
 /**
  * walk break statement
  *
- * node->data.id->complex->class = JT_IDENTIFIER will contain the optional ID
+ * node->data.id.complex->class = JT_IDENTIFIER will contain the optional ID
  *
  * node: JNT_STATEMENT_BREAK
 */
-static void __execute_statement_break(java_ir* ir, tree_node* stmt)
+static void __execute_statement_break(java_ir* ir, flat_node* stmt)
 {
     // break is bounded by switch and loop
     statement_context* sc = get_statement_context(ir, SCQ_LOOP | SCQ_SWITCH);
@@ -1486,7 +1490,7 @@ static void __execute_statement_break(java_ir* ir, tree_node* stmt)
         return;
     }
 
-    if (stmt->data.id->complex->class == JT_IDENTIFIER)
+    if (stmt->data.id.complex->class == JT_IDENTIFIER)
     {
         /**
          * TODO: branch to label (additional lookup)
@@ -1523,11 +1527,11 @@ static void __execute_statement_break(java_ir* ir, tree_node* stmt)
 /**
  * walk continue statement
  *
- * node->data.id->complex->class = JT_IDENTIFIER will contain the optional ID
+ * node->data.id.complex->class = JT_IDENTIFIER will contain the optional ID
  *
  * node: JNT_STATEMENT_BREAK
 */
-static void __execute_statement_continue(java_ir* ir, tree_node* stmt)
+static void __execute_statement_continue(java_ir* ir, flat_node* stmt)
 {
     // break is bounded by loop
     statement_context* sc = get_statement_context(ir, SCQ_LOOP);
@@ -1540,7 +1544,7 @@ static void __execute_statement_continue(java_ir* ir, tree_node* stmt)
         return;
     }
 
-    if (stmt->data.id->complex->class == JT_IDENTIFIER)
+    if (stmt->data.id.complex->class == JT_IDENTIFIER)
     {
         /**
          * TODO: branch to label (additional lookup)
@@ -1579,7 +1583,7 @@ static void __execute_statement_continue(java_ir* ir, tree_node* stmt)
  *
  * node: any statement (including JNT_BLOCK)
 */
-static void __execute_statement(java_ir* ir, tree_node* stmt)
+static void __execute_statement(java_ir* ir, flat_node* stmt)
 {
     if (TSW(ir)->cur_blk)
     {
@@ -1635,7 +1639,7 @@ static void __execute_statement(java_ir* ir, tree_node* stmt)
         case JNT_STATEMENT_LABEL:
             break;
         case JNT_STATEMENT_EXPRESSION:
-            walk_expression(ir, stmt->first_child);
+            walk_expression(ir, flat_first_child(stmt));
             break;
         case JNT_STATEMENT_VAR_DECL:
             __execute_statement_variable_declaration(ir, stmt);
@@ -1663,7 +1667,7 @@ static void __execute_statement(java_ir* ir, tree_node* stmt)
  *
  * node: JNT_BLOCK
 */
-static cfg_worker* walk_block(java_ir* ir, tree_node* block, bool use_new_scope)
+static cfg_worker* walk_block(java_ir* ir, flat_node* block, bool use_new_scope)
 {
     // prepare scope lookup
     if (use_new_scope)
@@ -1675,7 +1679,7 @@ static cfg_worker* walk_block(java_ir* ir, tree_node* block, bool use_new_scope)
     push_scope_worker(ir);
 
     // every child is a statement
-    block = block->first_child;
+    block = flat_first_child(block);
     while (block)
     {
         /**
@@ -1694,7 +1698,7 @@ static cfg_worker* walk_block(java_ir* ir, tree_node* block, bool use_new_scope)
             __execute_statement(ir, block);
         }
 
-        block = block->next_sibling;
+        block = flat_next_sibling(block);
     }
 
     /**
@@ -1739,7 +1743,7 @@ static void walk_constructor(java_ir* ir, definition* ctor_def)
      * |
      * +--- JNT_CTOR_BODY
     */
-    tree_node* node = ctor_def->root_code_walk->first_child;
+    flat_node* node = flat_first_child(ctor_def->root_code_walk);
 
     // begin scope
     lookup_new_scope(ir);
@@ -1748,7 +1752,7 @@ static void walk_constructor(java_ir* ir, definition* ctor_def)
     if (node->type == JNT_FORMAL_PARAM_LIST)
     {
         def_params(ir, node, ctor_def->method->parameters);
-        node = node->next_sibling;
+        node = flat_next_sibling(node);
     }
 
     // parse body (use current scope)
@@ -1776,7 +1780,7 @@ static void walk_constructor(java_ir* ir, definition* ctor_def)
 */
 static void walk_field(java_ir* ir, definition* field_def, cfg_worker* field_init_worker)
 {
-    tree_node* declaration = field_def->root_code_walk;
+    flat_node* declaration = field_def->root_code_walk;
     cfg_worker* worker;
     reference* lvalue;
     reference* operand;
@@ -1848,16 +1852,16 @@ static void walk_method(java_ir* ir, definition* method_def)
      * |
      * +--- JNT_METHOD_BODY
     */
-    tree_node* node = method_def->root_code_walk->first_child;
+    flat_node* node = flat_first_child(method_def->root_code_walk);
 
     // begin scope
     lookup_new_scope(ir);
 
     // fill all parameter declarations
-    def_params(ir, node->first_child, method_def->method->parameters);
+    def_params(ir, flat_first_child(node), method_def->method->parameters);
 
     // parse body (use current scope)
-    worker = walk_block(ir, node->next_sibling, false);
+    worker = walk_block(ir, flat_next_sibling(node), false);
 
     // we need to keep all definitions active
     lookup_pop_scope(ir, &worker->variables);
@@ -1885,9 +1889,10 @@ void walk_class(java_ir* ir, global_top_level* class)
     // if ill-formed, no-op
     if (!class) { return; }
 
-    tree_node* part = NULL;
-    tree_node* declaration = NULL;
+    flat_node* part = NULL;
+    flat_node* declaration = NULL;
     definition* desc = NULL;
+    hash_table_iterator it;
     hash_pair* p;
     cfg_worker member_init_worker;
 
@@ -1901,42 +1906,34 @@ void walk_class(java_ir* ir, global_top_level* class)
      * so no need to walk trees from top-level
      * for them, simply walk the table
      *
-     * TODO: but.. this will make field init code
-     * out of order, we need an algorithm to
-     * control it
+     * member table keeps insertion order, so
+     * field init code follows declaration order
     */
-    for (size_t i = 0; i < class->tbl_member.bucket_size; i++)
+    for (p = hash_table_first(&class->tbl_member, &it); p != NULL; p = hash_table_next(&class->tbl_member, &it))
     {
-        p = class->tbl_member.bucket[i];
+        desc = p->value;
 
-        while (p)
+        switch (desc->type)
         {
-            desc = p->value;
-
-            switch (desc->type)
-            {
-                case DEFINITION_VARIABLE:
-                    ir_walk_state_mutate(ir, IR_WALK_CODE_FIELD_INIT);
-                    walk_field(ir, desc, &member_init_worker);
-                    ir_walk_state_sync(ir, IR_WALK_CODE_FIELD_INIT);
-                    break;
-                case DEFINITION_METHOD:
-                    ir_walk_state_mutate(ir, IR_WALK_CODE_WORKER);
-
-                    if (desc->method->is_constructor)
-                    {
-                        walk_constructor(ir, desc);
-                    }
-                    else
-                    {
-                        walk_method(ir, desc);
-                    }
-                    break;
-                default:
-                    break;
-            }
+            case DEFINITION_VARIABLE:
+                ir_walk_state_mutate(ir, IR_WALK_CODE_FIELD_INIT);
+                walk_field(ir, desc, &member_init_worker);
+                ir_walk_state_sync(ir, IR_WALK_CODE_FIELD_INIT);
+                break;
+            case DEFINITION_METHOD:
+                ir_walk_state_mutate(ir, IR_WALK_CODE_WORKER);
 
-            p = p->next;
+                if (desc->method->is_constructor)
+                {
+                    walk_constructor(ir, desc);
+                }
+                else
+                {
+                    walk_method(ir, desc);
+                }
+                break;
+            default:
+                break;
         }
     }
 
@@ -1983,7 +1980,7 @@ void walk_class(java_ir* ir, global_top_level* class)
         */
 
         // reach content
-        declaration = part->first_child;
+        declaration = flat_first_child(part);
 
         if (declaration->type == JNT_STATIC_INIT)
         {
@@ -1992,7 +1989,7 @@ void walk_class(java_ir* ir, global_top_level* class)
             */
         }
 
-        part = part->next_sibling;
+        part = flat_next_sibling(part);
     }
 
     // cleanup
@@ -4,38 +4,42 @@
 
 /**
  * import lookup deleter
+ *
+ * key is interned so it is not owned
 */
 static void import_lookup_deleter(char* k, global_import* v)
 {
-    free(k);
     delete_global_import(v);
 }
 
 /**
  * top-level lookup deleter
+ *
+ * key is interned so it is not owned
 */
 static void top_level_lookup_deleter(char* k, global_top_level* v)
 {
-    free(k);
     delete_global_top_level(v);
 }
 
 /**
  * initialize semantic analysis
 */
-void init_ir(java_ir* ir, java_expression* expression, java_error_logger* logger)
+void init_ir(java_ir* ir, java_expression* expression, intern_table* names, java_error_logger* logger)
 {
     ir->working_top_level = NULL;
-    ir->scope_stack_top = NULL;
     ir->arch = NULL;
     ir->expression = expression;
+    ir->names = names;
     ir->logger = logger;
     ir->scope_workers = NULL;
     ir->statement_contexts = NULL;
 
-    init_hash_table(&ir->tbl_import, HASH_TABLE_DEFAULT_BUCKET_SIZE);
+    init_flat_hash_table(&ir->tbl_import, HASH_TABLE_DEFAULT_BUCKET_SIZE);
     init_hash_table(&ir->tbl_implicit_import, HASH_TABLE_DEFAULT_BUCKET_SIZE);
-    init_hash_table(&ir->tbl_global, HASH_TABLE_DEFAULT_BUCKET_SIZE);
+    init_flat_hash_table(&ir->tbl_global, HASH_TABLE_DEFAULT_BUCKET_SIZE);
+    hash_table_keep_order(&ir->tbl_global);
+    init_scope_table(&ir->scope);
 }
 
 /**
@@ -51,6 +55,7 @@ void release_ir(java_ir* ir)
     release_hash_table(&ir->tbl_global, &top_level_lookup_deleter);
     // delete entire lookup stack
     while (lookup_pop_scope(ir, NULL));
+    release_scope_table(&ir->scope);
 }
 
 /**
@@ -184,6 +189,17 @@ char* t2s(java_token* token)
     return content;
 }
 
+/**
+ * Token-To-Name Helper
+ *
+ * return interned name of a token, which is already there
+ * for identifiers
+*/
+char* t2n(java_ir* ir, java_token* token)
+{
+    return token->name ? token->name : intern_slice(ir->names, token->from, buffer_count(token->from, token->to));
+}
+
 /**
  * Token-To-Definition Helper
  *
@@ -192,36 +208,57 @@ char* t2s(java_token* token)
  *
  * returned definition is a reference, not a copy
 */
-definition* t2d(hash_table* table, java_token* token)
+definition* t2d(java_ir* ir, hash_table* table, java_token* token)
 {
-    char* registered_name = t2s(token);
-    definition* def = shash_table_find(table, registered_name);
-    free(registered_name);
-
-    return def;
+    return ihash_table_find(table, t2n(ir, token));
 }
 
 /**
  * name unit concatenation routine
+ *
+ * returns interned name, a single unit is returned as-is
 */
-char* name_unit_concat(tree_node* from, tree_node* stop_before)
+char* name_unit_concat(java_ir* ir, flat_node* from, flat_node* stop_before)
 {
-    string_list sl;
+    flat_node* unit;
+    size_t len = 0;
     char* s;
+    char* p;
+    char* name;
+
+    if (from == stop_before)
+    {
+        return NULL;
+    }
 
-    // construct name list
-    init_string_list(&sl);
-    while (from != stop_before)
+    if (flat_next_sibling(from) == stop_before)
     {
-        string_list_append(&sl, t2s(from->data.id->complex), false);
-        from = from->next_sibling;
+        return t2n(ir, from->data.id.complex);
     }
 
-    // now we concat the name
-    s = string_list_concat(&sl, ".");
-    release_string_list(&sl);
+    // first pass: total length, with one separator per unit
+    for (unit = from; unit != stop_before; unit = flat_next_sibling(unit))
+    {
+        len += intern_length(t2n(ir, unit->data.id.complex)) + 1;
+    }
 
-    return s;
+    // second pass: concat units with '.'
+    s = (char*)malloc_assert(sizeof(char) * len);
+    p = s;
+    for (unit = from; unit != stop_before; unit = flat_next_sibling(unit))
+    {
+        name = t2n(ir, unit->data.id.complex);
+        len = intern_length(name);
+        memcpy(p, name, len);
+        p += len;
+        *p++ = '.';
+    }
+    p[-1] = '\0';
+
+    name = intern_string(ir->names, s);
+    free(s);
+
+    return name;
 }
 
 /**
@@ -401,7 +438,6 @@ void delete_global_import(global_import* i)
 {
     if (!i) { return; }
 
-    free(i->package_name);
     free(i);
 }
 
@@ -426,8 +462,9 @@ global_top_level* new_global_top_level(top_level_type type)
     top->node_first_body_decl = NULL;
 
     init_definition_pool(&top->member_init_variables);
-    init_hash_table(&top->tbl_member, HASH_TABLE_DEFAULT_BUCKET_SIZE);
-    init_hash_table(&top->tbl_literal, HASH_TABLE_DEFAULT_BUCKET_SIZE);
+    init_flat_hash_table(&top->tbl_member, HASH_TABLE_DEFAULT_BUCKET_SIZE);
+    hash_table_keep_order(&top->tbl_member);
+    init_flat_hash_table(&top->tbl_literal, HASH_TABLE_DEFAULT_BUCKET_SIZE);
 
     return top;
 }
@@ -436,22 +473,15 @@ void delete_global_top_level(global_top_level* top)
 {
     if (!top) { return; }
 
-    // release all implement names
-    for (size_t i = 0; i < top->num_implement; i++)
-    {
-        free(top->implement[i]);
-    }
-
     // delete member init code
     release_definition_pool(&top->member_init_variables);
     release_cfg(top->code_member_init);
 
     // delete all members
     release_hash_table(&top->tbl_member, &definition_lookup_deleter);
-    release_hash_table(&top->tbl_literal, &definition_lookup_deleter);
+    release_hash_table(&top->tbl_literal, &literal_lookup_deleter);
 
     // cleanup
-    free(top->extend);
     free(top->implement);
     free(top->code_member_init);
     free(top);
@@ -4,6 +4,7 @@
 
 #include "types.h"
 #include "hash-table.h"
+#include "intern.h"
 #include "lexer.h"
 #include "expression.h"
 #include "tree.h"
@@ -93,22 +94,48 @@ typedef struct _register_allocation_info
  * Symbol Lookup Hierarchy
  *
  * It is a compile-time dynamic stack trace of
- * current scope
+ * current scope, flattened into one table
  *
- * key is a copy of name string
- * value is various based on scope type it serves
+ * every live local definition is an entry on a single stack;
+ * entries of the same name form a shadowing chain, innermost
+ * first, and lookup maps a name to its innermost entry, so a
+ * lookup is one probe regardless of nesting depth
  *
- * every scope has a counter for instrction numbering
+ * a scope is a mark on the entry stack: entering a scope pushes
+ * current entry count, leaving a scope undoes entries above the
+ * mark, which doubles as the undo log; once grown, neither does
+ * any allocation
+ *
+ * entry indices are stored 1-based so 0 means "no entry"
 */
-typedef struct _scope_frame
+typedef struct
+{
+    /* interned name */
+    char* name;
+    definition* desc;
+    /* 1-based index of shadowed entry, 0 if none */
+    size_t shadow;
+} scope_entry;
+
+typedef struct
 {
     /**
-     * TYPE: hash_table<char*, definition*>
+     * TYPE: hash_table<char*, size_t>
+     *
+     * name -> 1-based index of innermost entry, 0 if out of scope;
+     * pairs are kept until the stack is empty so a name re-entering
+     * scope does not allocate
     */
-    hash_table* table;
-
-    struct _scope_frame* next;
-} scope_frame;
+    hash_table lookup;
+    /* entry stack */
+    scope_entry* entries;
+    size_t num_entries;
+    size_t size_entries;
+    /* entry count at scope entry, one per scope */
+    size_t* marks;
+    size_t num_marks;
+    size_t size_marks;
+} scope_table;
 
 /**
  * type info
@@ -116,6 +143,7 @@ typedef struct _scope_frame
 typedef struct
 {
     java_lexeme_type primitive;
+    /* interned */
     char* reference;
 
     size_t dim;
@@ -394,6 +422,115 @@ typedef struct _cfg
     basic_block* entry;
 } cfg;
 
+/**
+ * no node, for dominator tree links and numbers
+*/
+#define DOM_TREE_NONE ((size_t)-1)
+
+/**
+ * Dominator Tree
+ *
+ * all arrays are indexed by node id; nodes unreachable from entry
+ * are not in the tree: NULL idom, DOM_TREE_NONE numbers
+ *
+ * children of a node are linked in ascending id order
+ *
+ * pre and post are DFS numbers on the tree, so a dominates b if
+ * and only if pre(a) <= pre(b) and post(b) <= post(a)
+*/
+typedef struct
+{
+    size_t num_nodes;
+    // immediate dominator, entry's is entry itself
+    basic_block** idom;
+    // first child
+    size_t* child;
+    // next sibling
+    size_t* sibling;
+    // tree DFS numbers
+    size_t* pre;
+    size_t* post;
+} dom_tree;
+
+/**
+ * Dataflow Direction
+ *
+ * FORWARD: in(b) = meet out(p), p is every predecessor of b
+ *          out(b) = transfer(b, in(b)), visited in reverse postorder
+ * BACKWARD: out(b) = meet in(s), s is every successor of b
+ *           in(b) = transfer(b, out(b)), visited in postorder
+*/
+typedef enum
+{
+    DATAFLOW_FORWARD,
+    DATAFLOW_BACKWARD,
+} dataflow_direction;
+
+typedef struct _dataflow dataflow;
+
+/**
+ * transfer function: result = f(b, source)
+ *
+ * it returns true if result is changed
+*/
+typedef bool (*dataflow_transfer)(dataflow* df, basic_block* b, index_set* result, const index_set* source);
+
+/**
+ * meet function: dest = dest meet src
+*/
+typedef void (*dataflow_meet)(index_set* dest, const index_set* src);
+
+/**
+ * Dataflow Convergence Stats
+*/
+typedef struct
+{
+    // transfer function calls
+    size_t num_visits;
+    // transfer function calls that changed result
+    size_t num_changes;
+    // visits counted in units of all blocks
+    size_t num_passes;
+} dataflow_stats;
+
+/**
+ * Dataflow Problem
+ *
+ * facts are index sets over [0, domain), indexed by block id
+ *
+ * blocks are popped from a worklist by priority, which is their
+ * position in visit order, so each sweep follows visit order and
+ * only changed regions are revisited
+ *
+ * boundary is the fact flowing into entry (forward) or out of the
+ * exits (backward); every other fact starts empty, or full if
+ * init_fill is set, as needed by intersect-style meets
+ *
+ * gen and kill are optional per-block facts for the common
+ * transfer dataflow_transfer_gen_kill: (source - kill) union gen
+*/
+struct _dataflow
+{
+    const cfg* graph;
+    basic_block** order;
+    dataflow_direction direction;
+    dataflow_meet meet;
+    dataflow_transfer transfer;
+    size_t domain;
+    bool init_fill;
+
+    // analysis data for transfer function
+    void* context;
+
+    index_set boundary;
+    index_set* in;
+    index_set* out;
+    index_set* gen;
+    index_set* kill;
+
+    dataflow_stats stats;
+};
+
 /**
  * Definition Pool
 */
@@ -507,7 +644,7 @@ typedef struct _definition
     // local order index id
     size_t lid;
     // internal-only: the code walk root
-    tree_node* root_code_walk;
+    flat_node* root_code_walk;
 
     // typed definition data access
     // pointer-only here!
@@ -607,6 +744,7 @@ typedef struct __statement_context
 */
 typedef struct
 {
+    /* interned */
     char* package_name;
 } global_import;
 
@@ -633,9 +771,9 @@ typedef struct
     top_level_type type;
     // modifier
     lbit_flag modifier;
-    // super (only one super allowed)
+    // super (only one super allowed), interned
     char* extend;
-    // a list of implement names
+    // a list of implement names, interned
     char** implement;
     // number of implement names
     size_t num_implement;
@@ -655,7 +793,7 @@ typedef struct
     /* following fields are internal-use only */
 
     // internal-only: first JNT_CLASS_BODY_DECL node reference
-    tree_node* node_first_body_decl;
+    flat_node* node_first_body_decl;
 } global_top_level;
 
 /**
@@ -700,6 +838,9 @@ typedef struct __ir_walk_state
  *
  * tbl_global: top level implementation, it maps from the name to the
  *             descriptor global_top_level
+ *
+ * all name tables are keyed on interned names (ihash_table_*), only
+ * literal tables use plain string keys
 */
 typedef struct
 {
@@ -712,8 +853,8 @@ typedef struct
 
     // current top level
     global_top_level* working_top_level;
-    // stack top symbol lookup
-    scope_frame* scope_stack_top;
+    // local symbol lookup
+    scope_table scope;
     // scope worker context stack
     cfg_worker_context* scope_workers;
     // statement context stack
@@ -725,12 +866,15 @@ typedef struct
     architecture* arch;
     // expression-related info
     java_expression* expression;
+    // name interning, owned by compiler
+    intern_table* names;
     // error data
     java_error_logger* logger;
 } java_ir;
 
 char* t2s(java_token* token);
-definition* t2d(hash_table* table, java_token* token);
+char* t2n(java_ir* ir, java_token* token);
+definition* t2d(java_ir* ir, hash_table* table, java_token* token);
 primitive r2p(
     java_ir* ir,
     const char* content,
@@ -740,7 +884,7 @@ primitive r2p(
     java_number_bit_length num_bits
 );
 primitive t2p(java_ir* ir, java_token* t, binary_data* data);
-char* name_unit_concat(tree_node* from, tree_node* stop_before);
+char* name_unit_concat(java_ir* ir, flat_node* from, flat_node* stop_before);
 
 void init_definition_pool(definition_pool* pool);
 void release_definition_pool(definition_pool* pool);
@@ -763,18 +907,23 @@ statement_context* get_statement_context(java_ir* ir, statement_context_query qu
 void pop_statement_context(java_ir* ir);
 
 void definition_lookup_deleter(char* k, definition* v);
-hash_table* lookup_new_scope(java_ir* ir);
+void literal_lookup_deleter(char* k, definition* v);
+void init_scope_table(scope_table* table);
+void release_scope_table(scope_table* table);
+void lookup_new_scope(java_ir* ir);
 bool lookup_pop_scope(java_ir* ir, definition_pool* pool);
+bool lookup_in_scope(java_ir* ir);
+scope_entry* lookup_scope_find(java_ir* ir, const char* name);
+void lookup_scope_register(java_ir* ir, char* name, definition* desc);
 hash_table* lookup_global_scope(java_ir* ir);
 hash_table* lookup_top_level_scope(java_ir* ir);
 hash_table* lookup_top_level_literal_scope(java_ir* ir);
-hash_table* lookup_working_scope(java_ir* ir);
 void lookup_top_level_begin(java_ir* ir, global_top_level* desc);
 void lookup_top_level_end(java_ir* ir);
 bool lookup_register(
     java_ir* ir,
     hash_table* table,
-    char** name,
+    char* name,
     void** desc,
     java_error_id err
 );
@@ -788,7 +937,7 @@ bool is_def_register_optimizable_variable(const definition* def);
 size_t get_variable_id(const definition* def);
 definition* def(
     java_ir* ir,
-    char** name,
+    char* name,
     definition** type_def,
     size_t name_dims,
     def_use_control duc,
@@ -817,18 +966,18 @@ definition* def_li_raw(
     java_number_type num_type,
     java_number_bit_length num_bits
 );
-definition* type2def(tree_node* node, definition_type type);
+definition* type2def(java_ir* ir, flat_node* node, definition_type type);
 definition* def_var(
     java_ir* ir,
-    tree_node* node,
+    flat_node* node,
     definition** type,
     lbit_flag modifier,
     variable_kind kind,
     def_use_control duc
 );
-void def_vars(java_ir* ir, tree_node* node, lbit_flag modifier, variable_kind kind);
-void def_params(java_ir* ir, tree_node* node, definition** ordered_list);
-void def_global(java_ir* ir, tree_node* compilation_unit);
+void def_vars(java_ir* ir, flat_node* node, lbit_flag modifier, variable_kind kind);
+void def_params(java_ir* ir, flat_node* node, definition** ordered_list);
+void def_global(java_ir* ir, flat_node* compilation_unit);
 
 definition* new_definition(definition_type type);
 void definition_delete(definition* v);
@@ -846,13 +995,33 @@ bool cfg_empty(const cfg* g);
 void cfg_detach(cfg* g);
 basic_block** cfg_node_order(const cfg* g, cfg_dfs_order order);
 void cfg_delete_node_order(basic_block** list);
-basic_block** cfg_idom(const cfg* g, basic_block** postorder);
+void init_dom_tree(dom_tree* tree, const cfg* g);
+void release_dom_tree(dom_tree* tree);
+bool dom_tree_dominates(const dom_tree* tree, const basic_block* a, const basic_block* b);
+index_set* dom_tree_frontiers(const dom_tree* tree, const cfg* g);
+basic_block** cfg_idom(const cfg* g);
 void cfg_delete_idom(basic_block** idom);
 index_set* cfg_dominators(const cfg* g, const basic_block** idom);
 void cfg_delete_dominators(const cfg* g, index_set* dom);
 index_set* cfg_dominance_frontiers(const cfg* g, const basic_block** idom);
 void cfg_delete_dominance_frontiers(const cfg* g, index_set* df);
 
+void init_dataflow(
+    dataflow* df,
+    const cfg* g,
+    basic_block** postorder,
+    dataflow_direction direction,
+    size_t domain,
+    dataflow_meet meet,
+    dataflow_transfer transfer
+);
+void release_dataflow(dataflow* df);
+void dataflow_use_gen_kill(dataflow* df);
+void dataflow_solve(dataflow* df);
+void dataflow_meet_union(index_set* dest, const index_set* src);
+void dataflow_meet_intersect(index_set* dest, const index_set* src);
+bool dataflow_transfer_gen_kill(dataflow* df, basic_block* b, index_set* result, const index_set* source);
+
 void init_cfg_worker(cfg_worker* worker);
 void release_cfg_worker(cfg_worker* worker, cfg* move_to, definition_pool* pool);
 basic_block* cfg_worker_current_block(cfg_worker* worker);
@@ -901,9 +1070,9 @@ void walk_interface(java_ir* ir, global_top_level* interface);
 
 char primitive_type_to_jil_type(java_lexeme_type p);
 
-void init_ir(java_ir* ir, java_expression* expression, java_error_logger* logger);
+void init_ir(java_ir* ir, java_expression* expression, intern_table* names, java_error_logger* logger);
 void release_ir(java_ir* ir);
-void contextualize(java_ir* ir, architecture* arch, tree_node* compilation_unit);
+void contextualize(java_ir* ir, architecture* arch, flat_node* compilation_unit);
 void ir_error(java_ir* ir, java_error_id id);
 void ir_walk_state_init(java_ir* ir);
 void ir_walk_state_mutate(java_ir* ir, ir_walk_state_type type);
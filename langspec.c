@@ -58,3 +58,38 @@ java_reserved_word java_reserved_words[] =
 };
 
 const unsigned int num_java_reserved_words = ARRAY_SIZE(java_reserved_words);
+
+/**
+ * shorthands for character class table
+*/
+#define CL_ID (JCC_ID_START | JCC_ID_PART)
+#define CL_HEX (CL_ID | JCC_HEX_DIGIT)
+#define CL_NUM (JCC_ID_PART | JCC_DIGIT | JCC_HEX_DIGIT)
+#define CL_HS JCC_HSPACE
+#define CL_VS JCC_VSPACE
+#define CL_OP JCC_OPERATOR_START
+
+/**
+ * character class of every byte
+ *
+ * Java source is ASCII-only outside of literals and comments, so
+ * 0x80 - 0xFF are left 0 by initialization
+*/
+const byte java_char_class[256] =
+{
+    /* 0x00 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, CL_HS, CL_VS, 0, CL_HS, CL_VS, 0, 0,
+    /* 0x10 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    /* 0x20 */ CL_HS, CL_OP, 0, 0, CL_ID, CL_OP, CL_OP, 0, CL_OP, CL_OP, CL_OP, CL_OP, CL_OP, CL_OP, CL_OP, CL_OP,
+    /* 0x30 */ CL_NUM, CL_NUM, CL_NUM, CL_NUM, CL_NUM, CL_NUM, CL_NUM, CL_NUM, CL_NUM, CL_NUM, CL_OP, CL_OP, CL_OP, CL_OP, CL_OP, CL_OP,
+    /* 0x40 */ CL_OP, CL_HEX, CL_HEX, CL_HEX, CL_HEX, CL_HEX, CL_HEX, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID,
+    /* 0x50 */ CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_OP, 0, CL_OP, CL_OP, CL_ID,
+    /* 0x60 */ 0, CL_HEX, CL_HEX, CL_HEX, CL_HEX, CL_HEX, CL_HEX, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID,
+    /* 0x70 */ CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_ID, CL_OP, CL_OP, CL_OP, CL_OP, 0,
+};
+
+#undef CL_ID
+#undef CL_HEX
+#undef CL_NUM
+#undef CL_HS
+#undef CL_VS
+#undef CL_OP
@@ -4,6 +4,30 @@
 
 #include "types.h"
 
+/**
+ * Java language token character class
+ *
+ * a 256-entry table gives bit flags of every byte, so classifying a
+ * character is a single load regardless of locale; 0x00 and all
+ * non-ASCII bytes have no flag
+ *
+ * JCC_OPERATOR_START covers operators and separators, including "/"
+ * of comments, but not quotes of literals
+*/
+
+#define JCC_ID_START 0x01
+#define JCC_ID_PART 0x02
+#define JCC_DIGIT 0x04
+#define JCC_HEX_DIGIT 0x08
+#define JCC_HSPACE 0x10
+#define JCC_VSPACE 0x20
+#define JCC_OPERATOR_START 0x40
+
+extern const byte java_char_class[256];
+
+#define char_class(c) (java_char_class[(byte)(c)])
+#define char_class_test(c, flags) ((char_class(c) & (flags)) != 0)
+
 /**
  * Java language token character set
  *
@@ -11,13 +35,16 @@
  * tokenizer logic needs to be redesigned
 */
 
-#define isidfirstchar(c) (isalpha(c) || (c) == '_' || (c) == '$')
-#define isidchar(c) (isalnum(c) || (c) == '_' || (c) == '$')
+#define isidfirstchar(c) char_class_test(c, JCC_ID_START)
+#define isidchar(c) char_class_test(c, JCC_ID_PART)
+#define isdecchar(c) char_class_test(c, JCC_DIGIT)
+#define ishexchar(c) char_class_test(c, JCC_HEX_DIGIT)
 #define isbindigit(c) ((c) == '0' || (c) == '1')
+#define isopstartchar(c) char_class_test(c, JCC_OPERATOR_START)
 
-#define ishspacechar(c) ((c) == ' ' || (c) == '\t' || (c) == '\f')
-#define isvspacechar(c) ((c) == '\r' || (c) == '\n')
-#define isspacechar(c) (ishspacechar(c) || isvspacechar(c))
+#define ishspacechar(c) char_class_test(c, JCC_HSPACE)
+#define isvspacechar(c) char_class_test(c, JCC_VSPACE)
+#define isspacechar(c) char_class_test(c, JCC_HSPACE | JCC_VSPACE)
 
 #define ishexindicator(c) ((c) == 'x' || (c) == 'X')
 #define isbinaryindicator(c) ((c) == 'b' || (c) == 'B')
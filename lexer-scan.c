@@ -0,0 +1,509 @@
+#include "lexer-scan.h"
+#include "langspec.h"
+#include "utils.h"
+
+#if defined(LEXER_SCAN_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+/**
+ * per-function ISA enablement
+ *
+ * MSVC accepts any intrinsic without a switch; GCC and clang need
+ * the target attribute so that the rest of the build keeps the
+ * default ISA
+*/
+#if defined(_MSC_VER)
+#define LEXER_SCAN_TARGET_SSE2
+#define LEXER_SCAN_TARGET_AVX2
+#else
+#define LEXER_SCAN_TARGET_SSE2 __attribute__((target("sse2")))
+#define LEXER_SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+/**
+ * index of lowest set bit, mask must not be 0
+*/
+static inline unsigned int scan_ctz(uint32_t mask)
+{
+#if defined(_MSC_VER)
+    unsigned long idx;
+
+    _BitScanForward(&idx, mask);
+    return (unsigned int)idx;
+#else
+    return (unsigned int)__builtin_ctz(mask);
+#endif
+}
+
+/* SCALAR KERNEL */
+
+static const byte* scalar_skip_space(const byte* p, const byte* limit)
+{
+    while (p < limit && isspacechar(*p))
+    {
+        p++;
+    }
+
+    return p;
+}
+
+static const byte* scalar_skip_id(const byte* p, const byte* limit)
+{
+    while (p < limit && isidchar(*p))
+    {
+        p++;
+    }
+
+    return p;
+}
+
+static const byte* scalar_skip_digit(const byte* p, const byte* limit)
+{
+    while (p < limit && isdecchar(*p))
+    {
+        p++;
+    }
+
+    return p;
+}
+
+static const byte* scalar_find_line_end(const byte* p, const byte* limit)
+{
+    while (p < limit && *p != 0x00 && !isvspacechar(*p))
+    {
+        p++;
+    }
+
+    return p;
+}
+
+static const byte* scalar_find_comment_end(const byte* p, const byte* limit)
+{
+    while (p < limit && *p != 0x00 && !(p[0] == '*' && p[1] == '/'))
+    {
+        p++;
+    }
+
+    return p;
+}
+
+static size_t scalar_count_newlines(const byte* p, const byte* end)
+{
+    size_t n = 0;
+
+    for (; p < end; p++)
+    {
+        // CR counts only if it is not the first half of CRLF
+        n += (*p == '\n') || (*p == '\r' && p[1] != '\n');
+    }
+
+    return n;
+}
+
+static const lexer_scan_kernel lexer_scan_scalar =
+{
+    LEXER_SCAN_SCALAR,
+    scalar_skip_space,
+    scalar_skip_id,
+    scalar_skip_digit,
+    scalar_find_line_end,
+    scalar_find_comment_end,
+    scalar_count_newlines,
+};
+
+#if defined(LEXER_SCAN_X86)
+
+/* SSE2 KERNEL */
+
+/**
+ * byte-wise unsigned range test: lo <= v <= lo + span - 1
+ *
+ * bias moves lo to -128, so a signed compare does the job
+*/
+#define SSE2_IN_RANGE(v, lo, span) \
+    _mm_cmplt_epi8(_mm_add_epi8(v, _mm_set1_epi8((char)(128 - (lo)))), _mm_set1_epi8((char)(-128 + (span))))
+
+#define SSE2_IS(v, c) _mm_cmpeq_epi8(v, _mm_set1_epi8(c))
+
+LEXER_SCAN_TARGET_SSE2
+static inline __m128i sse2_class_space(__m128i v)
+{
+    return _mm_or_si128(
+        _mm_or_si128(SSE2_IS(v, ' '), SSE2_IS(v, '\t')),
+        _mm_or_si128(_mm_or_si128(SSE2_IS(v, '\f'), SSE2_IS(v, '\r')), SSE2_IS(v, '\n'))
+    );
+}
+
+LEXER_SCAN_TARGET_SSE2
+static inline __m128i sse2_class_id(__m128i v)
+{
+    // letters: fold case first, 0x20 bit never maps a non-letter into a-z
+    __m128i letter = SSE2_IN_RANGE(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 26);
+    __m128i digit = SSE2_IN_RANGE(v, '0', 10);
+
+    return _mm_or_si128(
+        _mm_or_si128(letter, digit),
+        _mm_or_si128(SSE2_IS(v, '_'), SSE2_IS(v, '$'))
+    );
+}
+
+LEXER_SCAN_TARGET_SSE2
+static const byte* sse2_skip_space(const byte* p, const byte* limit)
+{
+    uint32_t mask;
+
+    for (; p + 16 <= limit; p += 16)
+    {
+        mask = ~(uint32_t)_mm_movemask_epi8(sse2_class_space(_mm_loadu_si128((const __m128i*)p))) & 0xFFFF;
+
+        if (mask)
+        {
+            return p + scan_ctz(mask);
+        }
+    }
+
+    return scalar_skip_space(p, limit);
+}
+
+LEXER_SCAN_TARGET_SSE2
+static const byte* sse2_skip_id(const byte* p, const byte* limit)
+{
+    uint32_t mask;
+
+    for (; p + 16 <= limit; p += 16)
+    {
+        mask = ~(uint32_t)_mm_movemask_epi8(sse2_class_id(_mm_loadu_si128((const __m128i*)p))) & 0xFFFF;
+
+        if (mask)
+        {
+            return p + scan_ctz(mask);
+        }
+    }
+
+    return scalar_skip_id(p, limit);
+}
+
+LEXER_SCAN_TARGET_SSE2
+static const byte* sse2_skip_digit(const byte* p, const byte* limit)
+{
+    uint32_t mask;
+
+    for (; p + 16 <= limit; p += 16)
+    {
+        mask = ~(uint32_t)_mm_movemask_epi8(SSE2_IN_RANGE(_mm_loadu_si128((const __m128i*)p), '0', 10)) & 0xFFFF;
+
+        if (mask)
+        {
+            return p + scan_ctz(mask);
+        }
+    }
+
+    return scalar_skip_digit(p, limit);
+}
+
+LEXER_SCAN_TARGET_SSE2
+static const byte* sse2_find_line_end(const byte* p, const byte* limit)
+{
+    __m128i v;
+    uint32_t mask;
+
+    for (; p + 16 <= limit; p += 16)
+    {
+        v = _mm_loadu_si128((const __m128i*)p);
+        mask = (uint32_t)_mm_movemask_epi8(
+            _mm_or_si128(_mm_or_si128(SSE2_IS(v, '\r'), SSE2_IS(v, '\n')), SSE2_IS(v, 0x00))
+        );
+
+        if (mask)
+        {
+            return p + scan_ctz(mask);
+        }
+    }
+
+    return scalar_find_line_end(p, limit);
+}
+
+LEXER_SCAN_TARGET_SSE2
+static const byte* sse2_find_comment_end(const byte* p, const byte* limit)
+{
+    __m128i v;
+    __m128i next;
+    uint32_t mask;
+
+    // next block reads one byte ahead, which is at most *limit
+    for (; p + 16 <= limit; p += 16)
+    {
+        v = _mm_loadu_si128((const __m128i*)p);
+        next = _mm_loadu_si128((const __m128i*)(p + 1));
+        mask = (uint32_t)_mm_movemask_epi8(
+            _mm_or_si128(_mm_and_si128(SSE2_IS(v, '*'), SSE2_IS(next, '/')), SSE2_IS(v, 0x00))
+        );
+
+        if (mask)
+        {
+            return p + scan_ctz(mask);
+        }
+    }
+
+    return scalar_find_comment_end(p, limit);
+}
+
+LEXER_SCAN_TARGET_SSE2
+static size_t sse2_count_newlines(const byte* p, const byte* end)
+{
+    __m128i v;
+    __m128i next;
+    __m128i hit;
+    __m128i sum = _mm_setzero_si128();
+    __m128i one = _mm_set1_epi8(1);
+
+    for (; p + 16 <= end; p += 16)
+    {
+        v = _mm_loadu_si128((const __m128i*)p);
+        next = _mm_loadu_si128((const __m128i*)(p + 1));
+
+        // LF, or CR not followed by LF; every hit byte becomes 1
+        hit = _mm_or_si128(SSE2_IS(v, '\n'), _mm_andnot_si128(SSE2_IS(next, '\n'), SSE2_IS(v, '\r')));
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_and_si128(hit, one), _mm_setzero_si128()));
+    }
+
+    return (size_t)_mm_cvtsi128_si32(sum) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sum, 8)) +
+        scalar_count_newlines(p, end);
+}
+
+static const lexer_scan_kernel lexer_scan_sse2 =
+{
+    LEXER_SCAN_SSE2,
+    sse2_skip_space,
+    sse2_skip_id,
+    sse2_skip_digit,
+    sse2_find_line_end,
+    sse2_find_comment_end,
+    sse2_count_newlines,
+};
+
+/* AVX2 KERNEL */
+
+#define AVX2_IN_RANGE(v, lo, span) \
+    _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(-128 + (span))), _mm256_add_epi8(v, _mm256_set1_epi8((char)(128 - (lo)))))
+
+#define AVX2_IS(v, c) _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))
+
+LEXER_SCAN_TARGET_AVX2
+static inline __m256i avx2_class_space(__m256i v)
+{
+    return _mm256_or_si256(
+        _mm256_or_si256(AVX2_IS(v, ' '), AVX2_IS(v, '\t')),
+        _mm256_or_si256(_mm256_or_si256(AVX2_IS(v, '\f'), AVX2_IS(v, '\r')), AVX2_IS(v, '\n'))
+    );
+}
+
+LEXER_SCAN_TARGET_AVX2
+static inline __m256i avx2_class_id(__m256i v)
+{
+    __m256i letter = AVX2_IN_RANGE(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 26);
+    __m256i digit = AVX2_IN_RANGE(v, '0', 10);
+
+    return _mm256_or_si256(
+        _mm256_or_si256(letter, digit),
+        _mm256_or_si256(AVX2_IS(v, '_'), AVX2_IS(v, '$'))
+    );
+}
+
+LEXER_SCAN_TARGET_AVX2
+static const byte* avx2_skip_space(const byte* p, const byte* limit)
+{
+    uint32_t mask;
+
+    for (; p + 32 <= limit; p += 32)
+    {
+        mask = ~(uint32_t)_mm256_movemask_epi8(avx2_class_space(_mm256_loadu_si256((const __m256i*)p)));
+
+        if (mask)
+        {
+            return p + scan_ctz(mask);
+        }
+    }
+
+    return sse2_skip_space(p, limit);
+}
+
+LEXER_SCAN_TARGET_AVX2
+static const byte* avx2_skip_id(const byte* p, const byte* limit)
+{
+    uint32_t mask;
+
+    for (; p + 32 <= limit; p += 32)
+    {
+        mask = ~(uint32_t)_mm256_movemask_epi8(avx2_class_id(_mm256_loadu_si256((const __m256i*)p)));
+
+        if (mask)
+        {
+            return p + scan_ctz(mask);
+        }
+    }
+
+    return sse2_skip_id(p, limit);
+}
+
+LEXER_SCAN_TARGET_AVX2
+static const byte* avx2_skip_digit(const byte* p, const byte* limit)
+{
+    uint32_t mask;
+
+    for (; p + 32 <= limit; p += 32)
+    {
+        mask = ~(uint32_t)_mm256_movemask_epi8(AVX2_IN_RANGE(_mm256_loadu_si256((const __m256i*)p), '0', 10));
+
+        if (mask)
+        {
+            return p + scan_ctz(mask);
+        }
+    }
+
+    return sse2_skip_digit(p, limit);
+}
+
+LEXER_SCAN_TARGET_AVX2
+static const byte* avx2_find_line_end(const byte* p, const byte* limit)
+{
+    __m256i v;
+    uint32_t mask;
+
+    for (; p + 32 <= limit; p += 32)
+    {
+        v = _mm256_loadu_si256((const __m256i*)p);
+        mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_or_si256(AVX2_IS(v, '\r'), AVX2_IS(v, '\n')), AVX2_IS(v, 0x00))
+        );
+
+        if (mask)
+        {
+            return p + scan_ctz(mask);
+        }
+    }
+
+    return sse2_find_line_end(p, limit);
+}
+
+LEXER_SCAN_TARGET_AVX2
+static const byte* avx2_find_comment_end(const byte* p, const byte* limit)
+{
+    __m256i v;
+    __m256i next;
+    uint32_t mask;
+
+    for (; p + 32 <= limit; p += 32)
+    {
+        v = _mm256_loadu_si256((const __m256i*)p);
+        next = _mm256_loadu_si256((const __m256i*)(p + 1));
+        mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_and_si256(AVX2_IS(v, '*'), AVX2_IS(next, '/')), AVX2_IS(v, 0x00))
+        );
+
+        if (mask)
+        {
+            return p + scan_ctz(mask);
+        }
+    }
+
+    return sse2_find_comment_end(p, limit);
+}
+
+LEXER_SCAN_TARGET_AVX2
+static size_t avx2_count_newlines(const byte* p, const byte* end)
+{
+    __m256i v;
+    __m256i next;
+    __m256i hit;
+    __m256i sum = _mm256_setzero_si256();
+    __m256i one = _mm256_set1_epi8(1);
+    __m128i half;
+
+    for (; p + 32 <= end; p += 32)
+    {
+        v = _mm256_loadu_si256((const __m256i*)p);
+        next = _mm256_loadu_si256((const __m256i*)(p + 1));
+
+        hit = _mm256_or_si256(AVX2_IS(v, '\n'), _mm256_andnot_si256(AVX2_IS(next, '\n'), AVX2_IS(v, '\r')));
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(_mm256_and_si256(hit, one), _mm256_setzero_si256()));
+    }
+
+    half = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+
+    return (size_t)_mm_cvtsi128_si32(half) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(half, 8)) +
+        sse2_count_newlines(p, end);
+}
+
+static const lexer_scan_kernel lexer_scan_avx2 =
+{
+    LEXER_SCAN_AVX2,
+    avx2_skip_space,
+    avx2_skip_id,
+    avx2_skip_digit,
+    avx2_find_line_end,
+    avx2_find_comment_end,
+    avx2_count_newlines,
+};
+
+#endif
+
+/**
+ * best kernel supported by running CPU
+*/
+lexer_scan_mode lexer_scan_best_mode()
+{
+#if defined(LEXER_SCAN_X86)
+    return cpu_has_avx2() ? LEXER_SCAN_AVX2 : (cpu_has_sse2() ? LEXER_SCAN_SSE2 : LEXER_SCAN_SCALAR);
+#else
+    return LEXER_SCAN_SCALAR;
+#endif
+}
+
+/**
+ * kernel of a mode
+ *
+ * LEXER_SCAN_AUTO, or a mode not supported by CPU, gives the best
+ * supported one below it
+*/
+const lexer_scan_kernel* lexer_scan_kernel_get(lexer_scan_mode mode)
+{
+    lexer_scan_mode best = lexer_scan_best_mode();
+
+    if (mode == LEXER_SCAN_AUTO || mode > best)
+    {
+        mode = best;
+    }
+
+    switch (mode)
+    {
+#if defined(LEXER_SCAN_X86)
+        case LEXER_SCAN_AVX2:
+            return &lexer_scan_avx2;
+        case LEXER_SCAN_SSE2:
+            return &lexer_scan_sse2;
+#endif
+        default:
+            return &lexer_scan_scalar;
+    }
+}
+
+const char* lexer_scan_mode_name(lexer_scan_mode mode)
+{
+    switch (mode)
+    {
+        case LEXER_SCAN_SCALAR:
+            return "scalar";
+        case LEXER_SCAN_SSE2:
+            return "sse2";
+        case LEXER_SCAN_AVX2:
+            return "avx2";
+        default:
+            return "auto";
+    }
+}
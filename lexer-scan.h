@@ -0,0 +1,67 @@
+/**
+ * Lexer Scanning Kernels
+ *
+ * a kernel finds the end of a character run in bulk, so lexer can
+ * move its cursor and line info once per run instead of once per
+ * byte
+ *
+ * every kernel takes [p, limit) where *limit is the 0x00 terminator
+ * of file buffer; vector loads never go beyond limit, the remainder
+ * shorter than one vector is scanned by scalar code, and 0x00 is not
+ * part of any run, so an embedded 0x00 still stops scanning
+ *
+ * SSE2 and AVX2 kernels are x86-only and picked at runtime; scalar
+ * kernel is always available as the reference implementation
+*/
+
+#pragma once
+#ifndef __COMPILER_LEXER_SCAN_H__
+#define __COMPILER_LEXER_SCAN_H__
+
+#include "types.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define LEXER_SCAN_X86
+#endif
+
+/**
+ * Kernel Selection
+ *
+ * order matters: a higher mode falls back to a lower one if not
+ * supported by CPU
+*/
+typedef enum
+{
+    /* best supported */
+    LEXER_SCAN_AUTO = 0,
+    LEXER_SCAN_SCALAR,
+    LEXER_SCAN_SSE2,
+    LEXER_SCAN_AVX2,
+} lexer_scan_mode;
+
+/**
+ * Kernel Table
+*/
+typedef struct
+{
+    /* kernel mode */
+    lexer_scan_mode mode;
+    /* end of run of space characters, newlines included */
+    const byte* (*skip_space)(const byte* p, const byte* limit);
+    /* end of run of identifier characters */
+    const byte* (*skip_id)(const byte* p, const byte* limit);
+    /* end of run of decimal digits */
+    const byte* (*skip_digit)(const byte* p, const byte* limit);
+    /* first CR, LF or 0x00 */
+    const byte* (*find_line_end)(const byte* p, const byte* limit);
+    /* first "*" of a "*" "/" pair, or 0x00 */
+    const byte* (*find_comment_end)(const byte* p, const byte* limit);
+    /* number of newline sequences (CR, LF, CRLF) in [p, end) */
+    size_t (*count_newlines)(const byte* p, const byte* end);
+} lexer_scan_kernel;
+
+lexer_scan_mode lexer_scan_best_mode();
+const lexer_scan_kernel* lexer_scan_kernel_get(lexer_scan_mode mode);
+const char* lexer_scan_mode_name(lexer_scan_mode mode);
+
+#endif
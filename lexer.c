@@ -23,6 +23,63 @@ static bool revert_char_default(java_lexer* lexer)
     return false;
 }
 
+/**
+ * move cursor to end in one go, adjust line info accordingly
+ *
+ * end must not split a CRLF sequence
+*/
+static void lexer_advance(java_lexer* lexer, const byte* end)
+{
+    const byte* from = lexer->buffer->cur;
+    const byte* last;
+    const byte* prev;
+    size_t n = lexer->scan->count_newlines(from, end);
+
+    if (n == 0)
+    {
+        lexer->ln_cur.col += (size_t)(end - from);
+        lexer->buffer->cur = (byte*)end;
+        return;
+    }
+
+    // locate start of last newline sequence
+    last = end - 1;
+    while (!isvspacechar(*last))
+    {
+        last--;
+    }
+
+    if (*last == '\n' && last > from && *(last - 1) == '\r')
+    {
+        last--;
+    }
+
+    // ln_prev is where last newline begins, see consume_newline
+    if (n == 1)
+    {
+        lexer->ln_prev.ln = lexer->ln_cur.ln;
+        lexer->ln_prev.col = lexer->ln_cur.col + (size_t)(last - from);
+    }
+    else
+    {
+        prev = last;
+        while (prev > from && !isvspacechar(*(prev - 1)))
+        {
+            prev--;
+        }
+
+        lexer->ln_prev.ln = lexer->ln_cur.ln + n - 1;
+        lexer->ln_prev.col = 1 + (size_t)(last - prev);
+    }
+
+    // skip the newline sequence itself
+    last += (*last == '\r' && *(last + 1) == '\n') ? 2 : 1;
+
+    lexer->ln_cur.ln += n;
+    lexer->ln_cur.col = 1 + (size_t)(end - last);
+    lexer->buffer->cur = (byte*)end;
+}
+
 /**
  * token helper
  *
@@ -30,15 +87,17 @@ static bool revert_char_default(java_lexer* lexer)
 */
 static bool consume_digits(java_lexer* lexer)
 {
-    if (!isdigit(*lexer->buffer->cur))
+    file_buffer* buffer = lexer->buffer;
+    const byte* end;
+
+    if (!isdecchar(*buffer->cur))
     {
         return false;
     }
 
-    while (isdigit(*lexer->buffer->cur))
-    {
-        consume_char_default(lexer);
-    }
+    end = lexer->scan->skip_digit(buffer->cur, buffer->limit);
+    lexer->ln_cur.col += (size_t)(end - buffer->cur);
+    buffer->cur = (byte*)end;
 
     return true;
 }
@@ -77,7 +136,7 @@ static bool consume_number_exponent_part(java_lexer* lexer)
 
         // validation: exponent part must contain >=1 digit(s)
         // hence: digit peek must be validated
-        if (isdigit(digit_peek))
+        if (isdecchar(digit_peek))
         {
             // letter 'e|E' now must be part of FP number now
 
@@ -136,27 +195,12 @@ static bool consume_newline(java_lexer* lexer)
 */
 static void consume_spaces(java_lexer* lexer)
 {
-    char c;
+    file_buffer* buffer = lexer->buffer;
 
-    while (true)
+    // common case: not a space at all
+    if (isspacechar(*buffer->cur))
     {
-        if (consume_newline(lexer))
-        {
-            continue;
-        }
-
-        c = *lexer->buffer->cur;
-
-        if (ishspacechar(c))
-        {
-            // simply consume it one by one
-            consume_char_default(lexer);
-        }
-        else
-        {
-            // stop when no longer a space character
-            break;
-        }
+        lexer_advance(lexer, lexer->scan->skip_space(buffer->cur, buffer->limit));
     }
 }
 
@@ -165,19 +209,15 @@ static void consume_spaces(java_lexer* lexer)
 */
 static void lexer_next_as_identifier(java_lexer* lexer, java_token* token)
 {
-    token->class = JT_IDENTIFIER;
+    file_buffer* buffer = lexer->buffer;
+    const byte* end;
 
-    // before 1st iteration, lexer consumes
-    // first ID char that just checked
-    while (consume_char_default(lexer))
-    {
-        char c = *lexer->buffer->cur;
+    token->class = JT_IDENTIFIER;
 
-        if (!isidchar(c))
-        {
-            break;
-        }
-    }
+    // first ID char has just been checked
+    end = lexer->scan->skip_id(buffer->cur + 1, buffer->limit);
+    lexer->ln_cur.col += (size_t)(end - buffer->cur);
+    buffer->cur = (byte*)end;
 }
 
 /**
@@ -222,7 +262,7 @@ static void lexer_next_as_number(java_lexer* lexer, java_token* token)
             token->number.type = JT_NUM_BIN;
             consume_char_default(lexer);
         }
-        else if (isdigit(after_first_digit))
+        else if (isdecchar(after_first_digit))
         {
             // for octal, valid digits are 0-7,
             // but we losen the rule a bit because we do not have
@@ -243,7 +283,7 @@ static void lexer_next_as_number(java_lexer* lexer, java_token* token)
             // for hex, stop when not a hex digit
             while (consume_char_default(lexer))
             {
-                if (!isxdigit(*buffer->cur))
+                if (!ishexchar(*buffer->cur))
                 {
                     break;
                 }
@@ -361,7 +401,7 @@ static void lexer_next_as_number(java_lexer* lexer, java_token* token)
 
     if (token->number.type == JT_NUM_HEX || token->number.type == JT_NUM_BIN)
     {
-        if (isdigit(*(buffer->cur)))
+        if (isdecchar(*(buffer->cur)))
         {
             lexer_error(lexer, token, JAVA_E_NO_DIGIT);
         }
@@ -501,6 +541,7 @@ void init_token(java_token* token)
     token->ln_begin = LINE(0, 0);
     token->ln_end = LINE(0, 0);
     token->keyword = NULL;
+    token->name = NULL;
     token->number.type = JT_NUM_MAX;
     token->number.bits = JT_NUM_BIT_LENGTH_NORMAL;
 }
@@ -525,13 +566,12 @@ void delete_token(java_token* token)
 /**
  * Initializer Lexer Instance
 */
-void init_lexer(java_lexer* lexer, file_buffer* buffer, hash_table* rw, java_error_logger* logger)
+void init_lexer(java_lexer* lexer, file_buffer* buffer, intern_table* names, java_error_logger* logger)
 {
-    lexer->is_copy = false; // MUST be false from this routine
-
     lexer->buffer = buffer;
-    lexer->rw = rw;
+    lexer->names = names;
     lexer->logger = logger;
+    lexer->scan = lexer_scan_kernel_get(LEXER_SCAN_AUTO);
 
     lexer->expect = JLT_MAX;
     lexer->ln_cur = LINE(1, 1);
@@ -539,28 +579,13 @@ void init_lexer(java_lexer* lexer, file_buffer* buffer, hash_table* rw, java_err
 }
 
 /**
- * Create a copy of lexer so it can work independently
- *
- * everything simple data needs to be copied, for pointers:
+ * Select scanning kernels
  *
- * rw rable: no need to copy
- * buffer: needs a shallow-isolation, but file map does not need to be copied
+ * unsupported mode falls back to the best one supported by CPU
 */
-java_lexer* copy_lexer(const java_lexer* lexer)
+void lexer_set_scan_mode(java_lexer* lexer, lexer_scan_mode mode)
 {
-    java_lexer* copy = (java_lexer*)malloc_assert(sizeof(java_lexer));
-
-    // shallow copy everything simple
-    memcpy(copy, lexer, sizeof(java_lexer));
-
-    // flag it as a copy
-    copy->is_copy = true;
-
-    // buffer needs shallow isolation
-    copy->buffer = (file_buffer*)malloc_assert(sizeof(file_buffer));
-    memcpy(copy->buffer, lexer->buffer, sizeof(file_buffer));
-
-    return copy;
+    lexer->scan = lexer_scan_kernel_get(mode);
 }
 
 /**
@@ -568,11 +593,7 @@ java_lexer* copy_lexer(const java_lexer* lexer)
 */
 void release_lexer(java_lexer* lexer)
 {
-    if (lexer->is_copy)
-    {
-        // buffer is a shallow copy, so no release, simply free it
-        free(lexer->buffer);
-    }
+    // so far there is nothing to do...
 }
 
 /**
@@ -634,6 +655,7 @@ void lexer_next_token(java_lexer* lexer, java_token* token)
     }
 
     char c = *buffer->cur;
+    byte cls = char_class(c);
     line_copy(&token->ln_begin, &lexer->ln_cur);
 
     /**
@@ -641,9 +663,12 @@ void lexer_next_token(java_lexer* lexer, java_token* token)
      *
      * 1. letter, _, $    =>  it is an id
      * 2. digit           =>  it is a number
-     * 3. valid symbols   =>  op, sp, comments
+     * 3. valid symbols   =>  op, sp, comments, literals
      * 4. remainders      =>  illegal
      *
+     * class of first character is loaded once and decides the
+     * category, only valid symbols go through the switch
+     *
      * starting here, should never start with space(s)
      * as we have escaped them
      *
@@ -654,15 +679,15 @@ void lexer_next_token(java_lexer* lexer, java_token* token)
      * a number, but things like "0x", "0b", etc, are not
      * valid numbers
     */
-    if (isidfirstchar(c))
+    if (cls & JCC_ID_START)
     {
         lexer_next_as_identifier(lexer, token);
     }
-    else if (isdigit(c))
+    else if (cls & JCC_DIGIT)
     {
         lexer_next_as_number(lexer, token);
     }
-    else
+    else if ((cls & JCC_OPERATOR_START) || c == '\'' || c == '\"')
     {
         switch (c)
         {
@@ -738,7 +763,7 @@ void lexer_next_token(java_lexer* lexer, java_token* token)
                         consume_char_default(lexer);
                     }
                 }
-                else if (isdigit(c))
+                else if (isdecchar(c))
                 {
                     /**
                      * here, we try accepting one of forms of FP number
@@ -998,14 +1023,16 @@ void lexer_next_token(java_lexer* lexer, java_token* token)
                     token->class = JT_COMMENT;
                     token->type = JLT_CMT_MULTI_LINE;
 
-                    while (consume_char_default(lexer))
+                    // opening '*' cannot be part of the enclosure sequence
+                    if (consume_char_default(lexer))
                     {
-                        if (*buffer->cur == '*' && buffer_peek(buffer, 1) == '/')
+                        lexer_advance(lexer, lexer->scan->find_comment_end(buffer->cur, buffer->limit));
+
+                        if (*buffer->cur == '*')
                         {
                             // consume twice for the enclosure sequence
                             consume_char_default(lexer);
                             consume_char_default(lexer);
-                            break;
                         }
                     }
                 }
@@ -1015,14 +1042,14 @@ void lexer_next_token(java_lexer* lexer, java_token* token)
                     token->class = JT_COMMENT;
                     token->type = JLT_CMT_SINGLE_LINE;
 
-                    while (consume_char_default(lexer))
+                    if (consume_char_default(lexer))
                     {
-                        // try consuming again to see if next is a newline
-                        // sequence, if so we terminate
-                        if (consume_newline(lexer))
-                        {
-                            break;
-                        }
+                        // newline sequence terminates the comment
+                        const byte* end = lexer->scan->find_line_end(buffer->cur, buffer->limit);
+
+                        lexer->ln_cur.col += (size_t)(end - buffer->cur);
+                        buffer->cur = (byte*)end;
+                        consume_newline(lexer);
                     }
                 }
 
@@ -1164,19 +1191,20 @@ void lexer_next_token(java_lexer* lexer, java_token* token)
                     c = *buffer->cur;
                 }
 
-                break;
-            default:
-                // illegal sequence detected, put it in the token
-                //
-                // funny thing is: longest match could be costly here
-                // due to the complexity of condition logic
-                // so we accept it one by one
-                token->class = JT_ILLEGAL;
-                consume_char_default(lexer);
-                lexer_error(lexer, token, JAVA_E_ILLEGAL_CHARACTER, (byte)c);
                 break;
         }
     }
+    else
+    {
+        // illegal sequence detected, put it in the token
+        //
+        // funny thing is: longest match could be costly here
+        // due to the complexity of condition logic
+        // so we accept it one by one
+        token->class = JT_ILLEGAL;
+        consume_char_default(lexer);
+        lexer_error(lexer, token, JAVA_E_ILLEGAL_CHARACTER, (byte)c);
+    }
 
     // character pointed by "to" is the very first one that is NOT part of the token
     token->to = buffer->cur;
@@ -1187,12 +1215,7 @@ void lexer_next_token(java_lexer* lexer, java_token* token)
     // check if id is a keyword
     if (token->class == JT_IDENTIFIER)
     {
-        size_t len = buffer_count(token->from, token->to);
-        // len + 1 because we need \0 to terminate string
-        char* content = (char*)malloc_assert(sizeof(char) * (len + 1));
-
-        buffer_substring(content, token->from, len);
-        java_reserved_word* sym = symbol_lookup(lexer->rw, content);
+        java_reserved_word* sym = symbol_lookup_slice(token->from, buffer_count(token->from, token->to));
 
         if (sym)
         {
@@ -1200,8 +1223,10 @@ void lexer_next_token(java_lexer* lexer, java_token* token)
             token->type = sym->id;
             token->keyword = sym;
         }
-
-        free(content);
+        else if (lexer->names)
+        {
+            token->name = intern_slice(lexer->names, token->from, buffer_count(token->from, token->to));
+        }
     }
 
     /**
@@ -1242,3 +1267,122 @@ void lexer_next_token(java_lexer* lexer, java_token* token)
     // reset lexer expect
     lexer_expect(lexer, JLT_MAX);
 }
+
+/**
+ * Initialize token stream
+ *
+ * no memory is allocated until first lexer_tokenize
+*/
+void init_token_stream(java_token_stream* stream)
+{
+    stream->arr = NULL;
+    stream->num = 0;
+    stream->size = 0;
+    stream->names = NULL;
+}
+
+/**
+ * Release token stream
+*/
+void release_token_stream(java_token_stream* stream)
+{
+    free(stream->arr);
+    init_token_stream(stream);
+}
+
+/**
+ * append compact form of a token
+*/
+static void token_stream_push(java_token_stream* stream, file_buffer* buffer, java_token* token)
+{
+    java_token_entry* entry;
+
+    if (stream->num >= stream->size)
+    {
+        stream->size = stream->size ? stream->size * 2 : 256;
+        stream->arr = (java_token_entry*)realloc_assert(stream->arr, sizeof(java_token_entry) * stream->size);
+    }
+
+    entry = &stream->arr[stream->num++];
+    entry->type = (unsigned short)token->type;
+    entry->class = (byte)token->class;
+    entry->keyword = token->keyword ? (byte)(token->keyword - java_reserved_words + 1) : 0;
+    entry->number_type = (byte)token->number.type;
+    entry->number_bits = (byte)token->number.bits;
+    entry->name = (uint32_t)intern_id(token->name);
+    entry->offset = (uint32_t)buffer_count(buffer->base, token->from);
+    entry->length = token->class == JT_EOF ? 0 : (uint32_t)buffer_count(token->from, token->to);
+    entry->ln = (uint32_t)token->ln_begin.ln;
+    entry->col = (uint32_t)token->ln_begin.col;
+}
+
+/**
+ * Pre-tokenizer
+ *
+ * run lexer over whole buffer once, so parser can index tokens
+ * directly and rollback is a position reset
+ *
+ * lexical errors are logged here, before any syntax error
+ *
+ * offset, length, line and column of an entry are 32-bit, and none
+ * can exceed buffer size + 1; so it returns false without lexing
+ * anything if buffer is too large, caller should lex on demand
+*/
+bool lexer_tokenize(java_lexer* lexer, java_token_stream* stream)
+{
+    java_token token;
+
+    if (buffer_count(lexer->buffer->base, lexer->buffer->limit) >= UINT32_MAX)
+    {
+        return false;
+    }
+
+    stream->num = 0;
+    stream->names = lexer->names;
+
+    do
+    {
+        lexer_next_token(lexer, &token);
+
+        if (token.class != JT_COMMENT)
+        {
+            token_stream_push(stream, lexer->buffer, &token);
+        }
+    } while (token.class != JT_EOF);
+
+    // JT_EOF has no line info, keep final lexer cursor there instead
+    stream->arr[stream->num - 1].ln = (uint32_t)lexer->ln_cur.ln;
+    stream->arr[stream->num - 1].col = (uint32_t)lexer->ln_cur.col;
+
+    return true;
+}
+
+/**
+ * expand a stream entry into full token
+ *
+ * index beyond the end gives the closing JT_EOF entry, whose line
+ * info is lexer cursor at end of file
+*/
+void token_stream_get(java_token_stream* stream, file_buffer* buffer, size_t idx, java_token* token)
+{
+    java_token_entry* entry = &stream->arr[min(idx, stream->num - 1)];
+
+    token->from = buffer->base + entry->offset;
+    token->to = token->from + entry->length;
+    token->class = (java_token_class)entry->class;
+    token->type = (java_lexeme_type)entry->type;
+    if (entry->class == JT_EOF)
+    {
+        token->ln_begin = LINE(0, 0);
+        token->ln_end = LINE(0, 0);
+    }
+    else
+    {
+        token->ln_begin = LINE(entry->ln, entry->col);
+        token->ln_end = LINE(entry->ln, entry->col + entry->length);
+    }
+    token->keyword = entry->keyword ? &java_reserved_words[entry->keyword - 1] : NULL;
+    token->name = entry->name != INTERN_ID_NONE ? intern_name(stream->names, entry->name) : NULL;
+    token->number.type = (java_number_type)entry->number_type;
+    token->number.bits = (java_number_bit_length)entry->number_bits;
+}
@@ -5,7 +5,9 @@
 #include "types.h"
 #include "langspec.h"
 #include "file.h"
+#include "lexer-scan.h"
 #include "symtbl.h"
+#include "intern.h"
 #include "error.h"
 
 #define lexer_error_missing_token(parser, token, id, token_name) \
@@ -92,23 +94,73 @@ typedef struct _java_token
 
     /* keyword info */
     java_reserved_word* keyword;
+    /* canonical name, identifier only */
+    char* name;
     /* number info */
     java_number_info number;
 } java_token;
 
+/**
+ * Compact Token
+ *
+ * entry of pre-tokenized stream; pointers and end line are not
+ * stored, they are restored from file buffer on expansion, as
+ * tokens (comments aside) never span multiple lines
+ *
+ * locations are 32-bit, so a buffer of UINT32_MAX bytes or more is
+ * never pre-tokenized, see lexer_tokenize
+*/
+typedef struct
+{
+    /* lexeme type */
+    unsigned short type;
+    /* main class */
+    byte class;
+    /* reserved word index + 1, 0 if not a keyword */
+    byte keyword;
+    /* number info */
+    byte number_type;
+    byte number_bits;
+    /* interned name id, identifier only */
+    uint32_t name;
+    /* location in file buffer */
+    uint32_t offset;
+    uint32_t length;
+    /* line info of first character */
+    uint32_t ln;
+    uint32_t col;
+} java_token_entry;
+
+/**
+ * Token Stream
+ *
+ * whole file tokenized at once, comments dropped, and a single
+ * JT_EOF entry always closes the stream, holding final lexer cursor
+ * as its line info; memory is kept across
+ * files and only grows
+*/
+typedef struct
+{
+    java_token_entry* arr;
+    size_t num;
+    size_t size;
+    /* resolves entry names */
+    intern_table* names;
+} java_token_stream;
+
 /**
  * Lexer Context
 */
 typedef struct
 {
-    // copy mark
-    bool is_copy;
     // file buffer
     file_buffer* buffer;
-    // reserved words lookup table
-    hash_table* rw;
+    // name interning, NULL to skip
+    intern_table* names;
     // error logger
     java_error_logger* logger;
+    // bulk scanning kernels
+    const lexer_scan_kernel* scan;
 
     /**
      * TODO: future work: additional aid for resolving lexical ambiguity
@@ -136,12 +188,17 @@ void init_token(java_token* token);
 void release_token(java_token* token);
 void delete_token(java_token* token);
 
-void init_lexer(java_lexer* lexer, file_buffer* buffer, hash_table* rw, java_error_logger* logger);
-java_lexer* copy_lexer(const java_lexer* lexer);
+void init_lexer(java_lexer* lexer, file_buffer* buffer, intern_table* names, java_error_logger* logger);
 void release_lexer(java_lexer* lexer);
+void lexer_set_scan_mode(java_lexer* lexer, lexer_scan_mode mode);
 
 void lexer_error(java_lexer* lexer, java_token* token, java_error_id id, ...);
 void lexer_expect(java_lexer* lexer, java_lexeme_type token_type);
 void lexer_next_token(java_lexer* lexer, java_token* token);
+bool lexer_tokenize(java_lexer* lexer, java_token_stream* stream);
+
+void init_token_stream(java_token_stream* stream);
+void release_token_stream(java_token_stream* stream);
+void token_stream_get(java_token_stream* stream, file_buffer* buffer, size_t idx, java_token* token);
 
 #endif
@@ -29,7 +29,7 @@ typedef struct
 
 uint64_t __hex_char_to_half_byte(char c)
 {
-    if (isdigit(c))
+    if (isdecchar(c))
     {
         return __number_c2d(c) & 0xF;
     }
@@ -606,7 +606,7 @@ static number_truncation_status pow2_base_s2b(const char* content, size_t bin_ba
     {
         c = content[i];
 
-        if (!isxdigit(c))
+        if (!ishexchar(c))
         {
             // stop at suffix: no need to continue
             break;
@@ -726,7 +726,7 @@ static number_truncation_status __string_encode(const char* content, binary_data
                     // skip header "\uuu..."
                     while (*pc && *pc == 'u') { pc++; }
                     // 4 hexadecimal maximum
-                    for (size_t i = 0; i < 4 && *pc && isxdigit(*pc); i++, pc++)
+                    for (size_t i = 0; i < 4 && *pc && ishexchar(*pc); i++, pc++)
                     {
                         wc = (wc << 4) | __hex_char_to_half_byte(*pc);
                         data->wide_char = i > 1;
@@ -739,7 +739,7 @@ static number_truncation_status __string_encode(const char* content, binary_data
                     // line break escape has no-op
                     break;
                 default:
-                    if (isdigit(*pc))
+                    if (isdecchar(*pc))
                     {
                         wc = 0;
 
@@ -931,7 +931,7 @@ number_truncation_status s2b(const char* content, java_number_type type, binary_
             dec_exp_neg = false;
             continue;
         }
-        else if (!isdigit(c))
+        else if (!isdecchar(c))
         {
             // stop before suffix
             break;
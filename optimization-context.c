@@ -1,5 +1,34 @@
 #include "optimization-context.h"
 #include "hash-table.h"
+#include "thread.h"
+
+/**
+ * Work-Stealing Task Queue
+ *
+ * owner takes tasks from tail, thieves take tasks from head;
+ * all tasks are known before workers start, so a worker can
+ * exit once every queue is drained
+*/
+typedef struct
+{
+    thread_mutex lock;
+    code_context** tasks;
+    size_t head;
+    size_t tail;
+} optimization_queue;
+
+typedef struct
+{
+    optimization_queue* queues;
+    size_t num_queues;
+} optimization_scheduler;
+
+typedef struct
+{
+    optimization_scheduler* scheduler;
+    size_t id;
+    thread_handle thread;
+} optimization_worker;
 
 static void init_code_context(code_context* code, char* name_ref_top_level)
 {
@@ -27,11 +56,12 @@ static void release_code_context(code_context* code)
  *
  * This function does not do actual job, it only resets the object
  */
-void init_optimization_context(optimization_context* oc, java_ir* ir)
+void init_optimization_context(optimization_context* oc, java_ir* ir, size_t num_threads)
 {
     oc->num_top_level = 0;
     oc->ir = ir;
     oc->top_levels = NULL;
+    oc->num_threads = num_threads > 0 ? num_threads : 1;
 }
 
 void release_optimization_context(optimization_context* oc)
@@ -57,10 +87,145 @@ void release_optimization_context(optimization_context* oc)
     oc->top_levels = NULL;
 }
 
+static code_context* optimization_queue_pop(optimization_queue* q)
+{
+    code_context* code = NULL;
+
+    thread_mutex_lock(&q->lock);
+
+    if (q->head < q->tail)
+    {
+        code = q->tasks[--q->tail];
+    }
+
+    thread_mutex_unlock(&q->lock);
+    return code;
+}
+
+static code_context* optimization_queue_steal(optimization_queue* q)
+{
+    code_context* code = NULL;
+
+    thread_mutex_lock(&q->lock);
+
+    if (q->head < q->tail)
+    {
+        code = q->tasks[q->head++];
+    }
+
+    thread_mutex_unlock(&q->lock);
+    return code;
+}
+
+/**
+ * worker routine: drain own queue, then steal from others
+*/
+static void optimization_worker_run(void* arg)
+{
+    optimization_worker* worker = (optimization_worker*)arg;
+    optimization_scheduler* scheduler = worker->scheduler;
+    code_context* code;
+
+    while (true)
+    {
+        code = optimization_queue_pop(&scheduler->queues[worker->id]);
+
+        for (size_t i = 1; !code && i < scheduler->num_queues; i++)
+        {
+            code = optimization_queue_steal(&scheduler->queues[(worker->id + i) % scheduler->num_queues]);
+        }
+
+        if (!code)
+        {
+            break;
+        }
+
+        optimizer_execute(&code->om);
+    }
+}
+
+/**
+ * execute attached optimizers on multiple threads
+ *
+ * tasks are dealt to queues round-robin in build order
+*/
+static void optimization_context_execute_parallel(code_context** tasks, size_t num_tasks, size_t num_threads)
+{
+    optimization_scheduler scheduler;
+    optimization_worker* workers = (optimization_worker*)malloc_assert(sizeof(optimization_worker) * num_threads);
+    size_t num_started = 0;
+
+    scheduler.num_queues = num_threads;
+    scheduler.queues = (optimization_queue*)malloc_assert(sizeof(optimization_queue) * num_threads);
+
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        optimization_queue* q = &scheduler.queues[i];
+
+        init_thread_mutex(&q->lock);
+        q->tasks = (code_context**)malloc_assert(sizeof(code_context*) * (num_tasks / num_threads + 1));
+        q->head = 0;
+        q->tail = 0;
+    }
+
+    for (size_t i = 0; i < num_tasks; i++)
+    {
+        optimization_queue* q = &scheduler.queues[i % num_threads];
+        q->tasks[q->tail++] = tasks[i];
+    }
+
+    // current thread works as worker 0
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        workers[i].scheduler = &scheduler;
+        workers[i].id = i;
+    }
+
+    for (size_t i = 1; i < num_threads; i++)
+    {
+        if (!thread_start(&workers[i].thread, optimization_worker_run, &workers[i]))
+        {
+            break;
+        }
+
+        num_started++;
+    }
+
+    optimization_worker_run(&workers[0]);
+
+    for (size_t i = 1; i <= num_started; i++)
+    {
+        thread_join(&workers[i].thread);
+    }
+
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        release_thread_mutex(&scheduler.queues[i].lock);
+        free(scheduler.queues[i].tasks);
+    }
+
+    free(scheduler.queues);
+    free(workers);
+}
+
+/**
+ * Build optimization context
+ *
+ * serial build attaches and executes one method at a time; otherwise
+ * all methods are attached first, then executed in parallel
+*/
 void optimization_context_build(optimization_context* oc)
 {
     hash_table* table = lookup_global_scope(oc->ir);
     size_t sz_top_levels = sizeof(top_level_optimizer) * table->num_pairs;
+    bool parallel = oc->num_threads > 1;
+    code_context** tasks = NULL;
+    size_t num_tasks = 0;
+    size_t max_tasks = 0;
+    size_t d1 = 0;
+    size_t d2 = 0;
+    hash_table_iterator it;
+    hash_table_iterator it_member;
 
     // initialize first dimension
     oc->num_top_level = table->num_pairs;
@@ -68,45 +233,60 @@ void optimization_context_build(optimization_context* oc)
     memset(oc->top_levels, 0, sz_top_levels);
 
     // iterate all top levels
-    for (size_t i = 0, d1 = 0, d2 = 0; i < table->bucket_size; i++)
+    for (hash_pair* p = hash_table_first(table, &it); p != NULL; p = hash_table_next(table, &it), d1++, d2 = 0)
     {
-        for (hash_pair* p = table->bucket[i]; p != NULL; p = p->next, d1++, d2 = 0)
+        global_top_level* top_level = p->value;
+
+        // so far only class contains code
+        if (!top_level || top_level->type != TOP_LEVEL_CLASS)
         {
-            global_top_level* top_level = p->value;
+            continue;
+        }
 
-            // so far only class contains code
-            if (!top_level || top_level->type != TOP_LEVEL_CLASS)
-            {
-                continue;
-            }
+        // initialize second dimension
+        oc->top_levels[d1].num_methods = top_level->num_methods;
+        oc->top_levels[d1].contexts = (code_context*)malloc_assert(sizeof(code_context) * top_level->num_methods);
 
-            // initialize second dimension
-            oc->top_levels[d1].num_methods = top_level->num_methods;
-            oc->top_levels[d1].contexts = (code_context*)malloc_assert(sizeof(code_context) * top_level->num_methods);
+        // now construct optimizer instances
+        for (size_t dim = 0; dim < top_level->num_methods; dim++)
+        {
+            init_code_context(&oc->top_levels[d1].contexts[dim], p->key);
+        }
 
-            // now construct optimizer instances
-            for (size_t dim = 0; dim < top_level->num_methods; dim++)
-            {
-                init_code_context(&oc->top_levels[d1].contexts[dim], p->key);
-            }
+        // reserve task slots
+        if (parallel)
+        {
+            max_tasks += top_level->num_methods;
+            tasks = (code_context**)realloc_assert(tasks, sizeof(code_context*) * max(max_tasks, 1));
+        }
 
-            // iterate all members
-            for (size_t j = 0; j < top_level->tbl_member.bucket_size; j++)
+        // iterate all members
+        for (hash_pair* pm = hash_table_first(&top_level->tbl_member, &it_member); pm != NULL; pm = hash_table_next(&top_level->tbl_member, &it_member))
+        {
+            code_context* code = &oc->top_levels[d1].contexts[d2];
+
+            if (optimizer_attach(&code->om, top_level, pm->value))
             {
-                for (hash_pair* pm = top_level->tbl_member.bucket[j]; pm != NULL; pm = pm->next)
+                if (parallel)
                 {
-                    code_context* code = &oc->top_levels[d1].contexts[d2];
-
-                    if (optimizer_attach(&code->om, top_level, pm->value))
-                    {
-                        optimizer_execute(&code->om);
-
-                        code->name_method = pm->key;
-                        code->def = pm->value;
-                        d2++;
-                    }
+                    tasks[num_tasks++] = code;
+                }
+                else
+                {
+                    optimizer_execute(&code->om);
                 }
+
+                code->name_method = pm->key;
+                code->def = pm->value;
+                d2++;
             }
         }
     }
+
+    if (num_tasks > 0)
+    {
+        optimization_context_execute_parallel(tasks, num_tasks, min(oc->num_threads, num_tasks));
+    }
+
+    free(tasks);
 }
@@ -20,14 +20,24 @@ typedef struct _top_level_optimizer
     code_context* contexts;
 } top_level_optimizer;
 
+/**
+ * Optimization Context
+ *
+ * every method owns its optimizer, and optimizers do not share
+ * mutable data, so when num_threads > 1 all methods are optimized
+ * concurrently on a work-stealing scheduler; the result is the
+ * same as serial build
+*/
 typedef struct _optimization_context
 {
     size_t num_top_level;
     java_ir* ir;
     top_level_optimizer* top_levels;
+    /* number of threads, 1 for serial build */
+    size_t num_threads;
 } optimization_context;
 
-void init_optimization_context(optimization_context* oc, java_ir* ir);
+void init_optimization_context(optimization_context* oc, java_ir* ir, size_t num_threads);
 void release_optimization_context(optimization_context* oc);
 void optimization_context_build(optimization_context* oc);
 
@@ -19,12 +19,20 @@
  * every node in CFG has at least one instruction. See
  * optimizer_attach() on how it fulfills this assumption
 */
-void optimizer_liveness_analyze(optimizer* om)
+
+/**
+ * Instruction Level Solver
+ *
+ * every instruction is a node of the dataflow graph, worklist
+ * is seeded with every instruction
+*/
+static void liveness_analyze_instructions(optimizer* om)
 {
-    size_t num_nodes = om->profile.num_nodes;
     size_t idx;
     index_set worklist;
 
+    memset(&om->liveness_stats, 0, sizeof(dataflow_stats));
+
     for (size_t i = 0; i < om->profile.num_instructions; i++)
     {
         init_index_set(&om->instructions[i].in, om->profile.num_variables);
@@ -41,10 +49,6 @@ void optimizer_liveness_analyze(optimizer* om)
         instruction* s = om->instructions[idx].ref;
         index_set* live_in = &om->instructions[idx].in;
         index_set* live_out = &om->instructions[idx].out;
-        index_set old_in;
-
-        // save copy of old in[s]
-        init_index_set_copy(&old_in, live_in);
 
         // out(n) = union(in[p]), p = every successor of n
         index_set_clear(live_out);
@@ -63,13 +67,8 @@ void optimizer_liveness_analyze(optimizer* om)
         }
 
         // in(n) = (out(n) - kill(n)) union gen(n)
-        index_set_clear(live_in);
-        index_set_union(live_in, live_out);
-        index_set_subtract(live_in, &om->instructions[s->id].def);
-        index_set_union(live_in, &om->instructions[s->id].use);
-
-        // muutate worklist
-        if (!index_set_equal(live_in, &old_in))
+        // muutate worklist if in(n) is changed
+        if (index_set_transfer(live_in, live_out, &om->instructions[s->id].def, &om->instructions[s->id].use))
         {
             // worklist = worklist union predecessor(n)
             if (s->prev)
@@ -85,8 +84,129 @@ void optimizer_liveness_analyze(optimizer* om)
                 }
             }
         }
+    }
+
+    release_index_set(&worklist);
+}
+
+/**
+ * Block Level Solver
+ *
+ * a block is summarized by gen (upward exposed uses) and kill (all
+ * defs), so the fixed point is found on blocks only, by the dataflow
+ * engine as a backward problem, visiting blocks in postorder
+ *
+ * per-instruction sets are expanded afterwards, one backward sweep
+ * per block starting from out(block)
+*/
+static void liveness_analyze_blocks(optimizer* om)
+{
+    size_t num_nodes = om->profile.num_nodes;
+    size_t num_variables = om->profile.num_variables;
+    dataflow df;
+
+    init_dataflow(
+        &df,
+        om->graph,
+        om->node_postorder,
+        DATAFLOW_BACKWARD,
+        num_variables,
+        &dataflow_meet_union,
+        &dataflow_transfer_gen_kill
+    );
+    dataflow_use_gen_kill(&df);
+
+    // local facts: walk instructions backward
+    for (size_t i = 0; i < num_nodes; i++)
+    {
+        basic_block* b = om->node_postorder[i];
+
+        for (instruction* p = b->inst_last; p != NULL; p = p->prev)
+        {
+            index_set_subtract(&df.gen[b->id], &om->instructions[p->id].def);
+            index_set_union(&df.gen[b->id], &om->instructions[p->id].use);
+            index_set_union(&df.kill[b->id], &om->instructions[p->id].def);
+        }
+    }
+
+    // global facts
+    dataflow_solve(&df);
+
+    // expand to instructions
+    for (size_t i = 0; i < num_nodes; i++)
+    {
+        basic_block* b = om->node_postorder[i];
+        const index_set* live = &df.out[b->id];
+
+        for (instruction* p = b->inst_last; p != NULL; p = p->prev)
+        {
+            instruction_item* item = &om->instructions[p->id];
+
+            init_index_set_copy(&item->out, live);
+            init_index_set(&item->in, num_variables);
+            index_set_transfer(&item->in, &item->out, &item->def, &item->use);
+
+            live = &item->in;
+        }
+    }
+
+    om->liveness_stats = df.stats;
+    release_dataflow(&df);
+}
+
+/**
+ * run both solvers and compare
+ *
+ * instruction level result is kept
+*/
+static void liveness_verify(optimizer* om)
+{
+    size_t num_instructions = om->profile.num_instructions;
+    index_set* in = (index_set*)malloc_assert(sizeof(index_set) * num_instructions);
+    index_set* out = (index_set*)malloc_assert(sizeof(index_set) * num_instructions);
+
+    liveness_analyze_blocks(om);
+
+    // move block level result away
+    for (size_t i = 0; i < num_instructions; i++)
+    {
+        in[i] = om->instructions[i].in;
+        out[i] = om->instructions[i].out;
+    }
+
+    liveness_analyze_instructions(om);
+
+    for (size_t i = 0; i < num_instructions; i++)
+    {
+        if (!index_set_equal(&in[i], &om->instructions[i].in) ||
+            !index_set_equal(&out[i], &om->instructions[i].out))
+        {
+            fprintf(stderr, "TODO ERROR: internal error: liveness mismatch at instruction %zd.\n", i);
+        }
+
+        release_index_set(&in[i]);
+        release_index_set(&out[i]);
+    }
 
-        // cleanup
-        release_index_set(&old_in);
+    free(in);
+    free(out);
+}
+
+/**
+ * solver is selected by OPTIMIZER_LIVENESS
+*/
+void optimizer_liveness_analyze(optimizer* om)
+{
+    switch (OPTIMIZER_LIVENESS)
+    {
+        case OPTIMIZER_LIVENESS_INSTRUCTION:
+            liveness_analyze_instructions(om);
+            break;
+        case OPTIMIZER_LIVENESS_VERIFY:
+            liveness_verify(om);
+            break;
+        default:
+            liveness_analyze_blocks(om);
+            break;
     }
 }
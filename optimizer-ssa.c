@@ -1,25 +1,26 @@
 #include "optimizer.h"
 
 /**
- * Variable version stack used during variable renaming
+ * Empty version stack
 */
-typedef struct _variable_version_stack
-{
-    size_t version;
-    instruction* source;
-    struct _variable_version_stack* next;
-} variable_version_stack;
+#define SSA_VERSION_NONE ((size_t)-1)
 
 /**
- * Node Stack
+ * Variable Version Frame
  *
- * used for node-based tree walk
+ * frames of all variables share one contiguous stack, because the
+ * dominator tree walk pops them in reverse order of pushing; each
+ * frame links to the frame below it of the same variable
 */
-typedef struct _node_walk_stack
+typedef struct _variable_version_frame
 {
-    basic_block* ref;
-    struct _node_walk_stack* next;
-} node_walk_stack;
+    size_t version;
+    instruction* source;
+    // variable map index
+    size_t variable;
+    // previous top of the variable
+    size_t below;
+} variable_version_frame;
 
 /**
  * Variable-Specific Data
@@ -31,8 +32,8 @@ typedef struct _node_walk_stack
 */
 typedef struct _variable_ssa_info
 {
-    // version stack
-    variable_version_stack* vvs;
+    // top frame of version stack
+    size_t top;
     // version counter
     size_t version_counter;
     // blocks that contain definition of each variable
@@ -47,39 +48,23 @@ typedef struct
 {
     size_t num_nodes;
 
-    // Globals set, candidates for PHI placement
+    // Globals set, variables with upward exposed use in any block
     index_set globals;
 
     // Variable Data
     variable_ssa_info* variables;
-} ssa_builder;
-
-static node_walk_stack* node_stack_push(node_walk_stack* s, basic_block* bb)
-{
-    node_walk_stack* top = (node_walk_stack*)malloc_assert(sizeof(node_walk_stack));
-
-    top->ref = bb;
-    top->next = s;
-
-    return top;
-}
-
-static node_walk_stack* node_stack_pop(node_walk_stack* s)
-{
-    if (!s) { return NULL; }
 
-    node_walk_stack* top = s;
+    // Block liveness, PRUNED only
+    dataflow liveness;
 
-    s = s->next;
-
-    free(top);
-    return s;
-}
+    // Iterated dominance frontier of current variable
+    index_set phi_blocks;
 
-static basic_block* node_stack_top(node_walk_stack* s)
-{
-    return s ? s->ref : NULL;
-}
+    // Version stack of all variables, allocated when renaming
+    variable_version_frame* frames;
+    size_t num_frames;
+    size_t size_frames;
+} ssa_builder;
 
 static void ssa_builder_init(optimizer* om, ssa_builder* builder)
 {
@@ -93,9 +78,28 @@ static void ssa_builder_init(optimizer* om, ssa_builder* builder)
     optimizer_populate_variables(om);
 
     builder->num_nodes = om->profile.num_nodes;
+    builder->frames = NULL;
+    builder->num_frames = 0;
+    builder->size_frames = 0;
     builder->variables = (variable_ssa_info*)malloc_assert(sizeof(variable_ssa_info) * om->profile.num_variables);
 
     init_index_set(&builder->globals, om->profile.num_variables);
+    init_index_set(&builder->phi_blocks, builder->num_nodes);
+    memset(&om->ssa_stats, 0, sizeof(optimizer_ssa_stats));
+
+    if (OPTIMIZER_SSA == OPTIMIZER_SSA_PRUNED)
+    {
+        init_dataflow(
+            &builder->liveness,
+            om->graph,
+            om->node_postorder,
+            DATAFLOW_BACKWARD,
+            om->profile.num_variables,
+            &dataflow_meet_union,
+            &dataflow_transfer_gen_kill
+        );
+        dataflow_use_gen_kill(&builder->liveness);
+    }
 
     for (size_t i = 0; i < om->profile.num_variables; i++)
     {
@@ -105,6 +109,7 @@ static void ssa_builder_init(optimizer* om, ssa_builder* builder)
         if (!is_def_user_defined_variable(om->variables[i].ref))
         {
             memset(info, 0, sizeof(variable_ssa_info));
+            info->top = SSA_VERSION_NONE;
             continue;
         }
 
@@ -121,19 +126,18 @@ static void ssa_builder_init(optimizer* om, ssa_builder* builder)
              *
              * so, it is left NULL on purpose, combined with lvalue of the PHI being a member variable,
              * implies that a "null" operand in PHI means very first value of the member upon entry
+             *
+             * version 0 frame is pushed when renaming starts, see ssa_builder_init_frames()
             */
-            info->vvs = (variable_version_stack*)malloc_assert(sizeof(variable_version_stack));
-            info->vvs->version = 0;
-            info->vvs->source = NULL;
-            info->vvs->next = NULL;
             info->version_counter = 1;
         }
         else
         {
-            info->vvs = NULL;
             info->version_counter = 0;
         }
 
+        info->top = SSA_VERSION_NONE;
+
         init_index_set(&info->blocks, builder->num_nodes);
     }
 }
@@ -142,22 +146,18 @@ static void ssa_builder_release(optimizer* om, ssa_builder* builder)
 {
     for (size_t i = 0; i < om->profile.num_variables; i++)
     {
-        variable_ssa_info* info = &builder->variables[i];
-        variable_version_stack* v = info->vvs;
-        variable_version_stack* next = NULL;
-
-        while (v)
-        {
-            next = v->next;
-            free(v);
-            v = next;
-        }
-
-        release_index_set(&info->blocks);
+        release_index_set(&builder->variables[i].blocks);
     }
 
     release_index_set(&builder->globals);
+    release_index_set(&builder->phi_blocks);
     free(builder->variables);
+    free(builder->frames);
+
+    if (OPTIMIZER_SSA == OPTIMIZER_SSA_PRUNED)
+    {
+        release_dataflow(&builder->liveness);
+    }
 }
 
 static variable_ssa_info* ssa_get_variable_info(optimizer* om, ssa_builder* builder, const definition* variable)
@@ -165,6 +165,65 @@ static variable_ssa_info* ssa_get_variable_info(optimizer* om, ssa_builder* buil
     return &builder->variables[varmap_varid2idx(om, variable)];
 }
 
+/**
+ * push a version frame of variable
+*/
+static void ssa_builder_push_frame(ssa_builder* builder, size_t var_idx, size_t version, instruction* source)
+{
+    variable_ssa_info* info = &builder->variables[var_idx];
+    variable_version_frame* frame;
+
+    if (builder->num_frames >= builder->size_frames)
+    {
+        fprintf(stderr, "TODO ERROR: internal error: SSA version stack overflow\n");
+        builder->size_frames = builder->size_frames * 2 + 1;
+        builder->frames = (variable_version_frame*)realloc_assert(
+            builder->frames, sizeof(variable_version_frame) * builder->size_frames);
+    }
+
+    frame = &builder->frames[builder->num_frames];
+    frame->version = version;
+    frame->source = source;
+    frame->variable = var_idx;
+    frame->below = info->top;
+
+    info->top = builder->num_frames++;
+}
+
+/**
+ * allocate version stack before renaming
+ *
+ * every frame comes from either an instruction with lvalue, including
+ * PHIs placed so far, or version 0 of a member, so the profile bounds it
+*/
+static void ssa_builder_init_frames(optimizer* om, ssa_builder* builder)
+{
+    builder->size_frames = max(om->profile.num_instructions + om->profile.num_members, 1);
+    builder->frames = (variable_version_frame*)malloc_assert(sizeof(variable_version_frame) * builder->size_frames);
+    builder->num_frames = 0;
+
+    for (size_t i = 0; i < om->profile.num_members; i++)
+    {
+        if (is_def_user_defined_variable(om->variables[i].ref))
+        {
+            ssa_builder_push_frame(builder, i, 0, NULL);
+        }
+    }
+}
+
+/**
+ * undo versions pushed since mark, restoring each variable's top
+*/
+static void ssa_builder_undo_frames(ssa_builder* builder, size_t mark)
+{
+    while (builder->num_frames > mark)
+    {
+        variable_version_frame* frame = &builder->frames[--builder->num_frames];
+
+        builder->variables[frame->variable].top = frame->below;
+    }
+}
+
 static void ssa_builder_generate_variable_version(
     optimizer* om,
     ssa_builder* builder,
@@ -176,16 +235,12 @@ static void ssa_builder_generate_variable_version(
 
     if (!is_def_user_defined_variable(variable)) { return; }
 
-    variable_ssa_info* info = &builder->variables[varmap_varid2idx(om, variable)];
-    variable_version_stack* frame = (variable_version_stack*)malloc_assert(sizeof(variable_version_stack));
-    variable_version_stack* top = info->vvs;
+    size_t var_idx = varmap_varid2idx(om, variable);
+    variable_ssa_info* info = &builder->variables[var_idx];
     size_t i = info->version_counter;
 
     // push version i onto stack
-    frame->version = i;
-    frame->source = source;
-    frame->next = top;
-    info->vvs = frame;
+    ssa_builder_push_frame(builder, var_idx, i, source);
 
     // increment counter and set reference version properly
     info->version_counter++;
@@ -198,34 +253,56 @@ static void ssa_builder_get_variable_version(optimizer* om, ssa_builder* builder
 
     if (!is_def_user_defined_variable(variable)) { return; }
 
-    ref->ver = ssa_get_variable_info(om, builder, variable)->vvs->version;
+    size_t top = ssa_get_variable_info(om, builder, variable)->top;
+
+    if (top == SSA_VERSION_NONE) { return; }
+
+    ref->ver = builder->frames[top].version;
 }
 
 /**
- *
+ * source instruction of current version, NULL for member version 0
 */
 static instruction* ssa_builder_get_variable_source(optimizer* om, ssa_builder* builder, const definition* variable)
 {
     if (!variable) { return NULL; }
 
-    return ssa_get_variable_info(om, builder, variable)->vvs->source;
+    size_t top = ssa_get_variable_info(om, builder, variable)->top;
+
+    // no definition reaches along this edge, only possible in MINIMAL
+    return top != SSA_VERSION_NONE ? builder->frames[top].source : NULL;
 }
 
-static void ssa_builder_pop_variable_version(optimizer* om, ssa_builder* builder, const definition* variable)
+/**
+ * record use of a variable, it is upward exposed if not killed yet
+*/
+static void ssa_builder_use_variable(optimizer* om, ssa_builder* builder, const index_set* kill, index_set* gen, const reference* ref)
 {
-    if (!is_def_user_defined_variable(variable)) { return; }
+    if (!ref) { return; }
+
+    definition* d = ref->def;
 
-    variable_ssa_info* info = ssa_get_variable_info(om, builder, variable);
-    variable_version_stack* top = info->vvs;
+    if (!is_def_user_defined_variable(d)) { return; }
 
-    if (!top) { return; }
+    size_t idx = varmap_varid2idx(om, d);
 
-    info->vvs = top->next;
-    free(top);
+    if (!index_set_contains(kill, idx))
+    {
+        index_set_add(&builder->globals, idx);
+
+        if (gen) { index_set_add(gen, idx); }
+    }
 }
 
+/**
+ * Collect Globals and Definition Blocks
+ *
+ * for PRUNED, upward exposed uses and definitions of each block
+ * also seed block liveness, which is solved here
+*/
 static void optimizer_ssa_build_globals(optimizer* om, ssa_builder* builder)
 {
+    bool pruned = OPTIMIZER_SSA == OPTIMIZER_SSA_PRUNED;
     index_set kill;
 
     init_index_set(&kill, om->profile.num_variables);
@@ -233,67 +310,79 @@ static void optimizer_ssa_build_globals(optimizer* om, ssa_builder* builder)
     for (size_t i = 0; i < builder->num_nodes; i++)
     {
         basic_block* bb = om->node_postorder[i];
+        index_set* gen = pruned ? &builder->liveness.gen[bb->id] : NULL;
 
         index_set_clear(&kill);
 
         // node order does not matter
         for (instruction* p = bb->inst_first; p != NULL; p = p->next)
         {
-            definition* d;
-            size_t idx;
-
-            if (p->operand_1)
-            {
-                d = p->operand_1->def;
-
-                if (is_def_user_defined_variable(d))
-                {
-                    idx = varmap_varid2idx(om, d);
-
-                    if (!index_set_contains(&kill, idx))
-                    {
-                        index_set_add(&builder->globals, idx);
-                    }
-                }
-            }
-
-            if (p->operand_2)
-            {
-                d = p->operand_2->def;
-
-                if (is_def_user_defined_variable(d))
-                {
-                    idx = varmap_varid2idx(om, d);
-
-                    if (!index_set_contains(&kill, idx))
-                    {
-                        index_set_add(&builder->globals, idx);
-                    }
-                }
-            }
+            ssa_builder_use_variable(om, builder, &kill, gen, p->operand_1);
+            ssa_builder_use_variable(om, builder, &kill, gen, p->operand_2);
 
             if (p->lvalue)
             {
-                d = p->lvalue->def;
+                definition* d = p->lvalue->def;
 
                 if (is_def_user_defined_variable(d))
                 {
-                    idx = varmap_varid2idx(om, d);
+                    size_t idx = varmap_varid2idx(om, d);
+
                     index_set_add(&kill, idx);
                     index_set_add(&builder->variables[idx].blocks, bb->id);
                 }
             }
         }
+
+        if (pruned)
+        {
+            index_set_union(&builder->liveness.kill[bb->id], &kill);
+        }
     }
 
     release_index_set(&kill);
+
+    if (pruned)
+    {
+        dataflow_solve(&builder->liveness);
+        om->ssa_stats.liveness = builder->liveness.stats;
+    }
+}
+
+/**
+ * test if a PHI of variable is needed at given node
+ *
+ * MINIMAL: always
+ * SEMI_PRUNED: variable is live across blocks somewhere
+ * PRUNED: variable is live-in at node
+*/
+static bool ssa_builder_phi_needed(ssa_builder* builder, size_t var_idx, size_t node_id)
+{
+    switch (OPTIMIZER_SSA)
+    {
+        case OPTIMIZER_SSA_MINIMAL:
+            return true;
+        case OPTIMIZER_SSA_SEMI_PRUNED:
+            return index_set_contains(&builder->globals, var_idx);
+        case OPTIMIZER_SSA_PRUNED:
+            return index_set_contains(&builder->liveness.in[node_id], var_idx);
+        default:
+            fprintf(stderr, "TODO ERROR: internal error: unknown SSA construction %d\n", OPTIMIZER_SSA);
+            return true;
+    }
 }
 
 /**
  * insert phi instruction for given variable
+ *
+ * candidates are iterated dominance frontier of definition blocks,
+ * which is what minimal SSA places; a candidate rejected by current
+ * construction is counted as avoided in a stats build
 */
-static void optimizer_ssa_place_phi(optimizer* om, ssa_builder* builder, definition* variable, index_set* df)
+static void optimizer_ssa_place_phi(optimizer* om, ssa_builder* builder, size_t var_idx, index_set* df)
 {
+    definition* variable = om->variables[var_idx].ref;
+
     /**
      * Only "variable" defined by user will be considered
      * (thus: variables written in the source code file)
@@ -309,7 +398,8 @@ static void optimizer_ssa_place_phi(optimizer* om, ssa_builder* builder, definit
     index_set_iterator itor_set;
     size_t n;
 
-    init_index_set_copy(&worklist, &ssa_get_variable_info(om, builder, variable)->blocks);
+    init_index_set_copy(&worklist, &builder->variables[var_idx].blocks);
+    index_set_clear(&builder->phi_blocks);
 
     while (index_set_pop(&worklist, &n))
     {
@@ -317,11 +407,22 @@ static void optimizer_ssa_place_phi(optimizer* om, ssa_builder* builder, definit
 
         while (!index_set_iterator_end(&itor_set))
         {
-            basic_block* node = om->graph->nodes.arr[index_set_iterator_get(&itor_set)];
+            size_t m = index_set_iterator_get(&itor_set);
 
-            if (optimizer_phi_place(om, node, variable))
+            if (!index_set_contains(&builder->phi_blocks, m))
             {
-                index_set_add(&worklist, node->id);
+                index_set_add(&builder->phi_blocks, m);
+                index_set_add(&worklist, m);
+
+                if (ssa_builder_phi_needed(builder, var_idx, m))
+                {
+                    optimizer_phi_place(om, om->graph->nodes.arr[m], variable);
+                    om->ssa_stats.num_phi_placed++;
+                }
+                else if (OPTIMIZER_SSA_STATS)
+                {
+                    om->ssa_stats.num_phi_avoided++;
+                }
             }
 
             index_set_iterator_next(&itor_set);
@@ -336,52 +437,39 @@ static void optimizer_ssa_place_phi(optimizer* om, ssa_builder* builder, definit
 /**
  * Rename Variables
  *
- * Iterative DFS Walk order on dominator tree
+ * Iterative DFS Walk order on dominator tree, children are visited
+ * in ascending id order
+ *
+ * walk stack records each block with its next child and the version
+ * stack mark on entry, leaving a block undoes all its versions
 */
-static void optimizer_ssa_rename_variable(optimizer* om, ssa_builder* builder, basic_block** idom)
+static void optimizer_ssa_rename_variable(optimizer* om, ssa_builder* builder, const dom_tree* tree)
 {
     size_t num_nodes = om->profile.num_nodes;
-    index_set* domtree_node_children = (index_set*)malloc_assert(sizeof(index_set) * num_nodes);
-    bool* domtree_node_visited = (bool*)malloc_assert(sizeof(bool) * num_nodes);
-    bool domtree_visiting_next;
-    size_t dometree_next;
-    node_walk_stack* dometree_node_stack = NULL;
+    size_t* walk_child = (size_t*)malloc_assert(sizeof(size_t) * num_nodes);
+    size_t* walk_mark = (size_t*)malloc_assert(sizeof(size_t) * num_nodes);
+    size_t top = 0;
+    size_t next = om->graph->entry->id;
     instruction* inst;
 
-    // initialize dominator tree
-    for (size_t i = 0; i < num_nodes; i++)
-    {
-        init_index_set(&domtree_node_children[i], num_nodes);
-        domtree_node_visited[i] = false;
-    }
-
-    // construct dominator tree, simply inverse idom array
-    for (size_t i = 0; i < num_nodes; i++)
-    {
-        index_set_add(&domtree_node_children[idom[i]->id], i);
-    }
+    ssa_builder_init_frames(om, builder);
 
     // start from entry node
-    dometree_node_stack = node_stack_push(dometree_node_stack, om->graph->entry);
-
     while (true)
     {
-        basic_block* bb = node_stack_top(dometree_node_stack);
-
-        // if stack is empty, we are done
-        if (!bb)
-        {
-            break;
-        }
-
         /**
          * Pre-order
          *
-         * if visit of this node is first time, work on SSA
-         * otherwise just skip this part, and do DFS part
+         * first visit of a node, work on SSA
         */
-        if (!domtree_node_visited[bb->id])
+        if (next != DOM_TREE_NONE)
         {
+            basic_block* bb = om->graph->nodes.arr[next];
+
+            walk_child[top] = tree->child[next];
+            walk_mark[top] = builder->num_frames;
+            top++;
+
             // for each x = PHI(...)
             for (inst = bb->inst_first; inst && inst->op == IROP_PHI; inst = inst->next)
             {
@@ -412,56 +500,40 @@ static void optimizer_ssa_rename_variable(optimizer* om, ssa_builder* builder, b
             }
         }
 
-        /**
-         * DFS Walk
-         *
-         * Now current node has been visited
-         * Once reached an unvisited child, push onto stack and start over
-        */
-        domtree_visiting_next = false;
-        domtree_node_visited[bb->id] = true;
-        while (index_set_pop(&domtree_node_children[bb->id], &dometree_next))
+        // if stack is empty, we are done
+        if (!top)
         {
-            if (!domtree_node_visited[dometree_next])
-            {
-                domtree_visiting_next = true;
-                dometree_node_stack = node_stack_push(dometree_node_stack, om->graph->nodes.arr[dometree_next]);
-                break;
-            }
+            break;
         }
 
         /**
          * DFS Walk
          *
-         * if no child left, we are done with this node, pop all versions used in this block
+         * descend into next child if any, otherwise we are done with
+         * this node, undo all versions generated in its block
         */
-        if (!domtree_visiting_next)
-        {
-            for (inst = bb->inst_first; inst; inst = inst->next)
-            {
-                ssa_builder_pop_variable_version(om, builder, ref2def(inst->lvalue));
-            }
+        next = walk_child[top - 1];
 
-            dometree_node_stack = node_stack_pop(dometree_node_stack);
+        if (next != DOM_TREE_NONE)
+        {
+            walk_child[top - 1] = tree->sibling[next];
+        }
+        else
+        {
+            top--;
+            ssa_builder_undo_frames(builder, walk_mark[top]);
         }
     }
 
-    // cleanup
-
-    for (size_t i = 0; i < num_nodes; i++)
-    {
-        release_index_set(&domtree_node_children[i]);
-    }
-
-    free(domtree_node_children);
-    free(domtree_node_visited);
+    free(walk_child);
+    free(walk_mark);
 }
 
 /**
  * Convert CFG To SSA
  *
- * 1. Compute DF
- * 2. Place PHI
+ * 1. Build dominator tree, compute DF from it
+ * 2. Place PHI, pruned as selected by OPTIMIZER_SSA
  * 3. Rename variables
  *
  * NOTE: it will repopulate optimizer::variables array
@@ -470,28 +542,43 @@ static void optimizer_ssa_rename_variable(optimizer* om, ssa_builder* builder, b
 void optimizer_ssa_build(optimizer* om)
 {
     ssa_builder builder;
-    basic_block** idom = cfg_idom(om->graph, om->node_postorder);
-    index_set* df = cfg_dominance_frontiers(om->graph, idom);
+    dom_tree tree;
+    index_set* df;
     size_t v;
 
+    init_dom_tree(&tree, om->graph);
+    df = dom_tree_frontiers(&tree, om->graph);
+
     // initialize builder
     ssa_builder_init(om, &builder);
 
     // prepare global set
     optimizer_ssa_build_globals(om, &builder);
 
-    // phi placement for every variable in global set
-    while (index_set_pop(&builder.globals, &v))
+    // phi placement, pruning is decided per node
+    for (v = 0; v < om->profile.num_variables; v++)
     {
-        optimizer_ssa_place_phi(om, &builder, om->variables[v].ref, df);
+        /**
+         * a variable not in global set is never live-in, so unless
+         * stats are counted, skip its frontier walk in SEMI_PRUNED and
+         * PRUNED, as every candidate would be rejected
+        */
+        if (!OPTIMIZER_SSA_STATS &&
+            OPTIMIZER_SSA != OPTIMIZER_SSA_MINIMAL &&
+            !index_set_contains(&builder.globals, v))
+        {
+            continue;
+        }
+
+        optimizer_ssa_place_phi(om, &builder, v, df);
     }
 
     // rename variable for each node
-    optimizer_ssa_rename_variable(om, &builder, idom);
+    optimizer_ssa_rename_variable(om, &builder, &tree);
 
     // cleanup
     ssa_builder_release(om, &builder);
-    cfg_delete_idom(idom);
+    release_dom_tree(&tree);
     cfg_delete_dominance_frontiers(om->graph, df);
 }
 
@@ -268,6 +268,9 @@ void optimizer_profile_apply(optimizer* om, optimizer_profile* profile, bool mak
             // unused variables will not be registered in optimizer as the source is CFG IR instruction object
             if (!om->variables[k].ref) { continue; }
 
+            // member definition is shared by all methods and never allocated, so leave it untouched
+            if (varmap_idx_is_member(om, k)) { continue; }
+
             memcpy(&om->variables[k].ref->variable->allocation, &om->variables[k].allocation, sizeof(register_allocation_info));
         }
 
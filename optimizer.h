@@ -20,6 +20,65 @@ typedef enum _linear_allocator_range_process
     LINEAR_ALLOCATOR_RANGE_MERGE,
 } linear_allocator_range_process;
 
+/**
+ * Liveness Solver
+ *
+ * BLOCK: solve on basic blocks, then expand to instructions
+ * INSTRUCTION: solve on instructions directly
+ * VERIFY: run both and report any mismatch
+ *
+ * select one per build with OPTIMIZER_LIVENESS
+*/
+#define OPTIMIZER_LIVENESS_BLOCK 0
+#define OPTIMIZER_LIVENESS_INSTRUCTION 1
+#define OPTIMIZER_LIVENESS_VERIFY 2
+
+#ifndef OPTIMIZER_LIVENESS
+#define OPTIMIZER_LIVENESS OPTIMIZER_LIVENESS_BLOCK
+#endif
+
+/**
+ * SSA Construction
+ *
+ * MINIMAL: PHI on iterated dominance frontier of every variable
+ * SEMI_PRUNED: skip variables that are never live across blocks
+ * PRUNED: PHI only where variable is live-in, needs block liveness
+ *
+ * select one per build with OPTIMIZER_SSA
+*/
+#define OPTIMIZER_SSA_MINIMAL 0
+#define OPTIMIZER_SSA_SEMI_PRUNED 1
+#define OPTIMIZER_SSA_PRUNED 2
+
+#ifndef OPTIMIZER_SSA
+#define OPTIMIZER_SSA OPTIMIZER_SSA_PRUNED
+#endif
+
+/**
+ * SSA Construction Stats Build
+ *
+ * avoided PHIs are counted against minimal SSA, which needs a walk on
+ * iterated dominance frontier of every variable, even the ones
+ * SEMI_PRUNED and PRUNED skip; so they are counted only if
+ * OPTIMIZER_SSA_STATS is set
+*/
+#ifndef OPTIMIZER_SSA_STATS
+#define OPTIMIZER_SSA_STATS 0
+#endif
+
+/**
+ * SSA Construction Stats
+ *
+ * num_phi_avoided stays 0 unless OPTIMIZER_SSA_STATS is set
+*/
+typedef struct _optimizer_ssa_stats
+{
+    size_t num_phi_placed;
+    size_t num_phi_avoided;
+    // block liveness convergence, PRUNED only
+    dataflow_stats liveness;
+} optimizer_ssa_stats;
+
 /**
  * Variable Item
  *
@@ -121,6 +180,21 @@ typedef struct _optimizer
      * All temp variables generated by code spilling will be stored here
     */
     definition_pool spill_pool;
+
+    /**
+     * SSA Construction Stats
+     *
+     * filled by optimizer_ssa_build
+    */
+    optimizer_ssa_stats ssa_stats;
+
+    /**
+     * Liveness Convergence Stats
+     *
+     * filled by the last optimizer_liveness_analyze on blocks,
+     * left 0 by the instruction level solver
+    */
+    dataflow_stats liveness_stats;
 } optimizer;
 
 definition* ref2def(const reference* r);
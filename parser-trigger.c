@@ -7,22 +7,88 @@
 
 #include "parser.h"
 
-bool parser_trigger_name(java_parser* parser, size_t peek_from)
+typedef bool (*parser_trigger_func)(java_parser*, size_t);
+
+/**
+ * Reset trigger memo table and statistics
+*/
+void parser_trigger_memo_reset(java_parser* parser, bool enabled)
+{
+    parser_trigger_memo* memo = &parser->trigger_memo;
+
+    memo->enabled = enabled;
+    memo->num_hit = 0;
+    memo->num_miss = 0;
+
+    for (size_t i = 0; i < PARSER_TRIGGER_MEMO_SIZE; i++)
+    {
+        memo->entries[i].position = SIZE_MAX;
+        memo->entries[i].known = 0;
+        memo->entries[i].result = 0;
+    }
+}
+
+/**
+ * Memoized trigger evaluation
+ *
+ * nested triggers at same position share one entry, so the entry is
+ * re-read after evaluation instead of cached before it
+*/
+static bool parser_trigger_memoized(
+    java_parser* parser,
+    size_t peek_from,
+    parser_trigger_kind kind,
+    parser_trigger_func f)
+{
+    parser_trigger_memo* memo = &parser->trigger_memo;
+    size_t position = parser->token_position + peek_from;
+    parser_trigger_memo_entry* entry = &memo->entries[position & (PARSER_TRIGGER_MEMO_SIZE - 1)];
+    bbit_flag bit = (bbit_flag)(1 << kind);
+    bool ret;
+
+    if (!memo->enabled)
+    {
+        return (*f)(parser, peek_from);
+    }
+
+    if (entry->position == position && (entry->known & bit))
+    {
+        memo->num_hit++;
+        return (entry->result & bit) != 0;
+    }
+
+    memo->num_miss++;
+    ret = (*f)(parser, peek_from);
+
+    if (entry->position != position)
+    {
+        entry->position = position;
+        entry->known = 0;
+        entry->result = 0;
+    }
+
+    entry->known |= bit;
+    entry->result |= ret ? bit : 0;
+
+    return ret;
+}
+
+static bool __parser_trigger_name(java_parser* parser, size_t peek_from)
 {
     return peek_token_class_is(parser, peek_from, JT_IDENTIFIER);
 }
 
-bool parser_trigger_class_type(java_parser* parser, size_t peek_from)
+static bool __parser_trigger_class_type(java_parser* parser, size_t peek_from)
 {
     return peek_token_class_is(parser, peek_from, JT_IDENTIFIER);
 }
 
-bool parser_trigger_interface_type(java_parser* parser, size_t peek_from)
+static bool __parser_trigger_interface_type(java_parser* parser, size_t peek_from)
 {
     return peek_token_class_is(parser, peek_from, JT_IDENTIFIER);
 }
 
-bool parser_trigger_type(java_parser* parser, size_t peek_from)
+static bool __parser_trigger_type(java_parser* parser, size_t peek_from)
 {
     return peek_token_is_primitive_type(parser, peek_from) ||
         peek_token_class_is(parser, peek_from, JT_IDENTIFIER);
@@ -33,7 +99,7 @@ bool parser_trigger_type(java_parser* parser, size_t peek_from)
  *
  * left parenthesis here is for: ( Expression )
 */
-bool parser_trigger_primary(java_parser* parser, size_t peek_from)
+static bool __parser_trigger_primary(java_parser* parser, size_t peek_from)
 {
     switch (peek_token_type(parser, peek_from))
     {
@@ -62,7 +128,7 @@ bool parser_trigger_primary(java_parser* parser, size_t peek_from)
  *
  * NOTE: parenthesis is handled in Primary, see comment for reasoning
 */
-bool parser_trigger_expression(java_parser* parser, size_t peek_from)
+static bool __parser_trigger_expression(java_parser* parser, size_t peek_from)
 {
     switch (peek_token_type(parser, peek_from))
     {
@@ -88,7 +154,7 @@ bool parser_trigger_expression(java_parser* parser, size_t peek_from)
  * parser functions, so we cover both cases and use function parameter to
  * conditionally accept variable declaration
 */
-bool parser_trigger_statement(java_parser* parser, size_t peek_from)
+static bool __parser_trigger_statement(java_parser* parser, size_t peek_from)
 {
     switch (peek_token_type(parser, peek_from))
     {
@@ -110,3 +176,40 @@ bool parser_trigger_statement(java_parser* parser, size_t peek_from)
             return parser_trigger_type(parser, peek_from) || parser_trigger_expression(parser, peek_from);
     }
 }
+
+/* MEMOIZED TRIGGERS */
+
+bool parser_trigger_name(java_parser* parser, size_t peek_from)
+{
+    return parser_trigger_memoized(parser, peek_from, PARSER_TRIGGER_NAME, &__parser_trigger_name);
+}
+
+bool parser_trigger_class_type(java_parser* parser, size_t peek_from)
+{
+    return parser_trigger_memoized(parser, peek_from, PARSER_TRIGGER_CLASS_TYPE, &__parser_trigger_class_type);
+}
+
+bool parser_trigger_interface_type(java_parser* parser, size_t peek_from)
+{
+    return parser_trigger_memoized(parser, peek_from, PARSER_TRIGGER_INTERFACE_TYPE, &__parser_trigger_interface_type);
+}
+
+bool parser_trigger_type(java_parser* parser, size_t peek_from)
+{
+    return parser_trigger_memoized(parser, peek_from, PARSER_TRIGGER_TYPE, &__parser_trigger_type);
+}
+
+bool parser_trigger_primary(java_parser* parser, size_t peek_from)
+{
+    return parser_trigger_memoized(parser, peek_from, PARSER_TRIGGER_PRIMARY, &__parser_trigger_primary);
+}
+
+bool parser_trigger_expression(java_parser* parser, size_t peek_from)
+{
+    return parser_trigger_memoized(parser, peek_from, PARSER_TRIGGER_EXPRESSION, &__parser_trigger_expression);
+}
+
+bool parser_trigger_statement(java_parser* parser, size_t peek_from)
+{
+    return parser_trigger_memoized(parser, peek_from, PARSER_TRIGGER_STATEMENT, &__parser_trigger_statement);
+}
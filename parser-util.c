@@ -1,48 +1,208 @@
 #include "parser.h"
 
+#define TOKEN_RING_INDEX(parser, idx) (((parser)->token_head + (idx)) & (PARSER_LOOKAHEAD_SIZE - 1))
+
+/**
+ * last stream entry the parser has buffered, NULL if none
+ *
+ * lexer cursor sits right after this entry in on-demand mode
+*/
+static java_token_entry* parser_stream_last_entry(java_parser* parser)
+{
+    java_token_stream* ts = parser->token_stream;
+    size_t idx = parser->token_position + parser->num_token_available;
+
+    return idx > 0 ? &ts->arr[min(idx, ts->num) - 1] : NULL;
+}
+
+/**
+ * location of lexer cursor, as if tokens were lexed on demand
+*/
+static line parser_cursor_line(java_parser* parser)
+{
+    java_token_entry* entry;
+
+    if (!parser->token_stream)
+    {
+        return parser->lexer->ln_cur;
+    }
+
+    entry = parser_stream_last_entry(parser);
+
+    if (!entry)
+    {
+        return LINE(1, 1);
+    }
+
+    return LINE(entry->ln, entry->class == JT_EOF ? entry->col : entry->col + entry->length);
+}
+
+/**
+ * save parser state into checkpoint
+*/
+void parser_checkpoint_save(java_parser* parser, parser_checkpoint* cp)
+{
+    cp->token_position = parser->token_position;
+    cp->stream = parser->logger->current_stream;
+
+    if (parser->token_stream)
+    {
+        // cursor is only compared and reported, so rebuild it
+        // from the last buffered entry; look-aheads are not copied
+        // but re-expanded on restore, so cursor stays the same
+        java_token_entry* entry = parser_stream_last_entry(parser);
+
+        cp->cur = parser->lexer->buffer->base + (entry ? entry->offset + entry->length : 0);
+        cp->num_token_available = parser->num_token_available;
+        return;
+    }
+
+    cp->cur = parser->lexer->buffer->cur;
+    cp->ln_cur = parser->lexer->ln_cur;
+    cp->ln_prev = parser->lexer->ln_prev;
+    for (size_t i = 0; i < parser->num_token_available; i++)
+    {
+        cp->tokens[i] = parser->tokens[TOKEN_RING_INDEX(parser, i)];
+    }
+
+    cp->num_token_available = parser->num_token_available;
+}
+
+/**
+ * roll parser state back (or forward) to checkpoint
+ *
+ * if error stream mark is NULL, current stream is kept
+*/
+void parser_checkpoint_restore(java_parser* parser, const parser_checkpoint* cp)
+{
+    if (!parser->token_stream)
+    {
+        parser->lexer->buffer->cur = cp->cur;
+        parser->lexer->ln_cur = cp->ln_cur;
+        parser->lexer->ln_prev = cp->ln_prev;
+        memcpy(parser->tokens, cp->tokens, sizeof(java_token) * cp->num_token_available);
+    }
+
+    parser->token_head = 0;
+    parser->num_token_available = parser->token_stream ? 0 : cp->num_token_available;
+    parser->token_position = cp->token_position;
+
+    // same look-aheads as on demand, so cursor of next save matches
+    if (parser->token_stream && cp->num_token_available)
+    {
+        token_peek(parser, cp->num_token_available - 1);
+    }
+
+    if (cp->stream)
+    {
+        parser->logger->current_stream = cp->stream;
+    }
+}
+
+/**
+ * save parser position
+*/
+void parser_position_save(java_parser* parser, parser_position* pos)
+{
+    java_lexer* lexer = parser->lexer;
+
+    pos->token_position = parser->token_position;
+    pos->num_token_available = parser->num_token_available;
+    pos->ln_prev = lexer->ln_prev;
+
+    if (parser->num_token_available == 0)
+    {
+        pos->cur = lexer->buffer->cur;
+        pos->ln_cur = lexer->ln_cur;
+    }
+    else
+    {
+        java_token* first = &parser->tokens[parser->token_head];
+
+        pos->cur = first->from;
+        pos->ln_cur = first->ln_begin;
+    }
+}
+
+/**
+ * restore parser position, then read look-aheads again
+ *
+ * re-reading them ends up in the same lexer state as when saved;
+ * ln_prev only changes on newline, so it either stays as saved or
+ * gets the same value again
+*/
+void parser_position_restore(java_parser* parser, const parser_position* pos)
+{
+    if (!parser->token_stream)
+    {
+        parser->lexer->buffer->cur = pos->cur;
+        parser->lexer->ln_cur = pos->ln_cur;
+        parser->lexer->ln_prev = pos->ln_prev;
+    }
+
+    parser->token_head = 0;
+    parser->num_token_available = 0;
+    parser->token_position = pos->token_position;
+
+    if (pos->num_token_available)
+    {
+        token_peek(parser, pos->num_token_available - 1);
+    }
+}
+
 /**
  * peek a token, and load into buffer if not yet buffered
+ *
+ * look-aheads live in a ring buffer, idx is relative to ring head;
+ * with a token stream attached, they are expanded from stream entry
+ * at token position instead of lexed
 */
 java_token* token_peek(java_parser* parser, size_t idx)
 {
+    java_token* token;
+
     // guard
-    if (idx >= 4)
+    if (idx >= PARSER_LOOKAHEAD_SIZE)
     {
         return NULL;
     }
 
-    // access
-    if (idx + 1 <= parser->num_token_available)
-    {
-        return parser->tokens + idx;
-    }
-
     // buffer it if not yet available
-    for (size_t i = parser->num_token_available; i <= idx; i++)
+    while (parser->num_token_available <= idx)
     {
-        lexer_next_token(parser->lexer, parser->tokens + i);
+        token = parser->tokens + TOKEN_RING_INDEX(parser, parser->num_token_available);
 
-        // discard comments
-        while (parser->tokens[i].class == JT_COMMENT)
+        if (parser->token_stream)
         {
-            lexer_next_token(parser->lexer, parser->tokens + i);
+            token_stream_get(
+                parser->token_stream,
+                parser->lexer->buffer,
+                parser->token_position + parser->num_token_available,
+                token
+            );
+        }
+        else
+        {
+            // discard comments
+            do
+            {
+                lexer_next_token(parser->lexer, token);
+            } while (token->class == JT_COMMENT);
         }
-    }
 
-    // update counter only when buffer loads new token
-    if (parser->num_token_available <= idx)
-    {
-        parser->num_token_available = idx + 1;
+        parser->num_token_available++;
     }
 
     // return the queried peek
-    return parser->tokens + idx;
+    return parser->tokens + TOKEN_RING_INDEX(parser, idx);
 }
 
 /**
  * consume first token in buffer, and write a copy to dest
  * if dest not specified, token will be dropped
  * if buffer is empty, it is no-op
+ *
+ * consumption only moves ring head
 */
 void consume_token(java_parser* parser, java_token* dest)
 {
@@ -54,16 +214,12 @@ void consume_token(java_parser* parser, java_token* dest)
     // save a copy to dest
     if (dest)
     {
-        memcpy(dest, parser->tokens, sizeof(java_token));
-    }
-
-    // shift buffer to left by 1 unit
-    for (size_t i = 1; i < parser->num_token_available; i++)
-    {
-        memcpy(parser->tokens + i - 1, parser->tokens + i, sizeof(java_token));
+        *dest = parser->tokens[parser->token_head];
     }
 
+    parser->token_head = TOKEN_RING_INDEX(parser, 1);
     parser->num_token_available--;
+    parser->token_position++;
 }
 
 java_token_class peek_token_class(java_parser* parser, size_t idx)
@@ -144,8 +300,10 @@ void parser_error(java_parser* parser, java_error_id id, ...)
 {
     va_list args;
 
+    line ln = parser_cursor_line(parser);
+
     va_start(args, id);
-    error_logger_vslog(parser->logger, &parser->lexer->ln_cur, NULL, id, &args);
+    error_logger_vslog(parser->logger, &ln, NULL, id, &args);
     va_end(args);
 
     parser_recovery_dispatch(parser, id);
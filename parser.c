@@ -50,122 +50,125 @@ void init_parser(
     java_lexer* lexer,
     hash_table* rw,
     java_expression* expr,
+    arena* ast_arena,
     java_error_logger* logger
 )
 {
-    parser->is_copy = false; // MUST be false from this routine
-
     // tokens contains garbage data if not used
     // so the counter is important
+    parser->token_head = 0;
     parser->num_token_available = 0;
+    parser->token_position = 0;
 
     parser->lexer = lexer;
+    parser->token_stream = NULL;
     parser->reserved_words = rw;
     parser->ast_root = NULL;
+    parser->ast_arena = ast_arena;
+    parser->memo = NULL;
     parser->expression = expr;
     parser->logger = logger;
+
+    parser_trigger_memo_reset(parser, false);
 }
 
 /**
- * Copy parser instance
- *
- * a copy of parser instance has shallow copy of all static data,
- * and does not copy AST
+ * Release parser instance
+*/
+void release_parser(java_parser* parser)
+{
+    // AST and memo table are owned by arena
+    parser->ast_root = NULL;
+    parser->memo = NULL;
+}
+
+/**
+ * Switch parser onto a pre-tokenized stream
  *
- * 1. copy parser instance MUST ALWAYS start from a new AST
- * 2. error logger is a singleton so no copy is allowed
- * 3. lexer needs a copy, while the file map in file buffer does not
+ * must be done before first peek; stream must outlive parsing
 */
-void copy_parser(java_parser* from, java_parser* to)
+void parser_attach_token_stream(java_parser* parser, java_token_stream* stream)
 {
-    memcpy(to, from, sizeof(java_parser));
+    parser->token_stream = stream;
+    parser->token_head = 0;
+    parser->num_token_available = 0;
+    parser->token_position = 0;
+}
 
-    // set copy flag
-    to->is_copy = true;
+/* HELPER FUNCTIONS */
 
-    /**
-     * a copy of parser insatnce should never affect current AST
-     *
-     * AST is complex, and should always manipulate only from
-     * the original reference
-    */
-    to->ast_root = NULL;
+/**
+ * memo table slot of a production at a token position
+*/
+static parser_memo_entry* parser_memo_slot(java_parser* parser, parser_func f, byte* from)
+{
+    size_t h = (size_t)from * 31 + (size_t)f;
 
-    // copy lexer
-    to->lexer = copy_lexer(from->lexer);
+    if (!parser->memo)
+    {
+        parser->memo = (parser_memo_entry*)
+            arena_alloc(parser->ast_arena, sizeof(parser_memo_entry) * PARSER_MEMO_SIZE);
+        memset(parser->memo, 0, sizeof(parser_memo_entry) * PARSER_MEMO_SIZE);
+    }
+
+    return &parser->memo[(h ^ (h >> 8)) & (PARSER_MEMO_SIZE - 1)];
 }
 
 /**
- * Mutate Parser Instance
+ * Speculative parse of a production
  *
- * Mutate main instance with copy instance
- * and copy instance will override the parser state
+ * if the same production was parsed at same token position without
+ * error, parser jumps to the memorized end state and gets a copy of
+ * the memorized subtree
  *
- * NOTE: copied fields are released by calling release_parser
- *
- * WARNING: the parser instance has shallow reference of data
- * by definition, so during swap all pointer references must
- * stay the same and perform deep copy as needed
- *
- * 1. lookaheads requires copy
- * 2. lexer needs to be (shallow) copied
- * 3. error logger is a singleton, no copy
- * 4. reserved words and expression data are static, no copy
+ * NOTE: caller must open a fresh ambiguity stream, so an empty stream
+ * after parsing means the production logged nothing
 */
-void mutate_parser(java_parser* parser, java_parser* copy)
+static tree_node* parse_speculative(java_parser* parser, parser_func f)
 {
-    // lookaheads: deep copy
-    memcpy(parser->tokens, copy->tokens, sizeof(java_token) * 4);
-    parser->num_token_available = copy->num_token_available;
+    byte* from = token_peek(parser, TOKEN_PEEK_1st)->from;
+    parser_memo_entry* entry = parser_memo_slot(parser, f, from);
+    tree_node* node;
 
-    /**
-     * Override Lexer
-     *
-     * file buffer is a bit tricky because there are 2 instances but
-     * pointer cannot be directly override
-     *
-     * luckily... from file buffer "cur" is only thing needed so
-     * override can be hancked here
-    */
-    file_buffer* buf = parser->lexer->buffer;
-    buf->cur = copy->lexer->buffer->cur;
-    memcpy(parser->lexer, copy->lexer, sizeof(java_lexer));
-    parser->lexer->buffer = buf;
+    if (entry->node && entry->func == f && entry->from == from)
+    {
+        parser_position_restore(parser, &entry->end);
+        return tree_node_copy(parser->ast_arena, entry->node);
+    }
+
+    node = (*f)(parser);
 
-    // guard: copy instance should not have AST
-    if (!copy->is_copy || copy->ast_root)
+    if (node && !parser->logger->current_stream->first)
     {
-        parser_error(parser, JAVA_E_PASER_SWAP_FAILED);
+        entry->func = f;
+        entry->from = from;
+        entry->node = tree_node_copy(parser->ast_arena, node);
+        parser_position_save(parser, &entry->end);
     }
+
+    return node;
 }
 
 /**
- * Release parser instance
+ * check terminator at the end state of a pathway
  *
- * if deleting a copy of parser instance, the AST data must be NULL
+ * peeking may load new tokens, so checkpoint is updated
 */
-void release_parser(java_parser* parser)
+static bool parser_pathway_terminated(java_parser* parser, parser_checkpoint* cp, java_lexeme_type terminator)
 {
-    if (parser->is_copy)
-    {
-        if (parser->ast_root)
-        {
-            parser_error(parser, JAVA_E_PASER_DELETE_FAILED);
-        }
+    bool ret;
 
-        // delete lexer instance
-        release_lexer(parser->lexer);
-        free(parser->lexer);
-    }
-    else
+    if (terminator == JLT_MAX)
     {
-        tree_node_delete(parser->ast_root);
+        return true;
     }
-}
 
-/* HELPER FUNCTIONS */
+    parser_checkpoint_restore(parser, cp);
+    ret = peek_token_type_is(parser, TOKEN_PEEK_1st, terminator);
+    parser_checkpoint_save(parser, cp);
 
-typedef tree_node* (*parser_func)(java_parser*);
+    return ret;
+}
 
 /**
  * Parser wrapper with ambiguity resolution
@@ -177,6 +180,9 @@ typedef tree_node* (*parser_func)(java_parser*);
  * if the terminator is included in both productions, use JLT_MAX as terminator
  * if a production is not clearly bounded by a terminal, do NOT use it
  *
+ * both productions start from same checkpoint, and parser rolls forward
+ * to the end state of the pathway it keeps
+ *
  * TODO: we probably need a clever way to propagate error messages
 */
 static tree_node* parse_binary_ambiguity(
@@ -190,49 +196,48 @@ static tree_node* parse_binary_ambiguity(
     tree_node* n2 = NULL;
     bool n1_valid = false;
     bool n2_valid = false;
+    parser_checkpoint start;
+    parser_checkpoint end_1;
+    parser_checkpoint end_2;
 
     // error logger follows singleton design
     java_error_logger* logger = parser->logger;
 
-    // copy parser instance
-    java_parser* parser_1 = (java_parser*)malloc_assert(sizeof(java_parser));
-    java_parser* parser_2 = (java_parser*)malloc_assert(sizeof(java_parser));
-    copy_parser(parser, parser_1);
-    copy_parser(parser, parser_2);
+    parser_checkpoint_save(parser, &start);
 
     // parse path 1
-    java_error_stack* tmp_cur = logger->current_stream;
     error_logger_ambiguity_begin(logger);
-    n1 = (*f1)(parser_1);
+    n1 = parse_speculative(parser, f1);
     n1_valid = error_logger_if_current_stack_no_error(logger);
     error_logger_ambiguity_end(logger);
+    parser_checkpoint_save(parser, &end_1);
 
     // parse path 2
+    parser_checkpoint_restore(parser, &start);
     error_logger_ambiguity_begin(logger);
-    n2 = (*f2)(parser_2);
+    n2 = parse_speculative(parser, f2);
     n2_valid = error_logger_if_current_stack_no_error(logger);
     error_logger_ambiguity_end(logger);
+    parser_checkpoint_save(parser, &end_2);
 
     // now current top should be the ambiguity entry
     java_error_entry* entry_amb = error_logger_get_current_top(logger);
 
     // verify terminator and determine final validity status
-    n1_valid = n1_valid &&
-        (terminator == JLT_MAX || peek_token_type_is(parser_1, TOKEN_PEEK_1st, terminator));
-    n2_valid = n2_valid &&
-        (terminator == JLT_MAX || peek_token_type_is(parser_2, TOKEN_PEEK_1st, terminator));
+    n1_valid = n1_valid && parser_pathway_terminated(parser, &end_1, terminator);
+    n2_valid = n2_valid && parser_pathway_terminated(parser, &end_2, terminator);
 
     if (n1_valid && n2_valid)
     {
         // keep both: mutate using n1
-        node = ast_node_new(JNT_AMBIGUOUS);
+        node = ast_node_new(parser->ast_arena, JNT_AMBIGUOUS);
         tree_node_add_child(node, n1);
         tree_node_add_child(node, n2);
 
         // convergence test
-        if (parser_1->lexer->buffer->cur != parser_2->lexer->buffer->cur)
+        if (end_1.cur != end_2.cur)
         {
-            parser_error(parser, JAVA_E_AMBIGUITY_DIVERGE, *(parser_1->lexer->buffer->cur), *(parser_2->lexer->buffer->cur));
+            parser_error(parser, JAVA_E_AMBIGUITY_DIVERGE, *(end_1.cur), *(end_2.cur));
         }
 
         // cache the ambiguity error entry in node
@@ -247,7 +252,6 @@ static tree_node* parse_binary_ambiguity(
          * keep n2
         */
         node = n2;
-        tree_node_delete(n1);
         error_logger_ambiguity_resolve(logger, entry_amb, 1);
         // assert(error_logger_get_current_top(logger) != entry_amb);
     }
@@ -261,22 +265,12 @@ static tree_node* parse_binary_ambiguity(
          * keep n1
         */
         node = n1;
-        tree_node_delete(n2);
         error_logger_ambiguity_resolve(logger, entry_amb, 0);
         // assert(error_logger_get_current_top(logger) != entry_amb);
     }
 
-    // mutate parser accordingly
-    if (node->type != JNT_AMBIGUOUS)
-    {
-        mutate_parser(parser, node == n1 ? parser_1 : parser_2);
-    }
-
-    // delete parser instance copy
-    release_parser(parser_1);
-    release_parser(parser_2);
-    free(parser_1);
-    free(parser_2);
+    // roll parser forward accordingly
+    parser_checkpoint_restore(parser, node == n2 ? &end_2 : &end_1);
 
     return node;
 }
@@ -353,7 +347,7 @@ static tree_node* parse_expression(java_parser* parser);
 void parse(java_parser* parser)
 {
     bool loop_continue;
-    parser->ast_root = ast_node_new(JNT_UNIT);
+    parser->ast_root = ast_node_new(parser->ast_arena, JNT_UNIT);
 
     // [package declaration]
     if (peek_token_type_is(parser, TOKEN_PEEK_1st, JLT_RWD_PACKAGE))
@@ -411,7 +405,7 @@ void parse(java_parser* parser)
 */
 static tree_node* __parse_name_unit(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_NAME_UNIT);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_NAME_UNIT);
 
     // ID
     consume_token(parser, node->data.id->complex);
@@ -432,7 +426,7 @@ static tree_node* __parse_name_unit(java_parser* parser)
 */
 static tree_node* parse_name(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_NAME);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_NAME);
 
     // Unit
     tree_node_add_child(node, __parse_name_unit(parser));
@@ -457,7 +451,7 @@ static tree_node* parse_name(java_parser* parser)
 */
 static tree_node* __parse_class_type_unit(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_CLASS_TYPE_UNIT);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_CLASS_TYPE_UNIT);
 
     // ID
     consume_token(parser, node->data.id->complex);
@@ -479,7 +473,7 @@ static tree_node* __parse_class_type_unit(java_parser* parser)
 */
 static tree_node* parse_class_type(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_CLASS_TYPE);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_CLASS_TYPE);
 
     // Unit
     tree_node_add_child(node, __parse_class_type_unit(parser));
@@ -504,7 +498,7 @@ static tree_node* parse_class_type(java_parser* parser)
 */
 static tree_node* __parse_interface_type_unit(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_INTERFACE_TYPE_UNIT);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_INTERFACE_TYPE_UNIT);
 
     // ID
     consume_token(parser, node->data.id->complex);
@@ -526,7 +520,7 @@ static tree_node* __parse_interface_type_unit(java_parser* parser)
 */
 static tree_node* parse_interface_type(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_INTERFACE_TYPE);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_INTERFACE_TYPE);
 
     // Unit
     tree_node_add_child(node, __parse_interface_type_unit(parser));
@@ -549,7 +543,7 @@ static tree_node* parse_interface_type(java_parser* parser)
 */
 static tree_node* parse_interface_type_list(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_INTERFACE_TYPE_LIST);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_INTERFACE_TYPE_LIST);
 
     // interface type
     tree_node_add_child(node, parse_interface_type(parser));
@@ -571,7 +565,7 @@ static tree_node* parse_interface_type_list(java_parser* parser)
 */
 static tree_node* parse_package_declaration(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_PKG_DECL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_PKG_DECL);
 
     // package
     consume_token(parser, NULL);
@@ -612,7 +606,7 @@ static tree_node* parse_package_declaration(java_parser* parser)
 */
 static tree_node* parse_import_declaration(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_IMPORT_DECL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_IMPORT_DECL);
 
     // import
     consume_token(parser, NULL);
@@ -661,7 +655,7 @@ static tree_node* parse_import_declaration(java_parser* parser)
 */
 static tree_node* parse_top_level(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_TOP_LEVEL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_TOP_LEVEL);
     java_lexeme_type type;
 
     // {Modifier}
@@ -712,7 +706,7 @@ static tree_node* parse_top_level(java_parser* parser)
 */
 static tree_node* parse_class_declaration(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_CLASS_DECL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_CLASS_DECL);
 
     // class
     consume_token(parser, NULL);
@@ -758,7 +752,7 @@ static tree_node* parse_class_declaration(java_parser* parser)
 */
 static tree_node* parse_interface_declaration(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_INTERFACE_DECL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_INTERFACE_DECL);
 
     // interface
     consume_token(parser, NULL);
@@ -799,7 +793,7 @@ static tree_node* parse_interface_declaration(java_parser* parser)
 */
 static tree_node* parse_class_extends(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_CLASS_EXTENDS);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_CLASS_EXTENDS);
 
     // extends
     consume_token(parser, NULL);
@@ -823,7 +817,7 @@ static tree_node* parse_class_extends(java_parser* parser)
 */
 static tree_node* parse_class_implements(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_CLASS_IMPLEMENTS);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_CLASS_IMPLEMENTS);
 
     // implements
     consume_token(parser, NULL);
@@ -852,7 +846,7 @@ static tree_node* parse_class_implements(java_parser* parser)
 */
 static tree_node* parse_class_body(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_CLASS_BODY);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_CLASS_BODY);
     java_token* peek;
 
     // {
@@ -890,7 +884,7 @@ static tree_node* parse_class_body(java_parser* parser)
 */
 static tree_node* parse_interface_extends(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_INTERFACE_EXTENDS);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_INTERFACE_EXTENDS);
 
     // extends
     consume_token(parser, NULL);
@@ -915,7 +909,7 @@ static tree_node* parse_interface_extends(java_parser* parser)
 */
 static tree_node* parse_interface_body(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_INTERFACE_BODY);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_INTERFACE_BODY);
     java_token* peek;
 
     // {
@@ -972,7 +966,7 @@ static tree_node* parse_interface_body(java_parser* parser)
 */
 static tree_node* parse_interface_body_declaration(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_INTERFACE_BODY_DECL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_INTERFACE_BODY_DECL);
     java_lexeme_type type;
 
     // {Modifier}, still ambiguous
@@ -1085,7 +1079,7 @@ static tree_node* parse_interface_body_declaration(java_parser* parser)
 */
 static tree_node* parse_class_body_declaration(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_CLASS_BODY_DECL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_CLASS_BODY_DECL);
     java_lexeme_type type;
 
     // StaticInitializer
@@ -1182,7 +1176,7 @@ static tree_node* parse_class_body_declaration(java_parser* parser)
 */
 static tree_node* parse_static_initializer(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATIC_INIT);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATIC_INIT);
 
     // static
     consume_token(parser, NULL);
@@ -1208,7 +1202,7 @@ static tree_node* parse_static_initializer(java_parser* parser)
 */
 static tree_node* parse_block(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_BLOCK);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_BLOCK);
     tree_node* statement = NULL;
 
     // {
@@ -1219,14 +1213,9 @@ static tree_node* parse_block(java_parser* parser)
     {
         statement = parse_statement(parser);
 
-        if (statement->type == JNT_STATEMENT_EMPTY)
-        {
-            // prune empty statements
-            tree_node_delete(node);
-        }
-        else
+        // prune empty statements, accept others
+        if (statement->type != JNT_STATEMENT_EMPTY)
         {
-            // accept others
             tree_node_add_child(node, statement);
         }
     }
@@ -1303,7 +1292,7 @@ static tree_node* parse_statement(java_parser* parser)
     switch (peek_token_type(parser, TOKEN_PEEK_1st))
     {
         case JLT_SYM_SEMICOLON:
-            node = ast_node_new(JNT_STATEMENT_EMPTY);
+            node = ast_node_new(parser->ast_arena, JNT_STATEMENT_EMPTY);
             consume_token(parser, NULL); // ;
             return node;
         case JLT_SYM_BRACE_OPEN:
@@ -1388,7 +1377,7 @@ static tree_node* parse_statement(java_parser* parser)
         parser_error(parser, JAVA_E_STATEMENT_UNRECOGNIZED);
 
         // by default we return an ill-formed node
-        return ast_node_new(JNT_STATEMENT);
+        return ast_node_new(parser->ast_arena, JNT_STATEMENT);
     }
 }
 
@@ -1405,7 +1394,7 @@ static tree_node* parse_statement(java_parser* parser)
 */
 static tree_node* parse_expression_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_EXPRESSION);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_EXPRESSION);
 
     // Expression
     tree_node_add_child(node, parse_expression(parser));
@@ -1429,7 +1418,7 @@ static tree_node* parse_expression_statement(java_parser* parser)
 */
 static tree_node* parse_local_variable_declaration(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_LOCAL_VAR_DECL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_LOCAL_VAR_DECL);
 
     // Type
     tree_node_add_child(node, parse_type(parser));
@@ -1453,7 +1442,7 @@ static tree_node* parse_local_variable_declaration(java_parser* parser)
 */
 static tree_node* parse_local_variable_declaration_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_VAR_DECL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_VAR_DECL);
 
     // LocalVariableDeclaration
     tree_node_add_child(node, parse_local_variable_declaration(parser));
@@ -1517,7 +1506,7 @@ static tree_node* parse_local_variable_declaration_statement(java_parser* parser
 */
 static tree_node* parse_switch_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_SWITCH);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_SWITCH);
     java_lexeme_type peek;
 
     // switch
@@ -1620,7 +1609,7 @@ static tree_node* parse_switch_statement(java_parser* parser)
 */
 static tree_node* parse_do_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_DO);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_DO);
 
     // do
     consume_token(parser, NULL);
@@ -1699,7 +1688,7 @@ static tree_node* parse_do_statement(java_parser* parser)
 */
 static tree_node* parse_break_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_BREAK);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_BREAK);
 
     // break
     consume_token(parser, NULL);
@@ -1729,7 +1718,7 @@ static tree_node* parse_break_statement(java_parser* parser)
 */
 static tree_node* parse_continue_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_CONTINUE);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_CONTINUE);
 
     // continue
     consume_token(parser, NULL);
@@ -1759,7 +1748,7 @@ static tree_node* parse_continue_statement(java_parser* parser)
 */
 static tree_node* parse_return_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_RETURN);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_RETURN);
 
     // return
     consume_token(parser, NULL);
@@ -1789,7 +1778,7 @@ static tree_node* parse_return_statement(java_parser* parser)
 */
 static tree_node* parse_synchronized_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_THROW);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_THROW);
 
     // throw
     consume_token(parser, NULL);
@@ -1847,7 +1836,7 @@ static tree_node* parse_synchronized_statement(java_parser* parser)
 */
 static tree_node* parse_throw_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_THROW);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_THROW);
 
     // throw
     consume_token(parser, NULL);
@@ -1887,7 +1876,7 @@ static tree_node* parse_throw_statement(java_parser* parser)
 */
 static tree_node* parse_try_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_TRY);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_TRY);
 
     // try
     consume_token(parser, NULL);
@@ -1936,7 +1925,7 @@ static tree_node* parse_try_statement(java_parser* parser)
 */
 static tree_node* parse_if_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_IF);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_IF);
 
     // if
     consume_token(parser, NULL);
@@ -2014,7 +2003,7 @@ static tree_node* parse_if_statement(java_parser* parser)
 */
 static tree_node* parse_while_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_WHILE);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_WHILE);
 
     // while
     consume_token(parser, NULL);
@@ -2072,7 +2061,7 @@ static tree_node* parse_while_statement(java_parser* parser)
 */
 static tree_node* parse_for_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_FOR);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_FOR);
 
     // for
     consume_token(parser, NULL);
@@ -2159,7 +2148,7 @@ static tree_node* parse_for_statement(java_parser* parser)
 */
 static tree_node* parse_label_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_LABEL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_LABEL);
 
     // ID :
     consume_token(parser, node->data.id->complex);
@@ -2184,7 +2173,7 @@ static tree_node* parse_label_statement(java_parser* parser)
 */
 static tree_node* parse_catch_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_CATCH);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_CATCH);
 
     // catch
     consume_token(parser, NULL);
@@ -2242,7 +2231,7 @@ static tree_node* parse_catch_statement(java_parser* parser)
 */
 static tree_node* parse_finally_statement(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_STATEMENT_FINALLY);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_STATEMENT_FINALLY);
 
     // finally
     consume_token(parser, NULL);
@@ -2274,7 +2263,7 @@ static tree_node* parse_finally_statement(java_parser* parser)
 */
 static tree_node* parse_switch_label(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_SWITCH_LABEL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_SWITCH_LABEL);
 
     // case/default
     node->data.switch_label->is_default = peek_token_type_is(parser, TOKEN_PEEK_1st, JLT_RWD_DEFAULT);
@@ -2314,7 +2303,7 @@ static tree_node* parse_switch_label(java_parser* parser)
 */
 static tree_node* parse_expression_list(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_EXPRESSION_LIST);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_EXPRESSION_LIST);
 
     // Expression
     tree_node_add_child(node, parse_expression(parser));
@@ -2350,7 +2339,7 @@ static tree_node* parse_expression_list(java_parser* parser)
 */
 static tree_node* parse_for_init(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_FOR_INIT);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_FOR_INIT);
 
     // optimization: for some cases, trigger will not cause ambiguity
     if (peek_token_is_primitive_type(parser, TOKEN_PEEK_1st))
@@ -2374,7 +2363,7 @@ static tree_node* parse_for_init(java_parser* parser)
 */
 static tree_node* parse_for_update(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_FOR_UPDATE);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_FOR_UPDATE);
 
     // StatementExpressionList
     tree_node_add_child(node, parse_expression_list(parser));
@@ -2388,7 +2377,7 @@ static tree_node* parse_for_update(java_parser* parser)
 */
 static tree_node* parse_constructor_declaration(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_CTOR_DECL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_CTOR_DECL);
 
     // ID (
     consume_token(parser, node->data.declarator->id.complex);
@@ -2451,7 +2440,7 @@ static tree_node* parse_constructor_declaration(java_parser* parser)
 */
 static tree_node* parse_type(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_TYPE);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_TYPE);
 
     /**
      * We need to directly accept without checking at the
@@ -2516,7 +2505,7 @@ static tree_node* parse_type(java_parser* parser)
 */
 static tree_node* parse_method_header(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_METHOD_HEADER);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_METHOD_HEADER);
 
     // ID (
     consume_token(parser, node->data.declarator->id.complex);
@@ -2575,7 +2564,7 @@ static tree_node* parse_method_header(java_parser* parser)
 */
 static tree_node* parse_method_declaration(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_METHOD_DECL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_METHOD_DECL);
 
     // MethodHeader
     tree_node_add_child(node, parse_method_header(parser));
@@ -2599,7 +2588,7 @@ static tree_node* parse_method_declaration(java_parser* parser)
 */
 static tree_node* parse_variable_declarators(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_VAR_DECLARATORS);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_VAR_DECLARATORS);
 
     // VariableDeclarator
     tree_node_add_child(node, parse_variable_declarator(parser));
@@ -2628,7 +2617,7 @@ static tree_node* parse_variable_declarators(java_parser* parser)
 */
 static tree_node* parse_formal_parameter_list(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_FORMAL_PARAM_LIST);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_FORMAL_PARAM_LIST);
 
     // FormalParameter
     tree_node_add_child(node, parse_formal_parameter(parser));
@@ -2658,7 +2647,7 @@ static tree_node* parse_formal_parameter_list(java_parser* parser)
 */
 static tree_node* parse_formal_parameter(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_FORMAL_PARAM);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_FORMAL_PARAM);
 
     // Type
     tree_node_add_child(node, parse_type(parser));
@@ -2710,7 +2699,7 @@ static tree_node* parse_formal_parameter(java_parser* parser)
 */
 static tree_node* parse_throws(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_THROWS);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_THROWS);
 
     // throws
     consume_token(parser, NULL);
@@ -2745,7 +2734,7 @@ static tree_node* parse_throws(java_parser* parser)
 */
 static tree_node* parse_argument_list(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_ARGUMENT_LIST);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_ARGUMENT_LIST);
 
     // Expression
     tree_node_add_child(node, parse_expression(parser));
@@ -2777,7 +2766,7 @@ static tree_node* parse_argument_list(java_parser* parser)
 */
 static tree_node* parse_constructor_body(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_CTOR_BODY);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_CTOR_BODY);
 
     // {
     consume_token(parser, NULL);
@@ -2825,7 +2814,7 @@ static tree_node* parse_constructor_body(java_parser* parser)
 */
 static tree_node* parse_explicit_constructor_invocation(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_CTOR_INVOCATION);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_CTOR_INVOCATION);
 
     // this/super (
     node->data.constructor_invoke->is_super = peek_token_type_is(parser, TOKEN_PEEK_1st, JLT_RWD_SUPER);
@@ -2858,7 +2847,7 @@ static tree_node* parse_explicit_constructor_invocation(java_parser* parser)
 */
 static tree_node* parse_method_body(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_METHOD_BODY);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_METHOD_BODY);
 
     // Block
     switch (peek_token_type(parser, TOKEN_PEEK_1st))
@@ -2892,7 +2881,7 @@ static tree_node* parse_method_body(java_parser* parser)
 */
 static tree_node* parse_variable_declarator(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_VAR_DECL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_VAR_DECL);
 
     // VariableDeclaratorId => ID {[ ]}
     consume_token(parser, node->data.declarator->id.complex);
@@ -2963,7 +2952,7 @@ static tree_node* parse_variable_declarator(java_parser* parser)
 */
 static tree_node* parse_array_initializer(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_ARRAY_INIT);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_ARRAY_INIT);
 
     // {
     consume_token(parser, NULL);
@@ -3022,7 +3011,7 @@ static tree_node* parse_array_initializer(java_parser* parser)
 */
 static tree_node* parse_primary_simple(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_PRIMARY_SIMPLE);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_PRIMARY_SIMPLE);
 
     node->data.id->simple = peek_token_type(parser, TOKEN_PEEK_1st);
     consume_token(parser, NULL);
@@ -3035,7 +3024,7 @@ static tree_node* parse_primary_simple(java_parser* parser)
 */
 static tree_node* parse_primary_complex(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_PRIMARY_COMPLEX);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_PRIMARY_COMPLEX);
 
     // ID
     consume_token(parser, node->data.id->complex);
@@ -3050,7 +3039,7 @@ static tree_node* parse_primary_complex(java_parser* parser)
 */
 static tree_node* parse_primary_creation(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_PRIMARY_CREATION);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_PRIMARY_CREATION);
 
     // new
     consume_token(parser, NULL);
@@ -3090,7 +3079,7 @@ static tree_node* parse_primary_creation(java_parser* parser)
 */
 static tree_node* parse_primary_array_creation(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_PRIMARY_ARR_CREATION);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_PRIMARY_ARR_CREATION);
     bool first_variadic = true;
     bool accepting_variadic;
 
@@ -3176,7 +3165,7 @@ static tree_node* parse_primary_array_creation(java_parser* parser)
 */
 static tree_node* parse_primary_class_instance_creation(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_PRIMARY_CLS_CREATION);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_PRIMARY_CLS_CREATION);
 
     // (
     consume_token(parser, NULL);
@@ -3216,7 +3205,7 @@ static tree_node* parse_primary_class_instance_creation(java_parser* parser)
 */
 static tree_node* parse_primary_method_invocation(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_PRIMARY_METHOD_INVOKE);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_PRIMARY_METHOD_INVOKE);
 
     // (
     consume_token(parser, NULL);
@@ -3247,7 +3236,7 @@ static tree_node* parse_primary_method_invocation(java_parser* parser)
 */
 static tree_node* parse_primary_array_access(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_PRIMARY_ARR_ACCESS);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_PRIMARY_ARR_ACCESS);
 
     // based on our design rule:
     // this loop is guaranteed to have at least 1 iteration
@@ -3290,7 +3279,7 @@ static tree_node* parse_primary_array_access(java_parser* parser)
 */
 static tree_node* parse_primary_class_literal(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_PRIMARY_CLS_LITERAL);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_PRIMARY_CLS_LITERAL);
 
     consume_token(parser, NULL);
     consume_token(parser, NULL);
@@ -3338,7 +3327,7 @@ static tree_node* parse_primary_class_literal(java_parser* parser)
 */
 static tree_node* parse_primary(java_parser* parser)
 {
-    tree_node* node = ast_node_new(JNT_PRIMARY);
+    tree_node* node = ast_node_new(parser->ast_arena, JNT_PRIMARY);
     tree_node* amb;
     java_lexeme_type peek;
     bool accepting = true;
@@ -3390,7 +3379,6 @@ static tree_node* parse_primary(java_parser* parser)
                 else if (is_lexeme_literal(peek))
                 {
                     // Expression: collapse the JNT_PRIMARY layer as it is unecessary
-                    tree_node_delete(node);
                     node = parse_expression(parser);
                 }
                 else
@@ -3400,7 +3388,6 @@ static tree_node* parse_primary(java_parser* parser)
                     if (amb->type = JNT_EXPRESSION)
                     {
                         // collapse the JNT_PRIMARY layer as it is unecessary
-                        tree_node_delete(node);
                         node = amb;
                     }
                     else
@@ -3629,7 +3616,7 @@ static tree_node* parse_expression(java_parser* parser)
         if (next_is_operator)
         {
             consume_token(parser, NULL); // consume the token
-            expression_worker_push(&worker, expr_opid2node(op_type));
+            expression_worker_push(&worker, expr_opid2node(parser->ast_arena, op_type));
             allow_primary = true;
         }
         else if (allow_primary && parser_trigger_primary(parser, TOKEN_PEEK_1st))
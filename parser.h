@@ -13,10 +13,18 @@
 #define parser_error_missing_token(parser, id, token_name) \
     parser_error(parser, id, token_name, error_logger_get_context_string(parser->logger, id))
 
+/**
+ * Look-ahead ring buffer size, must be power of 2
+ *
+ * it is also the maximum peek depth
+*/
+#define PARSER_LOOKAHEAD_SIZE 8
+
 /**
  * Token Peek Index
  *
- * 4 look-aheads maximum
+ * any index below PARSER_LOOKAHEAD_SIZE can be peeked, these are
+ * the common ones
 */
 
 #define TOKEN_PEEK_1st 0
@@ -24,6 +32,140 @@
 #define TOKEN_PEEK_3rd 2
 #define TOKEN_PEEK_4th 3
 
+/**
+ * Memo table size, must be power of 2
+*/
+#define PARSER_MEMO_SIZE 256
+
+/**
+ * Trigger memo table size, must be power of 2
+*/
+#define PARSER_TRIGGER_MEMO_SIZE 64
+
+struct _java_parser;
+
+typedef tree_node* (*parser_func)(struct _java_parser*);
+
+/**
+ * Parser Checkpoint
+ *
+ * snapshot of parser state that moves forward during parsing, so
+ * speculative parsing can roll back without copying parser or lexer
+ *
+ * lexer->expect is transient so it is not saved
+ *
+ * with a token stream attached, only position is meaningful, and
+ * look-aheads are re-expanded from stream on demand
+*/
+typedef struct
+{
+    /* buffer cursor */
+    byte* cur;
+    /* lexer line info */
+    line ln_cur;
+    line ln_prev;
+    /* look-ahead tokens, in peek order */
+    java_token tokens[PARSER_LOOKAHEAD_SIZE];
+    size_t num_token_available;
+    size_t token_position;
+    /* error stream mark */
+    java_error_stack* stream;
+} parser_checkpoint;
+
+/**
+ * Parser Position
+ *
+ * compact parser state for memo table: lexer state at first
+ * look-ahead, and number of look-aheads; look-aheads themselves are
+ * not kept but read again from there on restore
+ *
+ * with a token stream attached, lexer state is not used
+*/
+typedef struct
+{
+    /* buffer cursor at first look-ahead */
+    byte* cur;
+    /* lexer line info at first look-ahead */
+    line ln_cur;
+    /* lexer ln_prev after look-aheads */
+    line ln_prev;
+    size_t num_token_available;
+    size_t token_position;
+} parser_position;
+
+/**
+ * Memo Table Entry
+ *
+ * result of a production parsed at a token position; only results
+ * without any logged error are kept, so a hit does not need to replay
+ * error entries
+*/
+typedef struct
+{
+    /* production */
+    parser_func func;
+    /* token position: start of first look-ahead */
+    byte* from;
+    /* private copy of the result */
+    tree_node* node;
+    /* parser state after the production */
+    parser_position end;
+} parser_memo_entry;
+
+/**
+ * Parser Trigger Kind
+ *
+ * also the bit index in trigger memo entry
+*/
+typedef enum
+{
+    PARSER_TRIGGER_NAME = 0,
+    PARSER_TRIGGER_CLASS_TYPE,
+    PARSER_TRIGGER_INTERFACE_TYPE,
+    PARSER_TRIGGER_TYPE,
+    PARSER_TRIGGER_PRIMARY,
+    PARSER_TRIGGER_EXPRESSION,
+    PARSER_TRIGGER_STATEMENT,
+
+    PARSER_TRIGGER_MAX,
+} parser_trigger_kind;
+
+/**
+ * Trigger Memo Entry
+ *
+ * trigger results of all kinds for one token position
+*/
+typedef struct
+{
+    /* token position, SIZE_MAX if empty */
+    size_t position;
+    /* bit set if the kind is evaluated */
+    bbit_flag known;
+    /* bit set if the kind is triggered */
+    bbit_flag result;
+} parser_trigger_memo_entry;
+
+/**
+ * Trigger Memo Table
+ *
+ * a trigger depends only on the token at its position, so a result
+ * stays valid after rollback; position is counted in consumed tokens,
+ * so a hit does not even need to peek
+ *
+ * off by default, measured hit rate is low and every trigger is a
+ * single peek; enable it with --memo-triggers
+*/
+typedef struct
+{
+    /* memoization switch */
+    bool enabled;
+    /* statistics */
+    size_t num_hit;
+    size_t num_miss;
+    /* direct-mapped by position */
+    parser_trigger_memo_entry entries[PARSER_TRIGGER_MEMO_SIZE];
+} parser_trigger_memo;
+
 /**
  * Parser Info
  *
@@ -32,18 +174,28 @@
 */
 typedef struct _java_parser
 {
-    /* copy flag */
-    bool is_copy;
-    /* 4 look-ahead tokens */
-    java_token tokens[4];
+    /* look-ahead ring buffer */
+    java_token tokens[PARSER_LOOKAHEAD_SIZE];
+    /* ring index of first look-ahead */
+    size_t token_head;
     /* num look-ahead available */
     size_t num_token_available;
+    /* number of consumed tokens, aka position of first look-ahead */
+    size_t token_position;
     /* lexer */
     java_lexer* lexer;
+    /* pre-tokenized stream, NULL if tokens are lexed on demand */
+    java_token_stream* token_stream;
     /* language spec symbol table*/
     hash_table* reserved_words;
     /* AST */
     tree_node* ast_root;
+    /* AST memory, owned by compiler */
+    arena* ast_arena;
+    /* speculative parsing memo table, allocated from AST arena on demand */
+    parser_memo_entry* memo;
+    /* trigger memo table */
+    parser_trigger_memo trigger_memo;
     /* expression definition */
     java_expression* expression;
     /* error data */
@@ -55,14 +207,20 @@ void init_parser(
     java_lexer* lexer,
     hash_table* rw,
     java_expression* expr,
+    arena* ast_arena,
     java_error_logger* logger
 );
-void copy_parser(java_parser* from, java_parser* to);
-void mutate_parser(java_parser* parser, java_parser* copy);
 void release_parser(java_parser* parser);
+void parser_attach_token_stream(java_parser* parser, java_token_stream* stream);
+void parser_trigger_memo_reset(java_parser* parser, bool enabled);
 
 void parse(java_parser* parser);
 
+void parser_checkpoint_save(java_parser* parser, parser_checkpoint* cp);
+void parser_checkpoint_restore(java_parser* parser, const parser_checkpoint* cp);
+void parser_position_save(java_parser* parser, parser_position* pos);
+void parser_position_restore(java_parser* parser, const parser_position* pos);
+
 java_token* token_peek(java_parser* parser, size_t idx);
 void consume_token(java_parser* parser, java_token* dest);
 java_token_class peek_token_class(java_parser* parser, size_t idx);
@@ -23,6 +23,16 @@ void init_symbol_table(hash_table* table)
     {
         fprintf(stderr, "TODO warning: collision detected: symbol table contains collision");
     }
+
+    for (int i = 0; i < num_java_reserved_words; i++)
+    {
+        char* word = java_reserved_words[i].content;
+
+        if (symbol_lookup_slice((byte*)word, strlen(word)) != &java_reserved_words[i])
+        {
+            fprintf(stderr, "TODO warning: keyword switch out of sync: '%s' not recognized", word);
+        }
+    }
 }
 
 /**
@@ -42,3 +52,211 @@ java_reserved_word* symbol_lookup(hash_table* table, char* string)
 {
     return (java_reserved_word*)shash_table_find(table, string);
 }
+
+/**
+ * candidate check: index into java_reserved_words, first char matched
+*/
+#define SYMBOL_MATCH(idx) \
+    if (memcmp(from + 1, java_reserved_words[idx].content + 1, len - 1) == 0) \
+    { \
+        return &java_reserved_words[idx]; \
+    }
+
+/**
+ * allocation-free symbol lookup on a buffer slice
+ *
+ * dispatch on length, then on first char, so only one or two
+ * candidates are compared (three for length-5 'f'), and first char
+ * never needs comparing again
+ *
+ * the switch is generated from java_reserved_words, indices must be
+ * regenerated when the table changes; init_symbol_table verifies it
+*/
+java_reserved_word* symbol_lookup_slice(const byte* from, size_t len)
+{
+    switch (len)
+    {
+        case 2:
+            switch (from[0])
+            {
+                case 'd':
+                    SYMBOL_MATCH(13); // do
+                    break;
+                case 'i':
+                    SYMBOL_MATCH(10); // if
+                    break;
+            }
+            break;
+        case 3:
+            switch (from[0])
+            {
+                case 'f':
+                    SYMBOL_MATCH(40); // for
+                    break;
+                case 'i':
+                    SYMBOL_MATCH(26); // int
+                    break;
+                case 'n':
+                    SYMBOL_MATCH(41); // new
+                    break;
+                case 't':
+                    SYMBOL_MATCH(23); // try
+                    break;
+            }
+            break;
+        case 4:
+            switch (from[0])
+            {
+                case 'b':
+                    SYMBOL_MATCH(19); // byte
+                    break;
+                case 'c':
+                    SYMBOL_MATCH(24); // case
+                    SYMBOL_MATCH(31); // char
+                    break;
+                case 'e':
+                    SYMBOL_MATCH(20); // else
+                    break;
+                case 'g':
+                    SYMBOL_MATCH(46); // goto
+                    break;
+                case 'l':
+                    SYMBOL_MATCH(33); // long
+                    break;
+                case 'n':
+                    SYMBOL_MATCH(49); // null
+                    break;
+                case 't':
+                    SYMBOL_MATCH(44); // this
+                    SYMBOL_MATCH(47); // true
+                    break;
+                case 'v':
+                    SYMBOL_MATCH(28); // void
+                    break;
+            }
+            break;
+        case 5:
+            switch (from[0])
+            {
+                case 'b':
+                    SYMBOL_MATCH(16); // break
+                    break;
+                case 'c':
+                    SYMBOL_MATCH(29); // catch
+                    SYMBOL_MATCH(36); // class
+                    SYMBOL_MATCH(45); // const
+                    break;
+                case 'f':
+                    SYMBOL_MATCH(3); // final
+                    SYMBOL_MATCH(37); // float
+                    SYMBOL_MATCH(48); // false
+                    break;
+                case 's':
+                    SYMBOL_MATCH(27); // short
+                    SYMBOL_MATCH(34); // super
+                    break;
+                case 't':
+                    SYMBOL_MATCH(11); // throw
+                    break;
+                case 'w':
+                    SYMBOL_MATCH(35); // while
+                    break;
+            }
+            break;
+        case 6:
+            switch (from[0])
+            {
+                case 'd':
+                    SYMBOL_MATCH(17); // double
+                    break;
+                case 'i':
+                    SYMBOL_MATCH(18); // import
+                    break;
+                case 'n':
+                    SYMBOL_MATCH(38); // native
+                    break;
+                case 'p':
+                    SYMBOL_MATCH(0); // public
+                    break;
+                case 'r':
+                    SYMBOL_MATCH(22); // return
+                    break;
+                case 's':
+                    SYMBOL_MATCH(4); // static
+                    SYMBOL_MATCH(39); // switch
+                    break;
+                case 't':
+                    SYMBOL_MATCH(15); // throws
+                    break;
+            }
+            break;
+        case 7:
+            switch (from[0])
+            {
+                case 'b':
+                    SYMBOL_MATCH(12); // boolean
+                    break;
+                case 'd':
+                    SYMBOL_MATCH(9); // default
+                    break;
+                case 'e':
+                    SYMBOL_MATCH(25); // extends
+                    break;
+                case 'f':
+                    SYMBOL_MATCH(32); // finally
+                    break;
+                case 'p':
+                    SYMBOL_MATCH(1); // private
+                    SYMBOL_MATCH(43); // package
+                    break;
+            }
+            break;
+        case 8:
+            switch (from[0])
+            {
+                case 'a':
+                    SYMBOL_MATCH(5); // abstract
+                    break;
+                case 'c':
+                    SYMBOL_MATCH(42); // continue
+                    break;
+                case 'v':
+                    SYMBOL_MATCH(8); // volatile
+                    break;
+            }
+            break;
+        case 9:
+            switch (from[0])
+            {
+                case 'i':
+                    SYMBOL_MATCH(30); // interface
+                    break;
+                case 'p':
+                    SYMBOL_MATCH(2); // protected
+                    break;
+                case 't':
+                    SYMBOL_MATCH(6); // transient
+                    break;
+            }
+            break;
+        case 10:
+            switch (from[0])
+            {
+                case 'i':
+                    SYMBOL_MATCH(14); // implements
+                    SYMBOL_MATCH(21); // instanceof
+                    break;
+            }
+            break;
+        case 12:
+            switch (from[0])
+            {
+                case 's':
+                    SYMBOL_MATCH(7); // synchronized
+                    break;
+            }
+            break;
+    }
+
+    return NULL;
+}
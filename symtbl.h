@@ -29,5 +29,6 @@
 void init_symbol_table(hash_table* table);
 void release_symbol_table(hash_table* table);
 java_reserved_word* symbol_lookup(hash_table* table, char* string);
+java_reserved_word* symbol_lookup_slice(const byte* from, size_t len);
 
 #endif
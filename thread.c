@@ -0,0 +1,125 @@
+#include "thread.h"
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+/**
+ * native entry point, dispatches to routine
+*/
+#if defined(_WIN32)
+static DWORD WINAPI thread_entry(LPVOID arg)
+{
+    thread_handle* t = (thread_handle*)arg;
+
+    t->routine(t->arg);
+    return 0;
+}
+#else
+static void* thread_entry(void* arg)
+{
+    thread_handle* t = (thread_handle*)arg;
+
+    t->routine(t->arg);
+    return NULL;
+}
+#endif
+
+/**
+ * Start a thread
+ *
+ * handle must stay valid until thread_join returns
+*/
+bool thread_start(thread_handle* t, thread_routine routine, void* arg)
+{
+    t->routine = routine;
+    t->arg = arg;
+
+#if defined(_WIN32)
+    t->handle = CreateThread(NULL, 0, thread_entry, t, 0, NULL);
+    return t->handle != NULL;
+#else
+    return pthread_create(&t->handle, NULL, thread_entry, t) == 0;
+#endif
+}
+
+/**
+ * Wait for a thread to finish
+*/
+void thread_join(thread_handle* t)
+{
+#if defined(_WIN32)
+    WaitForSingleObject(t->handle, INFINITE);
+    CloseHandle(t->handle);
+#else
+    pthread_join(t->handle, NULL);
+#endif
+}
+
+/**
+ * Number of logical processors, at least 1
+*/
+size_t thread_hardware_concurrency()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t)n : 1;
+#endif
+}
+
+void init_thread_mutex(thread_mutex* m)
+{
+#if defined(_WIN32)
+    InitializeCriticalSection(&m->handle);
+#else
+    pthread_mutex_init(&m->handle, NULL);
+#endif
+}
+
+void release_thread_mutex(thread_mutex* m)
+{
+#if defined(_WIN32)
+    DeleteCriticalSection(&m->handle);
+#else
+    pthread_mutex_destroy(&m->handle);
+#endif
+}
+
+void thread_mutex_lock(thread_mutex* m)
+{
+#if defined(_WIN32)
+    EnterCriticalSection(&m->handle);
+#else
+    pthread_mutex_lock(&m->handle);
+#endif
+}
+
+void thread_mutex_unlock(thread_mutex* m)
+{
+#if defined(_WIN32)
+    LeaveCriticalSection(&m->handle);
+#else
+    pthread_mutex_unlock(&m->handle);
+#endif
+}
+
+/**
+ * atomic fetch-and-add, returns previous value
+*/
+size_t atomic_size_fetch_add(volatile size_t* p, size_t v)
+{
+#if defined(_WIN32)
+#ifdef COMPILER_64
+    return (size_t)InterlockedExchangeAdd64((volatile LONG64*)p, (LONG64)v);
+#else
+    return (size_t)InterlockedExchangeAdd((volatile LONG*)p, (LONG)v);
+#endif
+#else
+    return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST);
+#endif
+}
@@ -0,0 +1,53 @@
+#pragma once
+#ifndef __COMPILER_THREAD_H__
+#define __COMPILER_THREAD_H__
+
+#include "types.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/**
+ * Minimal Thread Support
+ *
+ * a thin wrapper of platform threads, only covers what compiler
+ * needs: start, join, mutex and atomic counters
+*/
+
+typedef void (*thread_routine)(void* arg);
+
+typedef struct
+{
+#if defined(_WIN32)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    thread_routine routine;
+    void* arg;
+} thread_handle;
+
+typedef struct
+{
+#if defined(_WIN32)
+    CRITICAL_SECTION handle;
+#else
+    pthread_mutex_t handle;
+#endif
+} thread_mutex;
+
+bool thread_start(thread_handle* t, thread_routine routine, void* arg);
+void thread_join(thread_handle* t);
+size_t thread_hardware_concurrency();
+
+void init_thread_mutex(thread_mutex* m);
+void release_thread_mutex(thread_mutex* m);
+void thread_mutex_lock(thread_mutex* m);
+void thread_mutex_unlock(thread_mutex* m);
+
+size_t atomic_size_fetch_add(volatile size_t* p, size_t v);
+
+#endif
@@ -3,81 +3,81 @@
 /**
  * AST node data token allocator
 */
-static inline java_token* __new_node_data_token()
+static inline java_token* __new_node_data_token(arena* a)
 {
-    ALLOCATE(java_token, t);
+    ARENA_ALLOCATE(a, java_token, t);
     init_token(t);
     return t;
 }
 
-static inline node_data_id* __new_node_data_id_simple()
+static inline node_data_id* __new_node_data_id_simple(arena* a)
 {
-    ALLOCATE(node_data_id, d);
+    ARENA_ALLOCATE(a, node_data_id, d);
     d->simple = JLT_MAX;
     return d;
 }
 
-static inline node_data_id* __new_node_data_id_complex()
+static inline node_data_id* __new_node_data_id_complex(arena* a)
 {
-    ALLOCATE(node_data_id, d);
-    d->complex = __new_node_data_token();
+    ARENA_ALLOCATE(a, node_data_id, d);
+    d->complex = __new_node_data_token(a);
     return d;
 }
 
-static inline node_data_import* __new_node_data_import()
+static inline node_data_import* __new_node_data_import(arena* a)
 {
-    ALLOCATE(node_data_import, d);
+    ARENA_ALLOCATE(a, node_data_import, d);
     d->on_demand = false;
     return d;
 }
 
-static inline node_data_top_level* __new_node_data_top_level()
+static inline node_data_top_level* __new_node_data_top_level(arena* a)
 {
-    ALLOCATE(node_data_top_level, d);
+    ARENA_ALLOCATE(a, node_data_top_level, d);
     d->modifier = JLT_UNDEFINED;
     return d;
 }
 
-static inline node_data_declarator* __new_node_data_declarator_simple()
+static inline node_data_declarator* __new_node_data_declarator_simple(arena* a)
 {
-    ALLOCATE(node_data_declarator, d);
+    ARENA_ALLOCATE(a, node_data_declarator, d);
     d->id.simple = JLT_MAX;
     d->dimension = 0;
     return d;
 }
 
-static inline node_data_declarator* __new_node_data_declarator_complex()
+static inline node_data_declarator* __new_node_data_declarator_complex(arena* a)
 {
-    ALLOCATE(node_data_declarator, d);
-    d->id.complex = __new_node_data_token();
+    ARENA_ALLOCATE(a, node_data_declarator, d);
+    d->id.complex = __new_node_data_token(a);
     d->dimension = 0;
     return d;
 }
 
-static inline node_data_expression* __new_node_data_expression()
+static inline node_data_expression* __new_node_data_expression(arena* a)
 {
-    ALLOCATE(node_data_expression, d);
+    ARENA_ALLOCATE(a, node_data_expression, d);
     d->op = OPID_UNDEFINED;
     return d;
 }
 
-static inline node_data_contructor_invoke* __new_node_data_contructor_invoke()
+static inline node_data_contructor_invoke* __new_node_data_contructor_invoke(arena* a)
 {
-    ALLOCATE(node_data_contructor_invoke, d);
+    ARENA_ALLOCATE(a, node_data_contructor_invoke, d);
     d->is_super = false;
     return d;
 }
 
-static inline node_data_switch_label* __new_node_data_switch_label()
+static inline node_data_switch_label* __new_node_data_switch_label(arena* a)
 {
-    ALLOCATE(node_data_switch_label, d);
+    ARENA_ALLOCATE(a, node_data_switch_label, d);
     d->is_default = false;
     return d;
 }
 
-static inline node_data_ambiguity* __new_node_data_ambiguity()
+static inline node_data_ambiguity* __new_node_data_ambiguity(arena* a)
 {
-    ALLOCATE(node_data_ambiguity, d);
+    ARENA_ALLOCATE(a, node_data_ambiguity, d);
     d->error = NULL;
     return d;
 }
@@ -86,7 +86,7 @@ static inline node_data_ambiguity* __new_node_data_ambiguity()
  * AST node data generator
  *
 */
-static void init_node_data(tree_node* node)
+static void init_node_data(arena* a, tree_node* node)
 {
     switch (node->type)
     {
@@ -99,40 +99,40 @@ static void init_node_data(tree_node* node)
         case JNT_STATEMENT_BREAK:
         case JNT_STATEMENT_CONTINUE:
         case JNT_STATEMENT_LABEL:
-            node->data.id = __new_node_data_id_complex();
+            node->data.id = __new_node_data_id_complex(a);
             break;
         case JNT_IMPORT_DECL:
-            node->data.import = __new_node_data_import();
+            node->data.import = __new_node_data_import(a);
             break;
         case JNT_TOP_LEVEL:
         case JNT_INTERFACE_BODY_DECL:
         case JNT_CLASS_BODY_DECL:
-            node->data.top_level = __new_node_data_top_level();
+            node->data.top_level = __new_node_data_top_level(a);
             break;
         case JNT_CTOR_DECL:
         case JNT_METHOD_HEADER:
         case JNT_FORMAL_PARAM:
         case JNT_VAR_DECL:
-            node->data.declarator = __new_node_data_declarator_complex();
+            node->data.declarator = __new_node_data_declarator_complex(a);
             break;
         case JNT_TYPE:
         case JNT_PRIMARY_ARR_CREATION:
-            node->data.declarator = __new_node_data_declarator_simple();
+            node->data.declarator = __new_node_data_declarator_simple(a);
             break;
         case JNT_PRIMARY_SIMPLE:
-            node->data.id = __new_node_data_id_simple();
+            node->data.id = __new_node_data_id_simple(a);
             break;
         case JNT_EXPRESSION:
-            node->data.expression = __new_node_data_expression();
+            node->data.expression = __new_node_data_expression(a);
             break;
         case JNT_CTOR_INVOCATION:
-            node->data.constructor_invoke = __new_node_data_contructor_invoke();
+            node->data.constructor_invoke = __new_node_data_contructor_invoke(a);
             break;
         case JNT_SWITCH_LABEL:
-            node->data.switch_label = __new_node_data_switch_label();
+            node->data.switch_label = __new_node_data_switch_label(a);
             break;
         case JNT_AMBIGUOUS:
-            node->data.ambiguity = __new_node_data_ambiguity();
+            node->data.ambiguity = __new_node_data_ambiguity(a);
             break;
         default:
             // no-op, hence no data
@@ -141,10 +141,108 @@ static void init_node_data(tree_node* node)
 }
 
 /**
- * Node Data Deleter
+ * init tree node fields
+*/
+void init_tree_node(tree_node* node)
+{
+    memset(node, 0, sizeof(tree_node));
+    node->type = JNT_MAX;
+    node->ambiguous = true;
+}
+
+/**
+ * add a child node to the target node
+ *
+ * NOTE: if node=NULL, child is discarded, and its memory is
+ * reclaimed when arena resets
+*/
+void tree_node_add_child(tree_node* node, tree_node* child)
+{
+    // if child is NULL, tree will be broken, so it is disallowed
+    if (!child) { return; }
+
+    // if node is NULL, discard child
+    if (!node) { return; }
+
+    child->prev_sibling = node->last_child;
+    child->next_sibling = NULL;
+
+    if (node->last_child)
+    {
+        node->last_child->next_sibling = child;
+    }
+    else
+    {
+        node->first_child = child;
+    }
+
+    node->last_child = child;
+    node->ambiguous = node->ambiguous || child->ambiguous;
+}
+
+/**
+ * add a child node as first child to the target node
+ *
+ * NOTE: if node=NULL, child is discarded, and its memory is
+ * reclaimed when arena resets
+*/
+void tree_node_add_first_child(tree_node* node, tree_node* child)
+{
+    // if child is NULL, tree will be broken, so it is disallowed
+    if (!child) { return; }
+
+    // if node is NULL, discard child
+    if (!node) { return; }
+
+    child->prev_sibling = NULL;
+    child->next_sibling = node->first_child;
+
+    if (node->first_child)
+    {
+        node->first_child->prev_sibling = child;
+    }
+    else
+    {
+        node->last_child = child;
+    }
+
+    node->first_child = child;
+    node->ambiguous = node->ambiguous || child->ambiguous;
+}
+
+/**
+ * AST node generator
+ *
+ * node, its data, and tokens within data are all allocated from
+ * arena, so there is no per-node deletion; whole tree goes away
+ * with arena_reset or release_arena
+*/
+tree_node* ast_node_new(arena* a, java_node_query type)
+{
+    ARENA_ALLOCATE(a, tree_node, node);
+
+    // init node
+    init_tree_node(node);
+    node->type = type;
+
+    // init node data
+    init_node_data(a, node);
+
+    return node;
+}
+
+/**
+ * deep copy of a subtree, siblings of node are not copied
+ *
+ * ambiguity data keeps pointing to same error entry
 */
-static void release_node_data(tree_node* node)
+tree_node* tree_node_copy(arena* a, tree_node* node)
 {
+    tree_node* copy = ast_node_new(a, node->type);
+    tree_node* child;
+
+    copy->ambiguous = node->ambiguous;
+
     switch (node->type)
     {
         case JNT_NAME_UNIT:
@@ -156,164 +254,234 @@ static void release_node_data(tree_node* node)
         case JNT_STATEMENT_BREAK:
         case JNT_STATEMENT_CONTINUE:
         case JNT_STATEMENT_LABEL:
-            delete_token(node->data.id->complex);
-            free(node->data.id);
+            *copy->data.id->complex = *node->data.id->complex;
             break;
         case JNT_IMPORT_DECL:
-            free(node->data.import);
+            *copy->data.import = *node->data.import;
             break;
         case JNT_TOP_LEVEL:
         case JNT_INTERFACE_BODY_DECL:
         case JNT_CLASS_BODY_DECL:
-            free(node->data.top_level);
+            *copy->data.top_level = *node->data.top_level;
             break;
         case JNT_CTOR_DECL:
         case JNT_METHOD_HEADER:
         case JNT_FORMAL_PARAM:
         case JNT_VAR_DECL:
-            delete_token(node->data.declarator->id.complex);
-            free(node->data.declarator);
+            *copy->data.declarator->id.complex = *node->data.declarator->id.complex;
+            copy->data.declarator->dimension = node->data.declarator->dimension;
             break;
         case JNT_TYPE:
         case JNT_PRIMARY_ARR_CREATION:
-            free(node->data.declarator);
+            *copy->data.declarator = *node->data.declarator;
             break;
         case JNT_PRIMARY_SIMPLE:
-            free(node->data.id);
+            *copy->data.id = *node->data.id;
             break;
         case JNT_EXPRESSION:
-            free(node->data.expression);
+            *copy->data.expression = *node->data.expression;
             break;
         case JNT_CTOR_INVOCATION:
-            free(node->data.constructor_invoke);
+            *copy->data.constructor_invoke = *node->data.constructor_invoke;
             break;
         case JNT_SWITCH_LABEL:
-            free(node->data.switch_label);
+            *copy->data.switch_label = *node->data.switch_label;
             break;
         case JNT_AMBIGUOUS:
-            free(node->data.ambiguity);
+            *copy->data.ambiguity = *node->data.ambiguity;
             break;
         default:
             // no-op, hence no data
             break;
     }
+
+    for (child = node->first_child; child; child = child->next_sibling)
+    {
+        tree_node_add_child(copy, tree_node_copy(a, child));
+    }
+
+    // adding children may flip the flag, restore it
+    copy->ambiguous = node->ambiguous;
+    return copy;
 }
 
 /**
- * init tree node fields
+ * complex token carried by node data, NULL if none
 */
-void init_tree_node(tree_node* node)
+static java_token* tree_node_token(tree_node* node)
 {
-    memset(node, 0, sizeof(tree_node));
-    node->type = JNT_MAX;
-    node->ambiguous = true;
+    switch (node->type)
+    {
+        case JNT_NAME_UNIT:
+        case JNT_CLASS_TYPE_UNIT:
+        case JNT_INTERFACE_TYPE_UNIT:
+        case JNT_CLASS_DECL:
+        case JNT_INTERFACE_DECL:
+        case JNT_PRIMARY_COMPLEX:
+        case JNT_STATEMENT_BREAK:
+        case JNT_STATEMENT_CONTINUE:
+        case JNT_STATEMENT_LABEL:
+            return node->data.id->complex;
+        case JNT_CTOR_DECL:
+        case JNT_METHOD_HEADER:
+        case JNT_FORMAL_PARAM:
+        case JNT_VAR_DECL:
+            return node->data.declarator->id.complex;
+        default:
+            return NULL;
+    }
 }
 
 /**
- * add a child node to the target node
- *
- * NOTE: if node=NULL, child will be deleted completely
+ * count nodes and tokens of a subtree
 */
-void tree_node_add_child(tree_node* node, tree_node* child)
+static void flat_tree_count(flat_tree* tree, tree_node* node)
 {
-    // if child is NULL, tree will be broken, so it is disallowed
-    if (!child) { return; }
+    tree_node* child;
 
-    // if node is NULL, free child
-    if (!node)
+    tree->num_nodes++;
+    tree->num_tokens += tree_node_token(node) ? 1 : 0;
+
+    for (child = node->first_child; child; child = child->next_sibling)
     {
-        tree_node_delete(child);
-        return;
+        flat_tree_count(tree, child);
     }
+}
 
-    child->prev_sibling = node->last_child;
-    child->next_sibling = NULL;
+/**
+ * copy aux data into flat node
+ *
+ * token is copied into token array, num_tokens is the cursor
+*/
+static void flat_node_copy_data(flat_tree* tree, flat_node* f, tree_node* node)
+{
+    java_token* token = tree_node_token(node);
 
-    if (node->last_child)
+    if (token)
     {
-        node->last_child->next_sibling = child;
+        tree->tokens[tree->num_tokens] = *token;
+        f->data.id.complex = &tree->tokens[tree->num_tokens];
+        tree->num_tokens++;
     }
-    else
+
+    switch (node->type)
     {
-        node->first_child = child;
+        case JNT_IMPORT_DECL:
+            f->data.import = *node->data.import;
+            break;
+        case JNT_TOP_LEVEL:
+        case JNT_INTERFACE_BODY_DECL:
+        case JNT_CLASS_BODY_DECL:
+            f->data.top_level = *node->data.top_level;
+            break;
+        case JNT_CTOR_DECL:
+        case JNT_METHOD_HEADER:
+        case JNT_FORMAL_PARAM:
+        case JNT_VAR_DECL:
+            f->dimension = (uint32_t)node->data.declarator->dimension;
+            break;
+        case JNT_TYPE:
+        case JNT_PRIMARY_ARR_CREATION:
+            f->data.id.simple = node->data.declarator->id.simple;
+            f->dimension = (uint32_t)node->data.declarator->dimension;
+            break;
+        case JNT_PRIMARY_SIMPLE:
+            f->data.id.simple = node->data.id->simple;
+            break;
+        case JNT_EXPRESSION:
+            f->data.expression = *node->data.expression;
+            break;
+        case JNT_CTOR_INVOCATION:
+            f->data.constructor_invoke = *node->data.constructor_invoke;
+            break;
+        case JNT_SWITCH_LABEL:
+            f->data.switch_label = *node->data.switch_label;
+            break;
+        case JNT_AMBIGUOUS:
+            f->data.ambiguity = *node->data.ambiguity;
+            break;
+        default:
+            // no-op, hence no data
+            break;
     }
-
-    node->last_child = child;
-    node->ambiguous = node->ambiguous || child->ambiguous;
 }
 
 /**
- * add a child node as first child to the target node
+ * write subtree in pre-order starting at idx
+ *
+ * recursion goes down children only, siblings are iterated
  *
- * NOTE: if node=NULL, child will be deleted completely
+ * return: index after the subtree
 */
-void tree_node_add_first_child(tree_node* node, tree_node* child)
+static size_t flat_tree_fill(flat_tree* tree, tree_node* node, size_t idx)
 {
-    // if child is NULL, tree will be broken, so it is disallowed
-    if (!child) { return; }
-
-    // if node is NULL, free child
-    if (!node)
-    {
-        tree_node_delete(child);
-        return;
-    }
+    flat_node* f = &tree->nodes[idx];
+    tree_node* child;
+    size_t next = idx + 1;
+    size_t last = idx;
 
-    child->prev_sibling = NULL;
-    child->next_sibling = node->first_child;
+    memset(f, 0, sizeof(flat_node));
+    f->type = (byte)node->type;
+    f->ambiguous = node->ambiguous;
+    flat_node_copy_data(tree, f, node);
 
-    if (node->first_child)
+    for (child = node->first_child; child; child = child->next_sibling)
     {
-        node->first_child->prev_sibling = child;
-    }
-    else
-    {
-        node->last_child = child;
+        last = next;
+        next = flat_tree_fill(tree, child, next);
+
+        if (child->next_sibling)
+        {
+            tree->nodes[last].next_sibling = (uint32_t)(next - last);
+        }
     }
 
-    node->first_child = child;
-    node->ambiguous = node->ambiguous || child->ambiguous;
+    f->last_child = (uint32_t)(last - idx);
+    return next;
+}
+
+/**
+ * init flat tree fields
+*/
+void init_flat_tree(flat_tree* tree)
+{
+    tree->nodes = NULL;
+    tree->num_nodes = 0;
+    tree->tokens = NULL;
+    tree->num_tokens = 0;
 }
 
 /**
- * recursively delete ast and data attached to each node
+ * build flat tree from a tree_node
  *
- * NOTE: always try deletion subtree before attaching, otherwise it will cause avalanche
- * effect
+ * the flat tree does not reference the source tree, but both are
+ * released when arena resets
 */
-void tree_node_delete(tree_node* node)
+void flat_tree_build(flat_tree* tree, arena* a, tree_node* root)
 {
-    if (!node)
+    init_flat_tree(tree);
+
+    if (!root)
     {
         return;
     }
 
-    // go deeper first
-    tree_node_delete(node->first_child);
-
-    // then go to next sibling
-    tree_node_delete(node->next_sibling);
+    flat_tree_count(tree, root);
+    assert(tree->num_nodes <= UINT32_MAX);
 
-    // delete data
-    release_node_data(node);
+    tree->nodes = (flat_node*)arena_alloc(a, sizeof(flat_node) * tree->num_nodes);
+    tree->tokens = tree->num_tokens > 0 ?
+        (java_token*)arena_alloc(a, sizeof(java_token) * tree->num_tokens) : NULL;
 
-    // finally, delete self
-    free(node);
+    // token count is re-accumulated as cursor
+    tree->num_tokens = 0;
+    flat_tree_fill(tree, root, 0);
 }
 
 /**
- * AST node generator
+ * root node, NULL if tree is empty
 */
-tree_node* ast_node_new(java_node_query type)
+flat_node* flat_tree_root(flat_tree* tree)
 {
-    tree_node* node = (tree_node*)malloc_assert(sizeof(tree_node));
-
-    // init node
-    init_tree_node(node);
-    node->type = type;
-
-    // init node data
-    init_node_data(node);
-
-    return node;
+    return tree->num_nodes > 0 ? &tree->nodes[0] : NULL;
 }
@@ -3,6 +3,7 @@
 #define __COMPILER_TREE_H__
 
 #include "types.h"
+#include "arena.h"
 #include "langspec.h"
 #include "lexer.h"
 #include "node.h"
@@ -155,11 +156,98 @@ typedef struct _tree_node
     struct _tree_node* prev_sibling;
 } tree_node;
 
+/**
+ * Aux Data: Flat Node
+ *
+ * same layout as aux data of tree_node, but stored by value;
+ * declarators keep id here and dimension in flat_node
+*/
+typedef union
+{
+    node_data_id id;
+    node_data_import import;
+    node_data_top_level top_level;
+    node_data_expression expression;
+    node_data_contructor_invoke constructor_invoke;
+    node_data_switch_label switch_label;
+    node_data_ambiguity ambiguity;
+} flat_node_data;
+
+/**
+ * Flat AST Node
+ *
+ * read-only image of a tree_node, stored in a contiguous array in
+ * pre-order, so a subtree occupies a continuous range and first child
+ * is always the next element
+ *
+ * links are 32-bit offsets relative to the node itself, 0 means none,
+ * so no base pointer is needed to traverse
+ *
+ * e.g. (same tree as tree_node)
+ *
+ *  index: 0 1 2 3 4 5 6 7 8 9 10 11
+ *  node:  A B G C D H I J E F K  L
+ *
+ * A: last_child=9 (F)
+ * B: next_sibling=2 (C), last_child=1 (G)
+ * D: next_sibling=4 (E), last_child=3 (J)
+*/
+typedef struct
+{
+    /* node type, java_node_query */
+    byte type;
+    /* false if production uniquely determines input */
+    bool ambiguous;
+    /* offset to next sibling */
+    uint32_t next_sibling;
+    /* offset to last child, also tells if node has children */
+    uint32_t last_child;
+    /* array dimension of declarators */
+    uint32_t dimension;
+    /* aux data */
+    flat_node_data data;
+} flat_node;
+
+/**
+ * Flat AST
+ *
+ * nodes and tokens are allocated from arena, so flat tree shares
+ * lifetime with the tree it is built from
+*/
+typedef struct
+{
+    /* pre-order node array, first node is root */
+    flat_node* nodes;
+    size_t num_nodes;
+    /* token array referenced by id data */
+    java_token* tokens;
+    size_t num_tokens;
+} flat_tree;
+
+static inline flat_node* flat_first_child(const flat_node* node)
+{
+    return node->last_child ? (flat_node*)node + 1 : NULL;
+}
+
+static inline flat_node* flat_last_child(const flat_node* node)
+{
+    return node->last_child ? (flat_node*)node + node->last_child : NULL;
+}
+
+static inline flat_node* flat_next_sibling(const flat_node* node)
+{
+    return node->next_sibling ? (flat_node*)node + node->next_sibling : NULL;
+}
+
 void init_tree_node(tree_node* node);
 void tree_node_add_child(tree_node* node, tree_node* child);
 void tree_node_add_first_child(tree_node* node, tree_node* child);
-void tree_node_delete(tree_node* node);
 
-tree_node* ast_node_new(java_node_query type);
+tree_node* ast_node_new(arena* a, java_node_query type);
+tree_node* tree_node_copy(arena* a, tree_node* node);
+
+void init_flat_tree(flat_tree* tree);
+void flat_tree_build(flat_tree* tree, arena* a, tree_node* root);
+flat_node* flat_tree_root(flat_tree* tree);
 
 #endif
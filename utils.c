@@ -1,5 +1,12 @@
 #include "utils.h"
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define UTILS_CPU_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
 bool is_prime(unsigned int n)
 {
     for (int i = 2; i <= n / 2; i++)
@@ -58,3 +65,70 @@ size_t find_next_pow2_size(size_t v)
     return find_next_pow2_32(v);
 #endif
 }
+
+/**
+ * CPU Feature Detection
+ *
+ * results are cached, benign race: every thread computes the same value
+ *
+ * MSVC reads CPUID directly, GCC and clang use their builtins;
+ * any other compiler or architecture reports no support
+*/
+bool cpu_has_sse2()
+{
+    static volatile int has = -1;
+
+    if (has < 0)
+    {
+#if defined(UTILS_CPU_X86) && defined(_MSC_VER)
+        int info[4];
+
+        __cpuid(info, 1);
+        has = (info[3] & (1 << 26)) != 0;
+#elif defined(UTILS_CPU_X86) && defined(__GNUC__)
+        __builtin_cpu_init();
+        has = __builtin_cpu_supports("sse2") != 0;
+#else
+        has = 0;
+#endif
+    }
+
+    return has > 0;
+}
+
+/**
+ * AVX2 needs both CPU and OS (YMM state saving) support
+*/
+bool cpu_has_avx2()
+{
+    static volatile int has = -1;
+
+    if (has < 0)
+    {
+#if defined(UTILS_CPU_X86) && defined(_MSC_VER)
+        int info[4];
+
+        __cpuid(info, 0);
+        has = 0;
+
+        if (info[0] >= 7)
+        {
+            // OSXSAVE and AVX, then YMM state enabled in XCR0
+            __cpuid(info, 1);
+
+            if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6)
+            {
+                __cpuidex(info, 7, 0);
+                has = (info[1] & (1 << 5)) != 0;
+            }
+        }
+#elif defined(UTILS_CPU_X86) && defined(__GNUC__)
+        __builtin_cpu_init();
+        has = __builtin_cpu_supports("avx2") != 0;
+#else
+        has = 0;
+#endif
+    }
+
+    return has > 0;
+}
@@ -9,5 +9,7 @@ unsigned int find_next_prime(unsigned int n);
 uint32_t find_next_pow2_32(uint32_t v);
 uint64_t find_next_pow2_64(uint64_t v);
 size_t find_next_pow2_size(size_t v);
+bool cpu_has_sse2();
+bool cpu_has_avx2();
 
 #endif